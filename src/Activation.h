@@ -0,0 +1,179 @@
+#ifndef _ACTIVATION_H
+#define _ACTIVATION_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        Activation.h
+// Description: The set of neuron activation functions.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include "Genes.h"
+
+namespace NEAT
+{
+
+/////////////////////////////////////
+// The set of activation functions //
+/////////////////////////////////////
+
+
+inline double af_sigmoid_unsigned(double aX, double aSlope, double aShift)
+{
+    return 1.0 / (1.0 + exp( - aSlope * aX - aShift));
+}
+
+inline double af_sigmoid_signed(double aX, double aSlope, double aShift)
+{
+    double tY = af_sigmoid_unsigned(aX, aSlope, aShift);
+    return (tY - 0.5) * 2.0;
+}
+
+inline double af_tanh(double aX, double aSlope, double aShift)
+{
+    return tanh(aX * aSlope);
+}
+
+inline double af_tanh_cubic(double aX, double aSlope, double aShift)
+{
+    return tanh(aX * aX * aX * aSlope);
+}
+
+inline double af_step_signed(double aX, double aShift)
+{
+    double tY;
+    if (aX > aShift)
+    {
+        tY = 1.0;
+    }
+    else
+    {
+        tY = -1.0;
+    }
+
+    return tY;
+}
+
+inline double af_step_unsigned(double aX, double aShift)
+{
+    if (aX > (0.5+aShift))
+    {
+        return 1.0;
+    }
+    else
+    {
+        return 0.0;
+    }
+}
+
+inline double af_gauss_signed(double aX, double aSlope, double aShift)
+{
+    double tY = exp( - aSlope * aX * aX + aShift); // TODO: Need separate a, b per activation function
+    return (tY-0.5)*2.0;
+}
+
+inline double af_gauss_unsigned(double aX, double aSlope, double aShift)
+{
+    return exp( - aSlope * aX * aX + aShift);
+}
+
+inline double af_abs(double aX, double aShift)
+{
+    return ((aX + aShift)< 0.0)? -(aX + aShift): (aX + aShift);
+}
+
+inline double af_sine_signed(double aX, double aFreq, double aShift)
+{
+    return sin(aX * aFreq + aShift);
+}
+
+inline double af_sine_unsigned(double aX, double aFreq, double aShift)
+{
+    double tY = sin((aX * aFreq + aShift) );
+    return (tY + 1.0) / 2.0;
+}
+
+
+inline double af_linear(double aX, double aShift)
+{
+    return (aX + aShift);
+}
+
+
+inline double af_relu(double aX)
+{
+    return (aX > 0)?aX:0;
+}
+
+
+inline double af_softplus(double aX)
+{
+    return log(1 + exp(aX));
+}
+
+
+// Applies the activation function of the given type to a single value.
+// A is usually the slope and B the shift (see NeuronGene for details).
+inline double Activation(ActivationFunction a_Type, double aX, double aA, double aB)
+{
+    switch (a_Type)
+    {
+    case SIGNED_SIGMOID:
+        return af_sigmoid_signed(aX, aA, aB);
+    case UNSIGNED_SIGMOID:
+        return af_sigmoid_unsigned(aX, aA, aB);
+    case TANH:
+        return af_tanh(aX, aA, aB);
+    case TANH_CUBIC:
+        return af_tanh_cubic(aX, aA, aB);
+    case SIGNED_STEP:
+        return af_step_signed(aX, aB);
+    case UNSIGNED_STEP:
+        return af_step_unsigned(aX, aB);
+    case SIGNED_GAUSS:
+        return af_gauss_signed(aX, aA, aB);
+    case UNSIGNED_GAUSS:
+        return af_gauss_unsigned(aX, aA, aB);
+    case ABS:
+        return af_abs(aX, aB);
+    case SIGNED_SINE:
+        return af_sine_signed(aX, aA, aB);
+    case UNSIGNED_SINE:
+        return af_sine_unsigned(aX, aA, aB);
+    case LINEAR:
+        return af_linear(aX, aB);
+    case RELU:
+        return af_relu(aX);
+    case SOFTPLUS:
+        return af_softplus(aX);
+    default:
+        return af_sigmoid_unsigned(aX, aA, aB);
+    }
+}
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,358 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ActivationKernels.cpp
+// Description: Scalar and SSE2 span kernels and the runtime dispatch.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <stdint.h>
+#include "ActivationKernels.h"
+#include "ActivationKernelsImpl.h"
+#include "Activation.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MULTINEAT_SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+namespace NEAT
+{
+
+namespace kernels
+{
+
+template<class S>
+struct ScalarVec
+{
+    typedef S scalar;
+    typedef S type;
+    typedef bool mask;
+    typedef typename Consts<S>::bits_type bits_type;
+    static const unsigned int W = 1;
+
+    static type load(const S *p) { return *p; }
+    static void store(S *p, type a) { *p = a; }
+    static type set1(S a) { return a; }
+    static type add(type a, type b) { return a + b; }
+    static type sub(type a, type b) { return a - b; }
+    static type mul(type a, type b) { return a * b; }
+    static type div(type a, type b) { return a / b; }
+    static type madd(type a, type b, type c) { return a * b + c; }
+    static type min(type a, type b) { return (a < b) ? a : b; }
+    static type max(type a, type b) { return (a > b) ? a : b; }
+    static mask gt(type a, type b) { return a > b; }
+    static mask lt(type a, type b) { return a < b; }
+    static type select(mask m, type a, type b) { return m ? a : b; }
+    static type neg(type a) { return -a; }
+    static type abs(type a) { return (a < 0) ? -a : a; }
+
+    static type Pow2(type k)
+    {
+        bits_type t_bits;
+        memcpy(&t_bits, &k, sizeof(t_bits));
+        t_bits = (t_bits - Consts<S>::MAGIC_BITS + Consts<S>::EXPONENT_BIAS) << Consts<S>::MANTISSA_BITS;
+        memcpy(&k, &t_bits, sizeof(t_bits));
+        return k;
+    }
+
+    static type FlipIfOdd(type v, type k)
+    {
+        bits_type t_bits;
+        memcpy(&t_bits, &k, sizeof(t_bits));
+        return (t_bits & 1) ? -v : v;
+    }
+};
+
+#ifdef MULTINEAT_SSE2_KERNELS
+
+struct SSE2Double
+{
+    typedef double scalar;
+    typedef __m128d type;
+    typedef __m128d mask;
+    static const unsigned int W = 2;
+
+    static type load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, type a) { _mm_storeu_pd(p, a); }
+    static type set1(double a) { return _mm_set1_pd(a); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm_div_pd(a, b); }
+    static type madd(type a, type b, type c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static type min(type a, type b) { return _mm_min_pd(a, b); }
+    static type max(type a, type b) { return _mm_max_pd(a, b); }
+    static mask gt(type a, type b) { return _mm_cmpgt_pd(a, b); }
+    static mask lt(type a, type b) { return _mm_cmplt_pd(a, b); }
+    static type select(mask m, type a, type b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+    static type neg(type a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    static type abs(type a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+
+    static type Pow2(type k)
+    {
+        __m128i t_bits = _mm_add_epi64(_mm_castpd_si128(k), _mm_set1_epi64x(1023 - Consts<double>::MAGIC_BITS));
+        return _mm_castsi128_pd(_mm_slli_epi64(t_bits, 52));
+    }
+
+    static type FlipIfOdd(type v, type k)
+    {
+        return _mm_xor_pd(v, _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(k), 63)));
+    }
+};
+
+struct SSE2Float
+{
+    typedef float scalar;
+    typedef __m128 type;
+    typedef __m128 mask;
+    static const unsigned int W = 4;
+
+    static type load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, type a) { _mm_storeu_ps(p, a); }
+    static type set1(float a) { return _mm_set1_ps(a); }
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm_div_ps(a, b); }
+    static type madd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static type min(type a, type b) { return _mm_min_ps(a, b); }
+    static type max(type a, type b) { return _mm_max_ps(a, b); }
+    static mask gt(type a, type b) { return _mm_cmpgt_ps(a, b); }
+    static mask lt(type a, type b) { return _mm_cmplt_ps(a, b); }
+    static type select(mask m, type a, type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    static type neg(type a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+    static type abs(type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+    static type Pow2(type k)
+    {
+        __m128i t_bits = _mm_add_epi32(_mm_castps_si128(k), _mm_set1_epi32(127 - Consts<float>::MAGIC_BITS));
+        return _mm_castsi128_ps(_mm_slli_epi32(t_bits, 23));
+    }
+
+    static type FlipIfOdd(type v, type k)
+    {
+        return _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(k), 31)));
+    }
+};
+
+#endif
+
+// The exact functions, one loop per type so the switch stays out of the loop.
+// In single precision they are evaluated in double and rounded.
+template<double (*F)(double, double, double), class S>
+void ExactLoop(const S *a_X, const S *a_A, const S *a_B, unsigned int a_ParamStep,
+               S *a_Y, unsigned int a_Count)
+{
+    for (unsigned int i = 0; i < a_Count; i++)
+    {
+        a_Y[i] = static_cast<S>(F(a_X[i], a_A[i * a_ParamStep], a_B[i * a_ParamStep]));
+    }
+}
+
+inline double ExactSoftplus(double aX, double, double)
+{
+    return af_softplus(aX);
+}
+
+// Returns false if the function is exact in the SIMD kernels as well
+template<class S>
+bool ExactSpan(ActivationFunction a_Type, const S *a_X, const S *a_A, const S *a_B,
+               unsigned int a_ParamStep, S *a_Y, unsigned int a_Count)
+{
+    switch (a_Type)
+    {
+    case SIGNED_SIGMOID:
+        ExactLoop<af_sigmoid_signed>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case TANH:
+        ExactLoop<af_tanh>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case TANH_CUBIC:
+        ExactLoop<af_tanh_cubic>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case SIGNED_GAUSS:
+        ExactLoop<af_gauss_signed>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case UNSIGNED_GAUSS:
+        ExactLoop<af_gauss_unsigned>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case SIGNED_SINE:
+        ExactLoop<af_sine_signed>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case UNSIGNED_SINE:
+        ExactLoop<af_sine_unsigned>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case SOFTPLUS:
+        ExactLoop<ExactSoftplus>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    case SIGNED_STEP:
+    case UNSIGNED_STEP:
+    case ABS:
+    case LINEAR:
+    case RELU:
+        return false;
+    case UNSIGNED_SIGMOID:
+    default:
+        ExactLoop<af_sigmoid_unsigned>(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        return true;
+    }
+}
+
+ActivationKernel DetectKernel()
+{
+#ifdef MULTINEAT_AVX2_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return KERNEL_AVX2;
+    }
+#endif
+#ifdef MULTINEAT_SSE2_KERNELS
+    return KERNEL_SSE2;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+ActivationKernel &CurrentKernel()
+{
+    static ActivationKernel t_kernel = BestActivationKernel();
+    return t_kernel;
+}
+
+template<class S>
+void Dispatch(ActivationFunction a_Type, const S *a_X, const S *a_A, const S *a_B,
+              unsigned int a_ParamStep, S *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy)
+{
+    if ((a_Accuracy == ACTIVATION_EXACT) && ExactSpan(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count))
+    {
+        return;
+    }
+
+    switch (CurrentKernel())
+    {
+    case KERNEL_AVX2:
+        ActivateSpanAVX2(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case KERNEL_SSE2:
+        ActivateSpanSSE2(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    default:
+        ActivateSpanScalar(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    }
+}
+
+} // namespace kernels
+
+void ActivateSpanScalar(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                        unsigned int a_ParamStep, double *a_Y, unsigned int a_Count)
+{
+    kernels::ActivateSpanV<kernels::ScalarVec<double> >(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+
+void ActivateSpanScalar(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                        unsigned int a_ParamStep, float *a_Y, unsigned int a_Count)
+{
+    kernels::ActivateSpanV<kernels::ScalarVec<float> >(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+
+void ActivateSpanSSE2(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                      unsigned int a_ParamStep, double *a_Y, unsigned int a_Count)
+{
+#ifdef MULTINEAT_SSE2_KERNELS
+    kernels::ActivateSpanV<kernels::SSE2Double>(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+#else
+    ActivateSpanScalar(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+#endif
+}
+
+void ActivateSpanSSE2(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                      unsigned int a_ParamStep, float *a_Y, unsigned int a_Count)
+{
+#ifdef MULTINEAT_SSE2_KERNELS
+    kernels::ActivateSpanV<kernels::SSE2Float>(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+#else
+    ActivateSpanScalar(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+#endif
+}
+
+#ifndef MULTINEAT_AVX2_KERNELS
+// built without the AVX2 unit, never selected
+void ActivateSpanAVX2(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                      unsigned int a_ParamStep, double *a_Y, unsigned int a_Count)
+{
+    ActivateSpanSSE2(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+
+void ActivateSpanAVX2(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                      unsigned int a_ParamStep, float *a_Y, unsigned int a_Count)
+{
+    ActivateSpanSSE2(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+#endif
+
+void ActivateSpan(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                  double *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy)
+{
+    kernels::Dispatch(a_Type, a_X, a_A, a_B, 1, a_Y, a_Count, a_Accuracy);
+}
+
+void ActivateSpan(ActivationFunction a_Type, const double *a_X, double a_A, double a_B,
+                  double *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy)
+{
+    kernels::Dispatch(a_Type, a_X, &a_A, &a_B, 0, a_Y, a_Count, a_Accuracy);
+}
+
+void ActivateSpan(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                  float *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy)
+{
+    kernels::Dispatch(a_Type, a_X, a_A, a_B, 1, a_Y, a_Count, a_Accuracy);
+}
+
+void ActivateSpan(ActivationFunction a_Type, const float *a_X, float a_A, float a_B,
+                  float *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy)
+{
+    kernels::Dispatch(a_Type, a_X, &a_A, &a_B, 0, a_Y, a_Count, a_Accuracy);
+}
+
+ActivationKernel BestActivationKernel()
+{
+    static const ActivationKernel t_best = kernels::DetectKernel();
+    return t_best;
+}
+
+ActivationKernel GetActivationKernel()
+{
+    return kernels::CurrentKernel();
+}
+
+void SetActivationKernel(ActivationKernel a_Kernel)
+{
+    kernels::CurrentKernel() = (a_Kernel < BestActivationKernel()) ? a_Kernel : BestActivationKernel();
+}
+
+} // namespace NEAT
@@ -0,0 +1,94 @@
+#ifndef _ACTIVATIONKERNELS_H
+#define _ACTIVATIONKERNELS_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ActivationKernels.h
+// Description: Activation functions applied over contiguous spans of values.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Genes.h"
+
+namespace NEAT
+{
+
+// How the transcendental activation functions are evaluated.
+//
+// ACTIVATION_EXACT gives the same results as the af_* functions in
+// Activation.h, bit for bit (the default).
+//
+// ACTIVATION_FAST replaces exp, sin, tanh and log with SIMD polynomial
+// approximations, typically 5-10x faster. For arguments |a*x + b| < 1e4 the
+// error against the exact functions, divided by max(1, |exact value|), is
+// below 1e-12 for every function (measured maximum ~5e-13, checked by the
+// tests in tests/network). Sine loses accuracy slowly beyond that range, the
+// argument reduction is good to |x| ~ 1e8. Softplus no longer overflows to
+// infinity for large arguments.
+//
+// The step, abs, linear and relu functions are exact in both modes.
+enum ActivationAccuracy
+{
+    ACTIVATION_EXACT = 0,
+    ACTIVATION_FAST
+};
+
+// The instruction set the span kernels run on
+enum ActivationKernel
+{
+    KERNEL_SCALAR = 0,
+    KERNEL_SSE2,
+    KERNEL_AVX2
+};
+
+// a_Y[i] = f(a_X[i]) for i < a_Count, where every value has its own A and B parameters.
+// a_Y may be the same array as a_X.
+void ActivateSpan(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                  double *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy = ACTIVATION_EXACT);
+
+// Same as above, but all values share the same A and B parameters.
+void ActivateSpan(ActivationFunction a_Type, const double *a_X, double a_A, double a_B,
+                  double *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy = ACTIVATION_EXACT);
+
+// Single precision versions. ACTIVATION_EXACT evaluates the af_* functions in double
+// and rounds the result; ACTIVATION_FAST runs twice as many lanes per instruction,
+// with errors of a few float ulps (below 1e-6 for |a*x + b| < 10, the rounding of
+// the argument itself dominates beyond that).
+void ActivateSpan(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                  float *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy = ACTIVATION_EXACT);
+void ActivateSpan(ActivationFunction a_Type, const float *a_X, float a_A, float a_B,
+                  float *a_Y, unsigned int a_Count, ActivationAccuracy a_Accuracy = ACTIVATION_EXACT);
+
+// The best kernel this CPU supports, detected at runtime
+ActivationKernel BestActivationKernel();
+
+// The kernel in use. SetActivationKernel() clamps the request to what the CPU supports,
+// it is meant for testing and benchmarking the different code paths.
+ActivationKernel GetActivationKernel();
+void SetActivationKernel(ActivationKernel a_Kernel);
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ActivationKernelsAVX2.cpp
+// Description: AVX2/FMA span kernels. This file is compiled with -mavx2 -mfma
+//              and only called after the CPU was checked at runtime.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <immintrin.h>
+#include "ActivationKernelsImpl.h"
+
+namespace NEAT
+{
+
+namespace kernels
+{
+
+struct AVX2Double
+{
+    typedef double scalar;
+    typedef __m256d type;
+    typedef __m256d mask;
+    static const unsigned int W = 4;
+
+    static type load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, type a) { _mm256_storeu_pd(p, a); }
+    static type set1(double a) { return _mm256_set1_pd(a); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type div(type a, type b) { return _mm256_div_pd(a, b); }
+    static type madd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+    static type min(type a, type b) { return _mm256_min_pd(a, b); }
+    static type max(type a, type b) { return _mm256_max_pd(a, b); }
+    static mask gt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static mask lt(type a, type b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static type select(mask m, type a, type b) { return _mm256_blendv_pd(b, a, m); }
+    static type neg(type a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static type abs(type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+    static type Pow2(type k)
+    {
+        __m256i t_bits = _mm256_add_epi64(_mm256_castpd_si256(k), _mm256_set1_epi64x(1023 - Consts<double>::MAGIC_BITS));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(t_bits, 52));
+    }
+
+    static type FlipIfOdd(type v, type k)
+    {
+        return _mm256_xor_pd(v, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(k), 63)));
+    }
+};
+
+struct AVX2Float
+{
+    typedef float scalar;
+    typedef __m256 type;
+    typedef __m256 mask;
+    static const unsigned int W = 8;
+
+    static type load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, type a) { _mm256_storeu_ps(p, a); }
+    static type set1(float a) { return _mm256_set1_ps(a); }
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type div(type a, type b) { return _mm256_div_ps(a, b); }
+    static type madd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+    static type min(type a, type b) { return _mm256_min_ps(a, b); }
+    static type max(type a, type b) { return _mm256_max_ps(a, b); }
+    static mask gt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static mask lt(type a, type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static type select(mask m, type a, type b) { return _mm256_blendv_ps(b, a, m); }
+    static type neg(type a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static type abs(type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+    static type Pow2(type k)
+    {
+        __m256i t_bits = _mm256_add_epi32(_mm256_castps_si256(k), _mm256_set1_epi32(127 - Consts<float>::MAGIC_BITS));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(t_bits, 23));
+    }
+
+    static type FlipIfOdd(type v, type k)
+    {
+        return _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(k), 31)));
+    }
+};
+
+} // namespace kernels
+
+void ActivateSpanAVX2(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                      unsigned int a_ParamStep, double *a_Y, unsigned int a_Count)
+{
+    kernels::ActivateSpanV<kernels::AVX2Double>(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+
+void ActivateSpanAVX2(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                      unsigned int a_ParamStep, float *a_Y, unsigned int a_Count)
+{
+    kernels::ActivateSpanV<kernels::AVX2Float>(a_Type, a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+}
+
+} // namespace NEAT
@@ -0,0 +1,444 @@
+#ifndef _ACTIVATIONKERNELSIMPL_H
+#define _ACTIVATIONKERNELSIMPL_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ActivationKernelsImpl.h
+// Description: The span kernels, written once for any vector type.
+//              Only included by the ActivationKernels*.cpp files.
+///////////////////////////////////////////////////////////////////////////////
+
+// A vector type V provides:
+//
+//   typedef scalar (double or float), type, mask
+//   static const unsigned int W (number of lanes)
+//   load, store, set1, add, sub, mul, div, madd (a*b+c), min, max,
+//   gt, lt (masks), select (mask ? a : b), neg, abs,
+//   Pow2(k)        - 2^n, where k = n + Consts::MAGIC() (rounded with the MAGIC trick)
+//   FlipIfOdd(v,k) - -v if n is odd, v otherwise (k as above)
+//
+// Everything here is templated on V. Each translation unit instantiates it
+// with its own vector type, so the AVX2 unit never emits code that could be
+// picked up by the rest of the library on a CPU without AVX2.
+
+#include "Genes.h"
+
+namespace NEAT
+{
+
+// implemented in ActivationKernels.cpp and ActivationKernelsAVX2.cpp.
+// a_ParamStep is 1 if every value has its own A and B, 0 if they are shared.
+void ActivateSpanScalar(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                        unsigned int a_ParamStep, double *a_Y, unsigned int a_Count);
+void ActivateSpanSSE2(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                      unsigned int a_ParamStep, double *a_Y, unsigned int a_Count);
+void ActivateSpanAVX2(ActivationFunction a_Type, const double *a_X, const double *a_A, const double *a_B,
+                      unsigned int a_ParamStep, double *a_Y, unsigned int a_Count);
+
+void ActivateSpanScalar(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                        unsigned int a_ParamStep, float *a_Y, unsigned int a_Count);
+void ActivateSpanSSE2(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                      unsigned int a_ParamStep, float *a_Y, unsigned int a_Count);
+void ActivateSpanAVX2(ActivationFunction a_Type, const float *a_X, const float *a_A, const float *a_B,
+                      unsigned int a_ParamStep, float *a_Y, unsigned int a_Count);
+
+namespace kernels
+{
+
+// The constants that depend on the precision
+template<class S>
+struct Consts;
+
+template<>
+struct Consts<double>
+{
+    typedef long long bits_type;
+
+    // 1.5 * 2^52 - adding it rounds a double to the nearest integer,
+    // which then sits in the low bits of the mantissa
+    static double MAGIC() { return 6755399441055744.0; }
+    static const bits_type MAGIC_BITS = 0x4338000000000000LL;
+    static const int MANTISSA_BITS = 52;
+    static const int EXPONENT_BIAS = 1023;
+
+    // the range where exp() neither overflows nor goes denormal
+    static double EXP_LO() { return -708.0; }
+    static double EXP_HI() { return 708.0; }
+
+    // ln(2) and pi split so that n * the first part is exact (Cody-Waite)
+    static double LN2_A() { return 6.93145751953125e-1; }
+    static double LN2_B() { return 1.42860682030941723212e-6; }
+    static double PI_A() { return 3.14159250259399414062; }
+    static double PI_B() { return 1.509957883172319270672e-7; }
+    static double PI_C() { return 1.07806057163162381058e-14; }
+};
+
+template<>
+struct Consts<float>
+{
+    typedef int bits_type;
+
+    static float MAGIC() { return 12582912.0f; } // 1.5 * 2^23
+    static const bits_type MAGIC_BITS = 0x4B400000;
+    static const int MANTISSA_BITS = 23;
+    static const int EXPONENT_BIAS = 127;
+
+    static float EXP_LO() { return -87.0f; }
+    static float EXP_HI() { return 88.0f; }
+
+    static float LN2_A() { return 0.693359375f; }
+    static float LN2_B() { return -2.12194440e-4f; }
+    static float PI_A() { return 3.140625f; }
+    static float PI_B() { return 9.67502593994140625e-4f; }
+    static float PI_C() { return 1.509957990978376432e-7f; }
+};
+
+template<class V>
+struct Math
+{
+    typedef typename V::type vec;
+    typedef Consts<typename V::scalar> C;
+
+    // exp(z), relative error ~1e-13 in double (degree 10 polynomial on |r| <= ln2/2)
+    static vec Exp(vec z)
+    {
+        z = V::min(V::max(z, V::set1(C::EXP_LO())), V::set1(C::EXP_HI()));
+
+        vec k = V::add(V::mul(z, V::set1(1.4426950408889634)), V::set1(C::MAGIC()));
+        vec n = V::sub(k, V::set1(C::MAGIC()));
+
+        // z - n*ln(2)
+        vec r = V::madd(n, V::set1(-C::LN2_A()), z);
+        r = V::madd(n, V::set1(-C::LN2_B()), r);
+
+        vec p = V::set1(1.0 / 3628800.0);
+        p = V::madd(p, r, V::set1(1.0 / 362880.0));
+        p = V::madd(p, r, V::set1(1.0 / 40320.0));
+        p = V::madd(p, r, V::set1(1.0 / 5040.0));
+        p = V::madd(p, r, V::set1(1.0 / 720.0));
+        p = V::madd(p, r, V::set1(1.0 / 120.0));
+        p = V::madd(p, r, V::set1(1.0 / 24.0));
+        p = V::madd(p, r, V::set1(1.0 / 6.0));
+        p = V::madd(p, r, V::set1(0.5));
+        p = V::madd(p, r, V::set1(1.0));
+        p = V::madd(p, r, V::set1(1.0));
+
+        return V::mul(p, V::Pow2(k));
+    }
+
+    // sin(z), absolute error ~1e-13 in double (degree 17 polynomial on |r| <= pi/2)
+    static vec Sin(vec z)
+    {
+        vec k = V::add(V::mul(z, V::set1(0.31830988618379067154)), V::set1(C::MAGIC()));
+        vec n = V::sub(k, V::set1(C::MAGIC()));
+
+        // z - n*pi
+        vec r = V::madd(n, V::set1(-C::PI_A()), z);
+        r = V::madd(n, V::set1(-C::PI_B()), r);
+        r = V::madd(n, V::set1(-C::PI_C()), r);
+
+        vec r2 = V::mul(r, r);
+        vec p = V::set1(1.0 / 355687428096000.0);
+        p = V::madd(p, r2, V::set1(-1.0 / 1307674368000.0));
+        p = V::madd(p, r2, V::set1(1.0 / 6227020800.0));
+        p = V::madd(p, r2, V::set1(-1.0 / 39916800.0));
+        p = V::madd(p, r2, V::set1(1.0 / 362880.0));
+        p = V::madd(p, r2, V::set1(-1.0 / 5040.0));
+        p = V::madd(p, r2, V::set1(1.0 / 120.0));
+        p = V::madd(p, r2, V::set1(-1.0 / 6.0));
+        p = V::mul(p, r2);
+        p = V::madd(p, r, r);
+
+        // sin(r + n*pi) = (-1)^n sin(r)
+        return V::FlipIfOdd(p, k);
+    }
+
+    // log(1 + u) for u in [0, 1], absolute error ~1e-14.
+    // Uses log(1+u) = 2 atanh(s), s = u / (2 + u) <= 1/3
+    static vec Log1p01(vec u)
+    {
+        vec s = V::div(u, V::add(u, V::set1(2.0)));
+        vec s2 = V::mul(s, s);
+        vec p = V::set1(1.0 / 25.0);
+        p = V::madd(p, s2, V::set1(1.0 / 23.0));
+        p = V::madd(p, s2, V::set1(1.0 / 21.0));
+        p = V::madd(p, s2, V::set1(1.0 / 19.0));
+        p = V::madd(p, s2, V::set1(1.0 / 17.0));
+        p = V::madd(p, s2, V::set1(1.0 / 15.0));
+        p = V::madd(p, s2, V::set1(1.0 / 13.0));
+        p = V::madd(p, s2, V::set1(1.0 / 11.0));
+        p = V::madd(p, s2, V::set1(1.0 / 9.0));
+        p = V::madd(p, s2, V::set1(1.0 / 7.0));
+        p = V::madd(p, s2, V::set1(1.0 / 5.0));
+        p = V::madd(p, s2, V::set1(1.0 / 3.0));
+        p = V::mul(p, s2);
+        p = V::madd(p, s, s);
+        return V::add(p, p);
+    }
+
+    // tanh(z) = (e^2z - 1) / (e^2z + 1), absolute error ~1e-13
+    static vec Tanh(vec z)
+    {
+        z = V::min(V::max(z, V::set1(-20.0)), V::set1(20.0));
+        vec e = Exp(V::add(z, z));
+        return V::div(V::sub(e, V::set1(1.0)), V::add(e, V::set1(1.0)));
+    }
+
+    static vec SigmoidUnsigned(vec x, vec a, vec b)
+    {
+        vec e = Exp(V::sub(V::neg(V::mul(a, x)), b));
+        return V::div(V::set1(1.0), V::add(V::set1(1.0), e));
+    }
+};
+
+//////////////////////////////////////
+// One functor per activation function
+
+template<class V>
+struct SigmoidUnsigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b) { return Math<V>::SigmoidUnsigned(x, a, b); }
+};
+
+template<class V>
+struct SigmoidSigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b)
+    {
+        vec y = Math<V>::SigmoidUnsigned(x, a, b);
+        return V::mul(V::sub(y, V::set1(0.5)), V::set1(2.0));
+    }
+};
+
+template<class V>
+struct Tanh
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec) { return Math<V>::Tanh(V::mul(x, a)); }
+};
+
+template<class V>
+struct TanhCubic
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec) { return Math<V>::Tanh(V::mul(V::mul(V::mul(x, x), x), a)); }
+};
+
+template<class V>
+struct StepSigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec b) { return V::select(V::gt(x, b), V::set1(1.0), V::set1(-1.0)); }
+};
+
+template<class V>
+struct StepUnsigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec b)
+    {
+        return V::select(V::gt(x, V::add(V::set1(0.5), b)), V::set1(1.0), V::set1(0.0));
+    }
+};
+
+template<class V>
+struct GaussUnsigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b) { return Math<V>::Exp(V::add(V::mul(V::mul(V::neg(a), x), x), b)); }
+};
+
+template<class V>
+struct GaussSigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b)
+    {
+        vec y = GaussUnsigned<V>::Eval(x, a, b);
+        return V::mul(V::sub(y, V::set1(0.5)), V::set1(2.0));
+    }
+};
+
+template<class V>
+struct Abs
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec b)
+    {
+        vec t = V::add(x, b);
+        return V::select(V::lt(t, V::set1(0.0)), V::neg(t), t);
+    }
+};
+
+template<class V>
+struct SineSigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b) { return Math<V>::Sin(V::add(V::mul(x, a), b)); }
+};
+
+template<class V>
+struct SineUnsigned
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec a, vec b)
+    {
+        vec y = SineSigned<V>::Eval(x, a, b);
+        return V::div(V::add(y, V::set1(1.0)), V::set1(2.0));
+    }
+};
+
+template<class V>
+struct Linear
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec b) { return V::add(x, b); }
+};
+
+template<class V>
+struct Relu
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec) { return V::select(V::gt(x, V::set1(0.0)), x, V::set1(0.0)); }
+};
+
+// log(1 + e^x) = max(x, 0) + log(1 + e^-|x|)
+template<class V>
+struct Softplus
+{
+    typedef typename V::type vec;
+    static vec Eval(vec x, vec, vec)
+    {
+        vec e = Math<V>::Exp(V::neg(V::abs(x)));
+        return V::add(V::max(x, V::set1(0.0)), Math<V>::Log1p01(e));
+    }
+};
+
+// Applies F over the span, W values at a time. The tail is padded with zeros.
+template<class V, class F>
+void Loop(const typename V::scalar *a_X, const typename V::scalar *a_A, const typename V::scalar *a_B,
+          unsigned int a_ParamStep, typename V::scalar *a_Y, unsigned int a_Count)
+{
+    typedef typename V::scalar S;
+    typedef typename V::type vec;
+    const unsigned int W = V::W;
+    unsigned int i = 0;
+
+    if (a_ParamStep == 0)
+    {
+        vec a = V::set1(a_A[0]);
+        vec b = V::set1(a_B[0]);
+        for (; i + W <= a_Count; i += W)
+        {
+            V::store(a_Y + i, F::Eval(V::load(a_X + i), a, b));
+        }
+    }
+    else
+    {
+        for (; i + W <= a_Count; i += W)
+        {
+            V::store(a_Y + i, F::Eval(V::load(a_X + i), V::load(a_A + i), V::load(a_B + i)));
+        }
+    }
+
+    if (i < a_Count)
+    {
+        S t_x[W], t_a[W], t_b[W], t_y[W];
+        for (unsigned int j = 0; j < W; j++)
+        {
+            bool t_in = (i + j) < a_Count;
+            t_x[j] = t_in ? a_X[i + j] : S(0);
+            t_a[j] = t_in ? a_A[(i + j) * a_ParamStep] : S(0);
+            t_b[j] = t_in ? a_B[(i + j) * a_ParamStep] : S(0);
+        }
+        V::store(t_y, F::Eval(V::load(t_x), V::load(t_a), V::load(t_b)));
+        for (unsigned int j = 0; (i + j) < a_Count; j++)
+        {
+            a_Y[i + j] = t_y[j];
+        }
+    }
+}
+
+template<class V>
+void ActivateSpanV(ActivationFunction a_Type, const typename V::scalar *a_X, const typename V::scalar *a_A,
+                   const typename V::scalar *a_B, unsigned int a_ParamStep, typename V::scalar *a_Y,
+                   unsigned int a_Count)
+{
+    switch (a_Type)
+    {
+    case SIGNED_SIGMOID:
+        Loop<V, SigmoidSigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case TANH:
+        Loop<V, Tanh<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case TANH_CUBIC:
+        Loop<V, TanhCubic<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case SIGNED_STEP:
+        Loop<V, StepSigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case UNSIGNED_STEP:
+        Loop<V, StepUnsigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case SIGNED_GAUSS:
+        Loop<V, GaussSigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case UNSIGNED_GAUSS:
+        Loop<V, GaussUnsigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case ABS:
+        Loop<V, Abs<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case SIGNED_SINE:
+        Loop<V, SineSigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case UNSIGNED_SINE:
+        Loop<V, SineUnsigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case LINEAR:
+        Loop<V, Linear<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case RELU:
+        Loop<V, Relu<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case SOFTPLUS:
+        Loop<V, Softplus<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    case UNSIGNED_SIGMOID:
+    default:
+        Loop<V, SigmoidUnsigned<V> >(a_X, a_A, a_B, a_ParamStep, a_Y, a_Count);
+        break;
+    }
+}
+
+} // namespace kernels
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,1015 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        CompiledNetwork.cpp
+// Description: Implementation of the flat evaluation plan.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include "CompiledNetwork.h"
+#include "NeuralNetwork.h"
+#include "MultiNEATAssert.h"
+
+namespace NEAT
+{
+
+// orders neurons by topological level, then by activation function, then by index
+// (like a stable sort would, but std::sort needs no temporary buffer)
+struct ByLevelAndType
+{
+    const std::vector<Neuron> &m_neurons;
+    const std::vector<unsigned int> &m_level;
+    ByLevelAndType(const std::vector<Neuron> &a_Neurons, const std::vector<unsigned int> &a_Level)
+            : m_neurons(a_Neurons), m_level(a_Level) {}
+
+    bool operator()(unsigned int a_lhs, unsigned int a_rhs) const
+    {
+        if (m_level[a_lhs] != m_level[a_rhs])
+        {
+            return m_level[a_lhs] < m_level[a_rhs];
+        }
+        if (m_neurons[a_lhs].m_activation_function_type != m_neurons[a_rhs].m_activation_function_type)
+        {
+            return m_neurons[a_lhs].m_activation_function_type < m_neurons[a_rhs].m_activation_function_type;
+        }
+        return a_lhs < a_rhs;
+    }
+};
+
+// Networks with at least this many neurons are ordered for locality,
+// smaller ones have all their activations in the L1 cache anyway
+const unsigned int LOCALITY_MIN_NEURONS = 4096;
+
+// A run of rows is summed as a dense block only from this size on,
+// below it the gather of the sparse loop costs about the same
+const unsigned int DENSE_MIN_ROWS = 4;
+const unsigned int DENSE_MIN_WIDTH = 8;
+
+// The columns of a dense block are processed in tiles of this many,
+// so the tile of the input vector stays in the L1 cache while the rows stream past
+const unsigned int DENSE_TILE = 1024;
+
+// a_Y[r] = the sum of a_W[r * a_Width + c] * a_X[c] over c, for every r < a_Rows.
+// Four rows are accumulated at a time, which shares the loads of a_X. Every row
+// is still summed from its first column to its last, the sums are exactly the
+// ones of the sparse loop (which is why the columns are not vectorized).
+template<typename T>
+void DenseMatVec(const T *a_W, unsigned int a_Width, const T *a_X, T *a_Y, unsigned int a_Rows)
+{
+    for (unsigned int c0 = 0; c0 < a_Width; c0 += DENSE_TILE)
+    {
+        const unsigned int c1 = std::min(c0 + DENSE_TILE, a_Width);
+        const bool t_first = (c0 == 0);
+
+        unsigned int r = 0;
+        for (; r + 4 <= a_Rows; r += 4)
+        {
+            const T *t_w0 = a_W + static_cast<size_t>(r) * a_Width;
+            const T *t_w1 = t_w0 + a_Width;
+            const T *t_w2 = t_w1 + a_Width;
+            const T *t_w3 = t_w2 + a_Width;
+
+            T t_s0 = t_first ? 0 : a_Y[r];
+            T t_s1 = t_first ? 0 : a_Y[r + 1];
+            T t_s2 = t_first ? 0 : a_Y[r + 2];
+            T t_s3 = t_first ? 0 : a_Y[r + 3];
+            for (unsigned int c = c0; c < c1; c++)
+            {
+                const T t_x = a_X[c];
+                t_s0 += t_x * t_w0[c];
+                t_s1 += t_x * t_w1[c];
+                t_s2 += t_x * t_w2[c];
+                t_s3 += t_x * t_w3[c];
+            }
+            a_Y[r] = t_s0;
+            a_Y[r + 1] = t_s1;
+            a_Y[r + 2] = t_s2;
+            a_Y[r + 3] = t_s3;
+        }
+        for (; r < a_Rows; r++)
+        {
+            const T *t_w = a_W + static_cast<size_t>(r) * a_Width;
+            T t_s = t_first ? 0 : a_Y[r];
+            for (unsigned int c = c0; c < c1; c++)
+            {
+                t_s += a_X[c] * t_w[c];
+            }
+            a_Y[r] = t_s;
+        }
+    }
+}
+
+// orders neurons by the position of their first placed source, then by the number of sources, then by index
+struct BySourcePosition
+{
+    const std::vector<unsigned int> &m_key;
+    const std::vector<unsigned int> &m_in_start;
+    BySourcePosition(const std::vector<unsigned int> &a_Key, const std::vector<unsigned int> &a_InStart)
+            : m_key(a_Key), m_in_start(a_InStart) {}
+
+    bool operator()(unsigned int a_lhs, unsigned int a_rhs) const
+    {
+        if (m_key[a_lhs] != m_key[a_rhs])
+        {
+            return m_key[a_lhs] < m_key[a_rhs];
+        }
+        unsigned int t_lhs_degree = m_in_start[a_lhs + 1] - m_in_start[a_lhs];
+        unsigned int t_rhs_degree = m_in_start[a_rhs + 1] - m_in_start[a_rhs];
+        if (t_lhs_degree != t_rhs_degree)
+        {
+            return t_lhs_degree < t_rhs_degree;
+        }
+        return a_lhs < a_rhs;
+    }
+};
+
+// Reorders the neurons inside every bucket of a_Public (sorted by level and type)
+// so that the rows of the plan read their activations from nearby places.
+//
+// This is the Cuthill-McKee ordering, restricted to the freedom the plan has:
+// level by level, the neurons of each bucket are sorted by the position of their
+// earliest source that was already placed, and then by degree. Neurons fed by the
+// same region end up next to each other, which makes the adjacency matrix banded.
+// The levels and buckets stay as they are (the reversal of RCM would break the
+// level order), and so do the sums, since every row keeps its connections.
+void OrderForLocality(const std::vector<Neuron> &a_Neurons, const std::vector<Connection> &a_Connections,
+                      unsigned int a_NumInputs, const std::vector<unsigned int> &a_Levels,
+                      std::vector<unsigned int> &a_Public, TopologyScratch &a_Scratch)
+{
+    const unsigned int t_num_neurons = static_cast<unsigned int>(a_Public.size());
+    const unsigned int NOT_PLACED = 0xFFFFFFFF;
+
+    // incoming connections of every neuron
+    std::vector<unsigned int> &t_in_start = a_Scratch.m_in_start;
+    t_in_start.assign(t_num_neurons + 1, 0);
+    for (unsigned int i = 0; i < a_Connections.size(); i++)
+    {
+        if (static_cast<unsigned int>(a_Connections[i].m_target_neuron_idx) >= a_NumInputs)
+        {
+            t_in_start[a_Connections[i].m_target_neuron_idx + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        t_in_start[i + 1] += t_in_start[i];
+    }
+    std::vector<unsigned int> &t_in = a_Scratch.m_in;
+    std::vector<unsigned int> &t_fill = a_Scratch.m_fill;
+    t_in.resize(t_in_start[t_num_neurons]);
+    t_fill.assign(t_in_start.begin(), t_in_start.end() - 1);
+    for (unsigned int i = 0; i < a_Connections.size(); i++)
+    {
+        if (static_cast<unsigned int>(a_Connections[i].m_target_neuron_idx) >= a_NumInputs)
+        {
+            t_in[t_fill[a_Connections[i].m_target_neuron_idx]++] = a_Connections[i].m_source_neuron_idx;
+        }
+    }
+
+    std::vector<unsigned int> &t_key = a_Scratch.m_key;
+    std::vector<unsigned int> &t_rank = a_Scratch.m_rank;
+    t_key.resize(t_num_neurons);
+    t_rank.assign(t_num_neurons, NOT_PLACED);
+    for (unsigned int i = 0; i < a_NumInputs; i++)
+    {
+        t_rank[a_Public[i]] = i;
+    }
+
+    unsigned int t_begin = a_NumInputs;
+    while (t_begin < t_num_neurons)
+    {
+        const unsigned int t_level = a_Levels[a_Public[t_begin]];
+        unsigned int t_end = t_begin;
+        while ((t_end < t_num_neurons) && (a_Levels[a_Public[t_end]] == t_level))
+        {
+            t_end++;
+        }
+
+        // sources in this level or above are not placed yet, they are ignored
+        for (unsigned int i = t_begin; i < t_end; i++)
+        {
+            const unsigned int t_n = a_Public[i];
+            unsigned int t_first = NOT_PLACED;
+            for (unsigned int k = t_in_start[t_n]; k < t_in_start[t_n + 1]; k++)
+            {
+                t_first = std::min(t_first, t_rank[t_in[k]]);
+            }
+            t_key[t_n] = t_first;
+        }
+
+        // every bucket on its own
+        unsigned int t_bucket = t_begin;
+        for (unsigned int i = t_begin + 1; i <= t_end; i++)
+        {
+            if ((i == t_end) || (a_Neurons[a_Public[i]].m_activation_function_type !=
+                                 a_Neurons[a_Public[t_bucket]].m_activation_function_type))
+            {
+                std::sort(a_Public.begin() + t_bucket, a_Public.begin() + i, BySourcePosition(t_key, t_in_start));
+                t_bucket = i;
+            }
+        }
+
+        for (unsigned int i = t_begin; i < t_end; i++)
+        {
+            t_rank[a_Public[i]] = i;
+        }
+        t_begin = t_end;
+    }
+}
+
+// Computes the topological level of every neuron. Inputs are at level 0, any other
+// neuron is one level above the highest of its sources. Connections into inputs
+// are ignored, and so are the connections that close a loop (the back edges of a
+// depth-first search). Returns true if there were no such loops.
+bool TopologicalLevels(const std::vector<Connection> &a_Connections, unsigned int a_NumNeurons,
+                       unsigned int a_NumInputs, std::vector<unsigned int> &a_Levels, TopologyScratch &a_Scratch)
+{
+    // outgoing connections of every neuron
+    std::vector<unsigned int> &t_out_start = a_Scratch.m_out_start;
+    t_out_start.assign(a_NumNeurons + 1, 0);
+    for (unsigned int i = 0; i < a_Connections.size(); i++)
+    {
+        if (static_cast<unsigned int>(a_Connections[i].m_target_neuron_idx) >= a_NumInputs)
+        {
+            t_out_start[a_Connections[i].m_source_neuron_idx + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < a_NumNeurons; i++)
+    {
+        t_out_start[i + 1] += t_out_start[i];
+    }
+    std::vector<unsigned int> &t_out = a_Scratch.m_out;
+    std::vector<unsigned int> &t_fill = a_Scratch.m_fill;
+    t_out.resize(t_out_start[a_NumNeurons]);
+    t_fill.assign(t_out_start.begin(), t_out_start.end() - 1);
+    for (unsigned int i = 0; i < a_Connections.size(); i++)
+    {
+        if (static_cast<unsigned int>(a_Connections[i].m_target_neuron_idx) >= a_NumInputs)
+        {
+            t_out[t_fill[a_Connections[i].m_source_neuron_idx]++] = a_Connections[i].m_target_neuron_idx;
+        }
+    }
+
+    // iterative depth-first search, the reverse postorder is a topological order
+    std::vector<unsigned char> &t_visited = a_Scratch.m_visited;
+    std::vector<unsigned int> &t_order = a_Scratch.m_order;
+    std::vector<std::pair<unsigned int, unsigned int> > &t_stack = a_Scratch.m_stack;
+    t_visited.assign(a_NumNeurons, 0);
+    t_order.clear();
+    t_order.reserve(a_NumNeurons);
+    t_stack.clear();
+    for (unsigned int t_root = 0; t_root < a_NumNeurons; t_root++)
+    {
+        if (t_visited[t_root])
+        {
+            continue;
+        }
+
+        t_visited[t_root] = 1;
+        t_stack.push_back(std::make_pair(t_root, t_out_start[t_root]));
+        while (!t_stack.empty())
+        {
+            std::pair<unsigned int, unsigned int> &t_top = t_stack.back();
+            if (t_top.second < t_out_start[t_top.first + 1])
+            {
+                unsigned int t_next = t_out[t_top.second++];
+                if (!t_visited[t_next])
+                {
+                    t_visited[t_next] = 1;
+                    t_stack.push_back(std::make_pair(t_next, t_out_start[t_next]));
+                }
+            }
+            else
+            {
+                t_order.push_back(t_top.first);
+                t_stack.pop_back();
+            }
+        }
+    }
+    std::reverse(t_order.begin(), t_order.end());
+
+    std::vector<unsigned int> &t_position = a_Scratch.m_position;
+    t_position.resize(a_NumNeurons);
+    for (unsigned int i = 0; i < a_NumNeurons; i++)
+    {
+        t_position[t_order[i]] = i;
+    }
+
+    // push the levels forward in topological order
+    bool t_acyclic = true;
+    a_Levels.assign(a_NumNeurons, 1);
+    for (unsigned int i = 0; (i < a_NumInputs) && (i < a_NumNeurons); i++)
+    {
+        a_Levels[i] = 0;
+    }
+    for (unsigned int i = 0; i < a_NumNeurons; i++)
+    {
+        unsigned int t_src = t_order[i];
+        for (unsigned int k = t_out_start[t_src]; k < t_out_start[t_src + 1]; k++)
+        {
+            unsigned int t_dst = t_out[k];
+            if (t_position[t_dst] <= i)
+            {
+                t_acyclic = false; // closes a loop
+            }
+            else if (a_Levels[t_dst] < a_Levels[t_src] + 1)
+            {
+                a_Levels[t_dst] = a_Levels[t_src] + 1;
+            }
+        }
+    }
+
+    return t_acyclic;
+}
+
+template<typename T>
+BasicCompiledNetwork<T>::BasicCompiledNetwork()
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_batch_size = 0;
+    m_accuracy = ACTIVATION_EXACT;
+    m_feed_forward = true;
+    m_parallel_threshold = 0;
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::SetParallel(const std::shared_ptr<ThreadPool> &a_Pool, unsigned int a_MinConnections)
+{
+    m_pool = a_Pool;
+    m_parallel_threshold = a_MinConnections;
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Clear()
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_public.clear();
+    m_internal.clear();
+    m_bucket_start.clear();
+    m_bucket_type.clear();
+    m_level_start.clear();
+    m_level_bucket.clear();
+    m_feed_forward = true;
+    m_dense.clear();
+    m_row_start.clear();
+    m_source.clear();
+    m_weight.clear();
+    m_hebb_rate.clear();
+    m_hebb_pre_rate.clear();
+    m_connection_slot.clear();
+    m_input_connections.clear();
+    m_act_type.clear();
+    m_a.clear();
+    m_b.clear();
+    m_bias.clear();
+    m_timeconst.clear();
+    m_activesum.clear();
+    m_activation.clear();
+    m_membrane_potential.clear();
+    m_previous.clear();
+    FlushBatch();
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Build(const std::vector<Neuron> &a_Neurons,
+                            const std::vector<Connection> &a_Connections,
+                            unsigned int a_NumInputs, unsigned int a_NumOutputs)
+{
+    const unsigned int t_num_neurons = static_cast<unsigned int>(a_Neurons.size());
+    const unsigned int t_num_conns = static_cast<unsigned int>(a_Connections.size());
+
+    m_num_inputs = a_NumInputs;
+    m_num_outputs = a_NumOutputs;
+
+    // The internal order - inputs stay in front, the rest is sorted by topological
+    // level and then grouped by activation function. The neurons keep their
+    // relative order inside a bucket.
+    std::vector<unsigned int> &t_level = m_scratch_level;
+    m_feed_forward = TopologicalLevels(a_Connections, t_num_neurons, m_num_inputs, t_level, m_scratch);
+
+    std::vector<unsigned int> &t_public = m_scratch_public;
+    t_public.resize(t_num_neurons);
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        t_public[i] = i;
+    }
+    if (m_num_inputs < t_num_neurons)
+    {
+        std::sort(t_public.begin() + m_num_inputs, t_public.end(), ByLevelAndType(a_Neurons, t_level));
+        if (t_num_neurons >= LOCALITY_MIN_NEURONS)
+        {
+            OrderForLocality(a_Neurons, a_Connections, m_num_inputs, t_level, t_public, m_scratch);
+        }
+    }
+
+    // the batch state survives a rebuild only if the neurons are still the same
+    if ((t_public != m_public) ||
+        (m_batch_activation.size() != static_cast<size_t>(t_num_neurons) * m_batch_size))
+    {
+        FlushBatch();
+    }
+
+    m_public = t_public;
+    m_internal.resize(t_num_neurons);
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        m_internal[m_public[i]] = i;
+    }
+
+    // Neuron parameters and state
+    m_act_type.resize(t_num_neurons);
+    m_a.resize(t_num_neurons);
+    m_b.resize(t_num_neurons);
+    m_bias.resize(t_num_neurons);
+    m_timeconst.resize(t_num_neurons);
+    m_activesum.assign(t_num_neurons, 0.0);
+    m_activation.resize(t_num_neurons);
+    m_membrane_potential.resize(t_num_neurons);
+
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        const Neuron &t_n = a_Neurons[m_public[i]];
+        m_act_type[i] = t_n.m_activation_function_type;
+        m_a[i] = t_n.m_a;
+        m_b[i] = t_n.m_b;
+        m_bias[i] = t_n.m_bias;
+        m_timeconst[i] = t_n.m_timeconst;
+        m_activation[i] = t_n.m_activation;
+        m_membrane_potential[i] = t_n.m_membrane_potential;
+    }
+
+    // the levels and the buckets of equal activation functions inside them
+    m_bucket_start.clear();
+    m_bucket_type.clear();
+    m_level_start.clear();
+    m_level_bucket.clear();
+    for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+    {
+        bool t_new_level = (i == m_num_inputs) || (t_level[m_public[i]] != t_level[m_public[i - 1]]);
+        if (t_new_level)
+        {
+            m_level_start.push_back(i);
+            m_level_bucket.push_back(static_cast<unsigned int>(m_bucket_type.size()));
+        }
+        if (t_new_level || (m_act_type[i] != m_act_type[i - 1]))
+        {
+            m_bucket_start.push_back(i);
+            m_bucket_type.push_back(m_act_type[i]);
+        }
+    }
+    m_bucket_start.push_back(t_num_neurons);
+    m_level_start.push_back(t_num_neurons);
+    m_level_bucket.push_back(static_cast<unsigned int>(m_bucket_type.size()));
+
+    // Count the incoming connections of every neuron.
+    // Connections into inputs are dropped, inputs never get activated.
+    m_row_start.assign(t_num_neurons + 1, 0);
+    for (unsigned int i = 0; i < t_num_conns; i++)
+    {
+        unsigned int t_target = a_Connections[i].m_target_neuron_idx;
+        ASSERT(t_target < t_num_neurons);
+        if (t_target >= m_num_inputs)
+        {
+            m_row_start[m_internal[t_target] + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        m_row_start[i + 1] += m_row_start[i];
+    }
+
+    // Stable placement - the connections keep their original order inside each row
+    const unsigned int t_num_slots = m_row_start[t_num_neurons];
+    m_source.resize(t_num_slots);
+    m_weight.resize(t_num_slots);
+    m_hebb_rate.resize(t_num_slots);
+    m_hebb_pre_rate.resize(t_num_slots);
+    m_connection_slot.resize(t_num_conns);
+    m_input_connections.clear();
+
+    std::vector<unsigned int> &t_fill = m_scratch.m_fill;
+    t_fill.assign(m_row_start.begin(), m_row_start.end() - 1);
+    for (unsigned int i = 0; i < t_num_conns; i++)
+    {
+        unsigned int t_target = a_Connections[i].m_target_neuron_idx;
+        if (t_target < m_num_inputs)
+        {
+            m_connection_slot[i] = NO_SLOT;
+            m_input_connections.push_back(i);
+            continue;
+        }
+
+        unsigned int t_slot = t_fill[m_internal[t_target]]++;
+        m_source[t_slot] = m_internal[a_Connections[i].m_source_neuron_idx];
+        m_weight[t_slot] = a_Connections[i].m_weight;
+        m_hebb_rate[t_slot] = a_Connections[i].m_hebb_rate;
+        m_hebb_pre_rate[t_slot] = a_Connections[i].m_hebb_pre_rate;
+        m_connection_slot[i] = t_slot;
+    }
+
+    FindDenseBlocks();
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::FindDenseBlocks()
+{
+    const unsigned int t_num_neurons = NumNeurons();
+    m_dense.clear();
+
+    unsigned int i = m_num_inputs;
+    while (i < t_num_neurons)
+    {
+        const unsigned int t_start = m_row_start[i];
+        const unsigned int t_width = m_row_start[i + 1] - t_start;
+
+        bool t_contiguous = (t_width >= DENSE_MIN_WIDTH);
+        for (unsigned int c = 1; t_contiguous && (c < t_width); c++)
+        {
+            t_contiguous = (m_source[t_start + c] == m_source[t_start] + c);
+        }
+        if (!t_contiguous)
+        {
+            i++;
+            continue;
+        }
+
+        // extend the block over the following rows with the same sources
+        unsigned int t_end = i + 1;
+        while ((t_end < t_num_neurons) &&
+               (m_row_start[t_end + 1] - m_row_start[t_end] == t_width) &&
+               std::equal(&m_source[t_start], &m_source[t_start] + t_width, &m_source[m_row_start[t_end]]))
+        {
+            t_end++;
+        }
+
+        if (t_end - i >= DENSE_MIN_ROWS)
+        {
+            DenseBlock t_block;
+            t_block.m_begin = i;
+            t_block.m_end = t_end;
+            t_block.m_source = m_source[t_start];
+            t_block.m_width = t_width;
+            m_dense.push_back(t_block);
+        }
+        i = t_end;
+    }
+}
+
+template<typename T>
+bool BasicCompiledNetwork<T>::UpdateParameters(const std::vector<Neuron> &a_Neurons,
+                                               const std::vector<Connection> &a_Connections)
+{
+    ASSERT(a_Neurons.size() == NumNeurons());
+    ASSERT(a_Connections.size() == NumConnections());
+
+    // the buckets depend on the activation functions
+    for (unsigned int i = 0; i < NumNeurons(); i++)
+    {
+        if (m_act_type[i] != a_Neurons[m_public[i]].m_activation_function_type)
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < NumNeurons(); i++)
+    {
+        const Neuron &t_n = a_Neurons[m_public[i]];
+        m_a[i] = t_n.m_a;
+        m_b[i] = t_n.m_b;
+        m_bias[i] = t_n.m_bias;
+        m_timeconst[i] = t_n.m_timeconst;
+    }
+
+    for (unsigned int i = 0; i < NumConnections(); i++)
+    {
+        const unsigned int t_slot = m_connection_slot[i];
+        if (t_slot != NO_SLOT)
+        {
+            m_weight[t_slot] = a_Connections[i].m_weight;
+            m_hebb_rate[t_slot] = a_Connections[i].m_hebb_rate;
+            m_hebb_pre_rate[t_slot] = a_Connections[i].m_hebb_pre_rate;
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ComputeSums(unsigned int a_Begin, unsigned int a_End)
+{
+    if ((!m_pool) || (a_Begin + 1 >= a_End) ||
+        (m_row_start[a_End] - m_row_start[a_Begin] < m_parallel_threshold))
+    {
+        ComputeSumsSerial(a_Begin, a_End);
+        return;
+    }
+
+    // cut the range where the running connection count crosses each share
+    const unsigned int t_slices = m_pool->NumThreads();
+    const unsigned int t_first = m_row_start[a_Begin];
+    const unsigned int t_total = m_row_start[a_End] - t_first;
+    m_slice_start.resize(t_slices + 1);
+    m_slice_start[0] = a_Begin;
+    for (unsigned int k = 1; k < t_slices; k++)
+    {
+        unsigned int t_share = t_first + static_cast<unsigned int>((static_cast<unsigned long long>(t_total) * k) / t_slices);
+        unsigned int t_cut = static_cast<unsigned int>(std::lower_bound(m_row_start.begin() + a_Begin,
+                                                                        m_row_start.begin() + a_End,
+                                                                        t_share) - m_row_start.begin());
+        m_slice_start[k] = std::max(t_cut, m_slice_start[k - 1]);
+    }
+    m_slice_start[t_slices] = a_End;
+
+    m_pool->Run(t_slices, [this](unsigned int a_Slice)
+    {
+        ComputeSumsSerial(m_slice_start[a_Slice], m_slice_start[a_Slice + 1]);
+    });
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ComputeSumsSerial(unsigned int a_Begin, unsigned int a_End)
+{
+    // the dense blocks overlapping the range as matrix-vector products, the rest row by row
+    unsigned int i = a_Begin;
+    for (unsigned int d = 0; (d < m_dense.size()) && (i < a_End); d++)
+    {
+        const DenseBlock &t_block = m_dense[d];
+        if (t_block.m_end <= i)
+        {
+            continue;
+        }
+        if (t_block.m_begin >= a_End)
+        {
+            break;
+        }
+        if (t_block.m_begin > i)
+        {
+            ComputeSumsSparse(i, t_block.m_begin);
+            i = t_block.m_begin;
+        }
+
+        const unsigned int t_end = std::min(t_block.m_end, a_End);
+        DenseMatVec(&m_weight[m_row_start[i]], t_block.m_width, &m_activation[t_block.m_source],
+                    &m_activesum[i], t_end - i);
+        i = t_end;
+    }
+
+    ComputeSumsSparse(i, a_End);
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ComputeSumsSparse(unsigned int a_Begin, unsigned int a_End)
+{
+    const unsigned int *t_row = m_row_start.data();
+    const unsigned int *t_src = m_source.data();
+    const T *t_w = m_weight.data();
+    const T *t_act = m_activation.data();
+
+    // Two rows at a time. Their sums are independent chains of additions, so the
+    // gathers of one row overlap the additions of the other instead of waiting on
+    // them, while each row is still summed in its own order. This is only an
+    // interleaving of the CSR rows, the storage is not blocked.
+    unsigned int i = a_Begin;
+    for (; i + 2 <= a_End; i += 2)
+    {
+        unsigned int k0 = t_row[i], k1 = t_row[i + 1];
+        const unsigned int t_end0 = t_row[i + 1], t_end1 = t_row[i + 2];
+        const unsigned int t_common = std::min(t_end0 - k0, t_end1 - k1);
+
+        T t_sum0 = 0, t_sum1 = 0;
+        for (unsigned int c = 0; c < t_common; c++, k0++, k1++)
+        {
+            t_sum0 += t_act[t_src[k0]] * t_w[k0];
+            t_sum1 += t_act[t_src[k1]] * t_w[k1];
+        }
+        for (; k0 < t_end0; k0++)
+        {
+            t_sum0 += t_act[t_src[k0]] * t_w[k0];
+        }
+        for (; k1 < t_end1; k1++)
+        {
+            t_sum1 += t_act[t_src[k1]] * t_w[k1];
+        }
+        m_activesum[i] = t_sum0;
+        m_activesum[i + 1] = t_sum1;
+    }
+    for (; i < a_End; i++)
+    {
+        T t_sum = 0;
+        for (unsigned int k = t_row[i]; k < t_row[i + 1]; k++)
+        {
+            t_sum += t_act[t_src[k]] * t_w[k];
+        }
+        m_activesum[i] = t_sum;
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ApplyActivations(const T *a_X)
+{
+    for (unsigned int k = 0; k < m_bucket_type.size(); k++)
+    {
+        unsigned int t_begin = m_bucket_start[k];
+        ActivateSpan(m_bucket_type[k], a_X + t_begin, &m_a[t_begin], &m_b[t_begin], &m_activation[t_begin],
+                     m_bucket_start[k + 1] - t_begin, m_accuracy);
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ActivateFast()
+{
+    ComputeSums(m_num_inputs, NumNeurons());
+
+    if (m_num_inputs < NumNeurons())
+    {
+        ActivateSpan(UNSIGNED_SIGMOID, &m_activesum[m_num_inputs], &m_a[m_num_inputs], &m_b[m_num_inputs],
+                     &m_activation[m_num_inputs], NumNeurons() - m_num_inputs, m_accuracy);
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Activate()
+{
+    ComputeSums(m_num_inputs, NumNeurons());
+    ApplyActivations(m_activesum.data());
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ActivateFeedForward()
+{
+    for (unsigned int l = 0; l + 1 < m_level_start.size(); l++)
+    {
+        ComputeSums(m_level_start[l], m_level_start[l + 1]);
+
+        for (unsigned int k = m_level_bucket[l]; k < m_level_bucket[l + 1]; k++)
+        {
+            unsigned int t_begin = m_bucket_start[k];
+            ActivateSpan(m_bucket_type[k], &m_activesum[t_begin], &m_a[t_begin], &m_b[t_begin],
+                         &m_activation[t_begin], m_bucket_start[k + 1] - t_begin, m_accuracy);
+        }
+    }
+}
+
+template<typename T>
+unsigned int BasicCompiledNetwork<T>::ActivateUntilStable(double a_Tolerance, unsigned int a_MaxIterations,
+                                                          unsigned int a_Unchecked)
+{
+    if (a_MaxIterations == 0)
+    {
+        return 0;
+    }
+    if (m_feed_forward)
+    {
+        ActivateFeedForward();
+        return 1;
+    }
+
+    const unsigned int t_num_neurons = NumNeurons();
+    unsigned int t_steps = 0;
+    while (t_steps < a_MaxIterations)
+    {
+        t_steps++;
+        if (t_steps <= a_Unchecked)
+        {
+            Activate();
+            continue;
+        }
+
+        m_previous.assign(m_activation.begin() + m_num_inputs, m_activation.end());
+        Activate();
+
+        double t_change = 0;
+        for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+        {
+            t_change = std::max(t_change, static_cast<double>(std::fabs(m_activation[i] - m_previous[i - m_num_inputs])));
+        }
+        if (t_change < a_Tolerance)
+        {
+            break;
+        }
+    }
+
+    return t_steps;
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ActivateUseInternalBias()
+{
+    ComputeSums(m_num_inputs, NumNeurons());
+
+    for (unsigned int i = m_num_inputs; i < NumNeurons(); i++)
+    {
+        m_activesum[i] += m_bias[i];
+    }
+    ApplyActivations(m_activesum.data());
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ActivateLeaky(double a_dtime)
+{
+    ComputeSums(m_num_inputs, NumNeurons());
+
+    // the leaky integrator step
+    for (unsigned int i = m_num_inputs; i < NumNeurons(); i++)
+    {
+        T t_const = static_cast<T>(a_dtime) / m_timeconst[i];
+        m_membrane_potential[i] = (T(1) - t_const) * m_membrane_potential[i] + t_const * m_activesum[i];
+        m_activesum[i] = m_membrane_potential[i] + m_bias[i];
+    }
+    ApplyActivations(m_activesum.data());
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Flush()
+{
+    for (unsigned int i = 0; i < NumNeurons(); i++)
+    {
+        m_activation[i] = 0;
+        m_activesum[i] = 0;
+        m_membrane_potential[i] = 0;
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::FlushBatch()
+{
+    m_batch_size = 0;
+    m_batch_activesum.clear();
+    m_batch_activation.clear();
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::ActivateBatch(const double *a_Inputs, unsigned int a_Batch, double *a_Outputs)
+{
+    const unsigned int t_num_neurons = NumNeurons();
+    const size_t B = a_Batch;
+
+    if (a_Batch != m_batch_size)
+    {
+        m_batch_size = a_Batch;
+        m_batch_activesum.assign(t_num_neurons * B, 0.0);
+        m_batch_activation.assign(t_num_neurons * B, 0.0);
+    }
+
+    T *t_act = m_batch_activation.data();
+    T *t_sum = m_batch_activesum.data();
+
+    // transpose the inputs into the [neuron][sample] layout
+    for (size_t b = 0; b < B; b++)
+    {
+        for (unsigned int i = 0; i < m_num_inputs; i++)
+        {
+            t_act[i * B + b] = a_Inputs[b * m_num_inputs + i];
+        }
+    }
+
+    // all sums first, so every sample sees the activations of the previous step
+    for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+    {
+        T *t_dst = t_sum + i * B;
+        for (size_t b = 0; b < B; b++)
+        {
+            t_dst[b] = 0.0;
+        }
+
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            const T t_w = m_weight[k];
+            const T *t_src = t_act + m_source[k] * B;
+            for (size_t b = 0; b < B; b++)
+            {
+                t_dst[b] += t_src[b] * t_w;
+            }
+        }
+    }
+
+    for (unsigned int k = 0; k < m_bucket_type.size(); k++)
+    {
+        for (unsigned int i = m_bucket_start[k]; i < m_bucket_start[k + 1]; i++)
+        {
+            ActivateSpan(m_bucket_type[k], t_sum + i * B, m_a[i], m_b[i], t_act + i * B, a_Batch, m_accuracy);
+        }
+    }
+
+    for (size_t b = 0; b < B; b++)
+    {
+        for (unsigned int i = 0; i < m_num_outputs; i++)
+        {
+            a_Outputs[b * m_num_outputs + i] = t_act[m_internal[m_num_inputs + i] * B + b];
+        }
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Input(const double *a_Inputs, unsigned int a_Count)
+{
+    if (a_Count > m_num_inputs)
+    {
+        a_Count = m_num_inputs;
+    }
+
+    for (unsigned int i = 0; i < a_Count; i++)
+    {
+        m_activation[i] = a_Inputs[i];
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Output(double *a_Outputs) const
+{
+    for (unsigned int i = 0; i < m_num_outputs; i++)
+    {
+        a_Outputs[i] = m_activation[m_internal[m_num_inputs + i]];
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::WriteBackState(std::vector<Neuron> &a_Neurons) const
+{
+    ASSERT(a_Neurons.size() == NumNeurons());
+
+    for (unsigned int i = 0; i < NumNeurons(); i++)
+    {
+        a_Neurons[i].m_activation = m_activation[m_internal[i]];
+        a_Neurons[i].m_membrane_potential = m_membrane_potential[m_internal[i]];
+        // the activated neurons always have their sum cleared after the step
+        if (i >= m_num_inputs)
+        {
+            a_Neurons[i].m_activesum = 0;
+        }
+    }
+}
+
+template<typename T>
+double BasicCompiledNetwork<T>::MaxAbsWeight() const
+{
+    T t_max = 0;
+    for (unsigned int k = 0; k < m_weight.size(); k++)
+    {
+        t_max = std::max(t_max, static_cast<T>(std::fabs(m_weight[k])));
+    }
+    return t_max;
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::Adapt(double a_MaxAbsWeight, double a_Limit)
+{
+    const T t_max = static_cast<T>(a_MaxAbsWeight);
+    const T t_limit = static_cast<T>(a_Limit);
+    const unsigned int *t_src = m_source.data();
+    const T *t_act = m_activation.data();
+    const T *t_rate = m_hebb_rate.data();
+    const T *t_pre_rate = m_hebb_pre_rate.data();
+    T *t_w = m_weight.data();
+
+    // row by row, the target activation is the same for the whole row
+    for (unsigned int i = m_num_inputs; i < NumNeurons(); i++)
+    {
+        const T t_y = t_act[i];
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            t_w[k] = HebbianUpdate(t_w[k], t_rate[k], t_pre_rate[k], t_max, t_act[t_src[k]], t_y, t_limit);
+        }
+    }
+}
+
+template<typename T>
+void BasicCompiledNetwork<T>::WriteBackWeights(std::vector<Connection> &a_Connections) const
+{
+    ASSERT(a_Connections.size() == NumConnections());
+
+    for (unsigned int i = 0; i < NumConnections(); i++)
+    {
+        if (m_connection_slot[i] != NO_SLOT)
+        {
+            a_Connections[i].m_weight = m_weight[m_connection_slot[i]];
+        }
+    }
+}
+
+template class BasicCompiledNetwork<double>;
+template class BasicCompiledNetwork<float>;
+
+} // namespace NEAT
@@ -0,0 +1,328 @@
+#ifndef _COMPILEDNETWORK_H
+#define _COMPILEDNETWORK_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        CompiledNetwork.h
+// Description: Flat evaluation plan for the phenotype (inference engine).
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <memory>
+#include "Genes.h"
+#include "ActivationKernels.h"
+#include "ThreadPool.h"
+
+namespace NEAT
+{
+
+class Neuron;
+class Connection;
+
+// The precision a network is evaluated in
+enum NetworkPrecision
+{
+    PRECISION_DOUBLE = 0,
+    PRECISION_FLOAT
+};
+
+// The Hebbian update of one weight a_W from a_X (source activation) to a_Y (target
+// activation), with the learning rates of the link and a_MaxAbsWeight, the largest
+// absolute weight of the network. The result is clamped to +-a_Limit.
+//
+// Both signs are computed and one is picked, so there is no branch in a loop over
+// the weights. The arithmetic is exactly that of NeuralNetwork::Adapt() always was,
+// including the sign flip of negative weights.
+template<typename T>
+inline T HebbianUpdate(T a_W, T a_HebbRate, T a_HebbPreRate, T a_MaxAbsWeight, T a_X, T a_Y, T a_Limit)
+{
+    const T t_positive = a_W + ((a_HebbRate * (a_MaxAbsWeight - a_W) * a_X * a_Y)
+                                + a_HebbPreRate * a_MaxAbsWeight * a_X * (a_Y - T(1)));
+    const T t_negative = -(a_W + (a_HebbPreRate * (a_MaxAbsWeight - a_W) * a_X * (T(1) - a_Y)
+                                  - a_HebbRate * a_MaxAbsWeight * a_X * a_Y));
+    const T t_new = (a_W > 0) ? t_positive : ((a_W < 0) ? t_negative : a_W);
+    return std::min(std::max(t_new, -a_Limit), a_Limit);
+}
+
+// The temporary arrays of the topological sort, kept between builds
+struct TopologyScratch
+{
+    std::vector<unsigned int> m_out_start, m_out, m_fill;
+    std::vector<unsigned char> m_visited;
+    std::vector<unsigned int> m_order, m_position;
+    std::vector<std::pair<unsigned int, unsigned int> > m_stack;
+    std::vector<unsigned int> m_in_start, m_in, m_key, m_rank;
+};
+
+//-----------------------------------------------------------------------
+// A flat, immutable evaluation plan built out of a NeuralNetwork.
+//
+// The connections are stored in compressed sparse row (CSR) form, grouped
+// by target neuron and kept in their original order inside each row, so the
+// sums are accumulated exactly like NeuralNetwork::Activate() always did.
+// Weights, source indices and the neuron parameters live in contiguous
+// arrays; one activation step is a sequential sweep over them and never
+// touches the Neuron/Connection structs.
+//
+// Only the network state (activations, membrane potentials) changes after
+// Build(). The weights may be changed through SetWeight() by the learning
+// rules, but the topology is fixed until the next Build().
+//
+// T is the precision of the weights, parameters and state (double or float).
+// The interface always takes and returns doubles.
+template<typename T>
+class BasicCompiledNetwork
+{
+    unsigned int m_num_inputs, m_num_outputs;
+
+    ///////////////////
+    // Structure
+    //
+    // Internally the neurons are reordered: the inputs stay in front and the
+    // rest is sorted by topological level, then grouped into buckets of the
+    // same activation function, so every bucket is activated by one span
+    // kernel call. In large networks the neurons inside a bucket are further
+    // ordered by their sources (see OrderForLocality() in the .cpp), so that
+    // neighbouring rows read neighbouring activations. All public methods take
+    // and return the original neuron indices.
+    //
+    // The connections stay in plain CSR form (one row per neuron, see below),
+    // there is no blocked storage such as BCSR: it would sort and zero-pad the
+    // rows, and the sums must keep the order of the connections of every row.
+    std::vector<unsigned int> m_public;   // internal index -> original index
+    std::vector<unsigned int> m_internal; // original index -> internal index
+
+    // bucket k spans internal neurons m_bucket_start[k] .. m_bucket_start[k+1]
+    std::vector<unsigned int> m_bucket_start;
+    std::vector<ActivationFunction> m_bucket_type;
+
+    // level l spans internal neurons m_level_start[l] .. m_level_start[l+1]
+    // and buckets m_level_bucket[l] .. m_level_bucket[l+1] (inputs not included)
+    std::vector<unsigned int> m_level_start;
+    std::vector<unsigned int> m_level_bucket;
+
+    // true if no connection closes a loop
+    bool m_feed_forward;
+
+    // m_row_start[i] .. m_row_start[i+1] are the incoming connections of neuron i
+    std::vector<unsigned int> m_row_start;
+    std::vector<unsigned int> m_source;
+    std::vector<T> m_weight;
+
+    // the Hebbian learning rates of every slot, see Adapt()
+    std::vector<T> m_hebb_rate, m_hebb_pre_rate;
+
+    // the CSR slot of every original connection, or NO_SLOT if the
+    // connection targets an input neuron (inputs are never activated)
+    std::vector<unsigned int> m_connection_slot;
+
+    // the original connections without a slot
+    std::vector<unsigned int> m_input_connections;
+
+    std::vector<ActivationFunction> m_act_type;
+    std::vector<T> m_a, m_b;
+    std::vector<T> m_bias;
+    std::vector<T> m_timeconst;
+
+    ///////////////////
+    // State
+    std::vector<T> m_activesum;
+    std::vector<T> m_activation;
+    std::vector<T> m_membrane_potential;
+
+    // the activations of the previous step, for ActivateUntilStable()
+    std::vector<T> m_previous;
+
+    ///////////////////
+    // Batch state
+    // Laid out [neuron][sample] so the inner loops run along the batch.
+    // It is independent of the single-sample state above.
+    unsigned int m_batch_size;
+    std::vector<T> m_batch_activesum;
+    std::vector<T> m_batch_activation;
+
+    ActivationAccuracy m_accuracy;
+
+    ///////////////////
+    // Parallel activation
+    // The sums of large enough ranges of neurons are split into slices of about
+    // the same number of connections, one task per slice. Every slice owns its
+    // part of m_activesum, the rows are gathered, so no atomics are needed and
+    // the results are bit for bit the same as serial.
+    std::shared_ptr<ThreadPool> m_pool; // none in serial mode
+    unsigned int m_parallel_threshold;  // the least connections to go parallel
+    std::vector<unsigned int> m_slice_start;
+
+    ///////////////////
+    // Dense blocks
+    // A run of rows that all have the same sources, in the same order, and whose
+    // sources are a contiguous range of neurons, is a dense weight matrix already -
+    // its rows lie back to back in m_weight. The sums of such a block are a
+    // matrix-vector product on m_activation[m_source .. m_source + m_width], with
+    // no gather through m_source. Fully connected layers (e.g. of HyperNEAT
+    // substrates) compile to one block each.
+    // Only exactly fully connected layers qualify: a row that misses a single
+    // source is not padded with zero weights, it ends the block and is summed
+    // sparsely. The product is plain scalar code (see DenseMatVec()), not one of
+    // the SIMD kernels, so every row keeps the summation order of the sparse loop.
+    struct DenseBlock
+    {
+        unsigned int m_begin, m_end; // the rows (internal order)
+        unsigned int m_source;       // the first source (internal order)
+        unsigned int m_width;        // the number of sources
+    };
+    std::vector<DenseBlock> m_dense;
+
+    ///////////////////
+    // Scratch space of Build(). It is kept, like the arrays above, so a
+    // rebuild that is not larger than an earlier one does not allocate.
+    TopologyScratch m_scratch;
+    std::vector<unsigned int> m_scratch_level;
+    std::vector<unsigned int> m_scratch_public;
+
+    // sums the weighted input signals of the neurons a_Begin .. a_End (internal order) into m_activesum
+    void ComputeSums(unsigned int a_Begin, unsigned int a_End);
+    void ComputeSumsSerial(unsigned int a_Begin, unsigned int a_End);
+    void ComputeSumsSparse(unsigned int a_Begin, unsigned int a_End);
+
+    // finds the dense blocks after the rows were placed
+    void FindDenseBlocks();
+
+    // activates every non-input neuron on a_X (internal order), one span kernel call per bucket
+    void ApplyActivations(const T *a_X);
+
+public:
+    static const unsigned int NO_SLOT = 0xFFFFFFFF;
+
+    BasicCompiledNetwork();
+
+    // Builds the plan. The current activations and membrane potentials of
+    // the neurons become the initial state. Clear() keeps the memory, so a
+    // plan can be rebuilt over and over without allocating.
+    void Build(const std::vector<Neuron> &a_Neurons,
+               const std::vector<Connection> &a_Connections,
+               unsigned int a_NumInputs, unsigned int a_NumOutputs);
+
+    void Clear();
+
+    // Copies the weights and the neuron parameters into the plan in place, without
+    // touching the state. The network must have the topology the plan was built
+    // from. Returns false (and changes nothing) if an activation function differs,
+    // the plan must be rebuilt then.
+    bool UpdateParameters(const std::vector<Neuron> &a_Neurons,
+                          const std::vector<Connection> &a_Connections);
+
+    bool IsEmpty() const { return m_act_type.empty(); }
+
+    void ActivateFast();          // assumes unsigned sigmoids everywhere.
+    void Activate();              // any activation functions are supported
+    void ActivateUseInternalBias(); // like Activate() but uses m_bias as well
+    void ActivateLeaky(double a_dtime); // activates in leaky integrator mode
+
+    // Like Activate() repeated until the signal has reached the outputs, in a single
+    // sweep level by level. Exact for feed-forward networks, see IsFeedForward().
+    void ActivateFeedForward();
+
+    // Repeats Activate() until no activation changes by a_Tolerance or more in a step,
+    // but at most a_MaxIterations times, and returns the number of steps taken. The
+    // change is not measured in the first a_Unchecked steps. A feed-forward plan is
+    // relaxed by a single ActivateFeedForward(), which counts as one step.
+    unsigned int ActivateUntilStable(double a_Tolerance, unsigned int a_MaxIterations, unsigned int a_Unchecked);
+
+    void Flush();
+
+    // Like Activate(), but for a_Batch independent samples in lock-step.
+    // a_Inputs is a_Batch rows of NumInputs() values, a_Outputs receives
+    // a_Batch rows of NumOutputs() values. Every sample keeps its own state
+    // between calls; changing the batch size starts over from a flushed state.
+    void ActivateBatch(const double *a_Inputs, unsigned int a_Batch, double *a_Outputs);
+    void FlushBatch();
+    unsigned int BatchSize() const { return m_batch_size; }
+
+    // Hebbian learning over the slots, see HebbianUpdate(). a_MaxAbsWeight is the
+    // largest absolute weight of the whole network - MaxAbsWeight(), unless the
+    // network has connections into inputs, which are not part of the plan.
+    void Adapt(double a_MaxAbsWeight, double a_Limit);
+    double MaxAbsWeight() const;
+
+    // The connections into input neurons. They have no slot (inputs are never
+    // activated), so their weights are not kept or learned by the plan.
+    const std::vector<unsigned int> &InputConnections() const { return m_input_connections; }
+
+    // Activates on the threads of a_Pool whenever the connections to sum number
+    // at least a_MinConnections. No pool turns it off, which is the default.
+    // Copies of the plan share the pool.
+    void SetParallel(const std::shared_ptr<ThreadPool> &a_Pool, unsigned int a_MinConnections);
+    const std::shared_ptr<ThreadPool> &GetPool() const { return m_pool; }
+    unsigned int GetParallelThreads() const { return m_pool ? m_pool->NumThreads() : 1; }
+    unsigned int GetParallelThreshold() const { return m_parallel_threshold; }
+
+    // see ActivationKernels.h, the default is ACTIVATION_EXACT
+    void SetAccuracy(ActivationAccuracy a_Accuracy) { m_accuracy = a_Accuracy; }
+    ActivationAccuracy GetAccuracy() const { return m_accuracy; }
+
+    // a_Count is clipped to the number of inputs
+    void Input(const double *a_Inputs, unsigned int a_Count);
+    void Output(double *a_Outputs) const;
+
+    // Copies the current state into the neurons and the current weights
+    // into the connections the plan was built from.
+    void WriteBackState(std::vector<Neuron> &a_Neurons) const;
+    void WriteBackWeights(std::vector<Connection> &a_Connections) const;
+
+    // accessor methods
+    unsigned int NumInputs() const { return m_num_inputs; }
+    unsigned int NumOutputs() const { return m_num_outputs; }
+    unsigned int NumNeurons() const { return static_cast<unsigned int>(m_act_type.size()); }
+    unsigned int NumConnections() const { return static_cast<unsigned int>(m_connection_slot.size()); }
+
+    unsigned int RowStart(unsigned int a_neuron) const { return m_row_start[m_internal[a_neuron]]; }
+    unsigned int RowEnd(unsigned int a_neuron) const { return m_row_start[m_internal[a_neuron] + 1]; }
+    unsigned int Source(unsigned int a_slot) const { return m_public[m_source[a_slot]]; }
+    double Weight(unsigned int a_slot) const { return m_weight[a_slot]; }
+    void SetWeight(unsigned int a_slot, double a_weight) { m_weight[a_slot] = static_cast<T>(a_weight); }
+    unsigned int ConnectionSlot(unsigned int a_connection) const { return m_connection_slot[a_connection]; }
+
+    double GetActivation(unsigned int a_neuron) const { return m_activation[m_internal[a_neuron]]; }
+    void SetActivation(unsigned int a_neuron, double a_value) { m_activation[m_internal[a_neuron]] = static_cast<T>(a_value); }
+
+    unsigned int NumBuckets() const { return static_cast<unsigned int>(m_bucket_type.size()); }
+    unsigned int NumLevels() const { return m_level_start.empty() ? 0 : static_cast<unsigned int>(m_level_start.size()) - 1; }
+    bool IsFeedForward() const { return m_feed_forward; }
+    unsigned int NumDenseBlocks() const { return static_cast<unsigned int>(m_dense.size()); }
+};
+
+template<typename T>
+const unsigned int BasicCompiledNetwork<T>::NO_SLOT;
+
+typedef BasicCompiledNetwork<double> CompiledNetwork;
+typedef BasicCompiledNetwork<float> CompiledNetworkFloat;
+
+} // namespace NEAT
+
+#endif
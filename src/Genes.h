@@ -97,7 +97,7 @@ namespace NEAT
     {
     public:
         // Arbitrary traits
-        std::map<std::string, Trait> m_Traits;
+        GeneTraits m_Traits;
 
         Gene &operator=(const Gene &a_g)
         {
@@ -112,26 +112,37 @@ namespace NEAT
         // Randomize based on parameters
         void InitTraits(const std::map<std::string, TraitParameters> &tp, RNG &a_RNG)
         {
-            for(auto it = tp.begin(); it != tp.end(); it++)
+            InitTraits(tp, *TraitLayout::Of(tp), a_RNG);
+        }
+
+        // The same with a_Layout, the layout of tp, already at hand
+        void InitTraits(const std::map<std::string, TraitParameters> &tp, const TraitLayout &a_Layout, RNG &a_RNG)
+        {
+            m_Traits.m_Layout = a_Layout.shared_from_this();
+            m_Traits.m_Values.resize(tp.size());
+
+            unsigned int t_slot = 0;
+            for(auto it = tp.begin(); it != tp.end(); it++, t_slot++)
             {
                 // Check what kind of type is this and create such trait
-                TraitType t;
+                TraitType &t = m_Traits.m_Values[t_slot];
+                t = TraitType();
 
                 if (it->second.type == "int")
                 {
-                    IntTraitParameters itp = bs::get<IntTraitParameters>(it->second.m_Details);
+                    const IntTraitParameters &itp = bs::get<IntTraitParameters>(it->second.m_Details);
                     t = a_RNG.RandInt(itp.min, itp.max);
                 }
                 else if (it->second.type == "float")
                 {
-                    FloatTraitParameters itp = bs::get<FloatTraitParameters>(it->second.m_Details);
+                    const FloatTraitParameters &itp = bs::get<FloatTraitParameters>(it->second.m_Details);
                     double x = a_RNG.RandFloat();
                     Scale(x, 0, 1, itp.min, itp.max);
                     t = x;
                 }
                 else if (it->second.type == "str")
                 {
-                    StringTraitParameters itp = bs::get<StringTraitParameters>(it->second.m_Details);
+                    const StringTraitParameters &itp = bs::get<StringTraitParameters>(it->second.m_Details);
                     std::vector<double> probs = itp.probs;
                     if (itp.set.size() == 0)
                     {
@@ -144,7 +155,7 @@ namespace NEAT
                 }
                 else if (it->second.type == "intset")
                 {
-                    IntSetTraitParameters itp = bs::get<IntSetTraitParameters>(it->second.m_Details);
+                    const IntSetTraitParameters &itp = bs::get<IntSetTraitParameters>(it->second.m_Details);
                     std::vector<double> probs = itp.probs;
                     if (itp.set.size() == 0)
                     {
@@ -157,7 +168,7 @@ namespace NEAT
                 }
                 else if (it->second.type == "floatset")
                 {
-                    FloatSetTraitParameters itp = bs::get<FloatSetTraitParameters>(it->second.m_Details);
+                    const FloatSetTraitParameters &itp = bs::get<FloatSetTraitParameters>(it->second.m_Details);
                     std::vector<double> probs = itp.probs;
                     if (itp.set.size() == 0)
                     {
@@ -200,22 +211,24 @@ namespace NEAT
                 }
 #endif
 
-                Trait tr;
-                tr.value = t;
-                tr.dep_key = it->second.dep_key;
-                tr.dep_values = it->second.dep_values;
                 // todo check for invalid dep_values types here
-                m_Traits[it->first] = tr;
             }
         }
 
         // Traits are merged with this other parent
-        void MateTraits(const std::map<std::string, Trait> &t, RNG &a_RNG)
+        void MateTraits(const GeneTraits &t, RNG &a_RNG)
         {
-            for(auto it = t.begin(); it != t.end(); it++)
+            const bool t_same = (m_Traits.m_Layout == t.m_Layout);
+            for(unsigned int i = 0; i < t.size(); i++)
             {
-                TraitType mine = m_Traits[it->first].value;
-                TraitType yours = it->second.value;
+                int t_slot = t_same ? static_cast<int>(i) : m_Traits.Slot(t.Name(i));
+                if (t_slot < 0)
+                {
+                    throw std::runtime_error("Types of traits doesn't match");
+                }
+
+                TraitType &mine = m_Traits.m_Values[t_slot];
+                const TraitType &yours = t.m_Values[i];
 
                 if (!(mine.type() == yours.type()))
                 {
@@ -227,14 +240,17 @@ namespace NEAT
                 if (mine.type() == typeid(py::object))
                 {
                     // call mating function
-                    m_Traits[it->first].value = bs::get<py::object>(mine).attr("mate")(bs::get<py::object>(yours));
+                    mine = py::object(bs::get<py::object>(mine).attr("mate")(bs::get<py::object>(yours)));
                 }
                 else
 #endif
                 {
                     if (a_RNG.RandFloat() < 0.5) // pick either one
                     {
-                        m_Traits[it->first].value = (a_RNG.RandFloat() < 0.5) ? mine : yours;
+                        if (!(a_RNG.RandFloat() < 0.5))
+                        {
+                            mine = yours;
+                        }
                     }
                     else
                     {
@@ -243,32 +259,21 @@ namespace NEAT
                         {
                             int m1 = bs::get<int>(mine);
                             int m2 = bs::get<int>(yours);
-                            m_Traits[it->first].value = (m1 + m2) / 2;
+                            mine = (m1 + m2) / 2;
                         }
-
-                        if (mine.type() == typeid(double))
+                        else if (mine.type() == typeid(double))
                         {
                             double m1 = bs::get<double>(mine);
                             double m2 = bs::get<double>(yours);
-                            m_Traits[it->first].value = (m1 + m2) / 2.0;
-                        }
-
-                        if (mine.type() == typeid(std::string))
-                        {
-                            // strings are always either-or
-                            m_Traits[it->first].value = (a_RNG.RandFloat() < 0.5) ? mine : yours;
+                            mine = (m1 + m2) / 2.0;
                         }
-
-                        if (mine.type() == typeid(intsetelement))
-                        {
-                            // int sets are always either-or
-                            m_Traits[it->first].value = (a_RNG.RandFloat() < 0.5) ? mine : yours;
-                        }
-
-                        if (mine.type() == typeid(floatsetelement))
+                        else
                         {
-                            // float sets are always either-or
-                            m_Traits[it->first].value = (a_RNG.RandFloat() < 0.5) ? mine : yours;
+                            // strings and sets are always either-or
+                            if (!(a_RNG.RandFloat() < 0.5))
+                            {
+                                mine = yours;
+                            }
                         }
                     }
                 }
@@ -276,23 +281,37 @@ namespace NEAT
         }
 
 
-        // Traits are mutated according to parameters
-        bool MutateTraits(const std::map<std::string, TraitParameters> &tp, RNG &a_RNG)
+        // Traits are mutated according to parameters, a_Layout is the layout of tp
+        bool MutateTraits(const std::map<std::string, TraitParameters> &tp, const TraitLayout &a_Layout, RNG &a_RNG)
         {
+            const bool t_same = (m_Traits.m_Layout.get() == &a_Layout);
             bool did_mutate = false;
-            for(auto it = tp.cbegin(); it != tp.cend(); it++)
+            unsigned int t_slot = 0;
+            for(auto it = tp.cbegin(); it != tp.cend(); it++, t_slot++)
             {
+                int t_mine = t_same ? static_cast<int>(t_slot) : m_Traits.Slot(it->first);
+                if (t_mine < 0)
+                {
+                    throw std::out_of_range("No such trait " + it->first);
+                }
+                TraitType &t_value = m_Traits.m_Values[t_mine];
+
                 // only mutate the trait if it's enabled
                 bool doit = false;
-                if (it->second.dep_key != "")
+                if (t_same)
+                {
+                    doit = m_Traits.Enabled(t_slot);
+                }
+                else if (it->second.dep_key != "")
                 {
                     // there is such trait..
-                    if (m_Traits.count(it->second.dep_key) != 0)
+                    const TraitType *t_dep = m_Traits.Find(it->second.dep_key);
+                    if (t_dep != NULL)
                     {
                         // and it matches any of the right values?
                         for(long unsigned int ix=0; ix<it->second.dep_values.size(); ix++)
                         {
-                            if (m_Traits[it->second.dep_key].value == it->second.dep_values[ix])
+                            if (*t_dep == it->second.dep_values[ix])
                             {
                                 doit = true;
                                 break;
@@ -309,9 +328,9 @@ namespace NEAT
                 {
                     if (it->second.type == "int")
                     {
-                        IntTraitParameters itp = bs::get<IntTraitParameters>(it->second.m_Details);
+                        const IntTraitParameters &itp = bs::get<IntTraitParameters>(it->second.m_Details);
                         // determine type of mutation - modify or replace, according to parameters
-                        int val = bs::get<int>(m_Traits[it->first].value);
+                        int val = bs::get<int>(t_value);
                         int cur = val;
                         if (a_RNG.RandFloat() < itp.mut_replace_prob)
                         {
@@ -330,13 +349,13 @@ namespace NEAT
                                 Clamp(val, itp.min, itp.max);
                             }
                         }
-                        m_Traits[it->first].value = val;
+                        t_value = val;
                         did_mutate = true;
                     }
                     else if (it->second.type == "float")
                     {
-                        FloatTraitParameters itp = bs::get<FloatTraitParameters>(it->second.m_Details);
-                        double val = bs::get<double>(m_Traits[it->first].value);
+                        const FloatTraitParameters &itp = bs::get<FloatTraitParameters>(it->second.m_Details);
+                        double val = bs::get<double>(t_value);
                         double cur = val;
 
                         // determine type of mutation - modify or replace, according to parameters
@@ -358,15 +377,15 @@ namespace NEAT
                                 Clamp(val, itp.min, itp.max);
                             }
                         }
-                        m_Traits[it->first].value = val;
+                        t_value = val;
                         did_mutate = true;
                     }
                     else if (it->second.type == "str")
                     {
-                        StringTraitParameters itp = bs::get<StringTraitParameters>(it->second.m_Details);
+                        const StringTraitParameters &itp = bs::get<StringTraitParameters>(it->second.m_Details);
                         std::vector<double> probs = itp.probs;
                         probs.resize(itp.set.size());
-                        std::string cur = bs::get<std::string>(m_Traits[it->first].value);
+                        const std::string cur = bs::get<std::string>(t_value);
                         
                         int idx;
                         do 
@@ -376,15 +395,15 @@ namespace NEAT
                         while (cur == itp.set[idx]);
 
                         // now choose the new idx from the set
-                        m_Traits[it->first].value = itp.set[idx];
+                        t_value = itp.set[idx];
                         did_mutate = true;
                     }
                     else if (it->second.type == "intset")
                     {
-                        IntSetTraitParameters itp = bs::get<IntSetTraitParameters>(it->second.m_Details);
+                        const IntSetTraitParameters &itp = bs::get<IntSetTraitParameters>(it->second.m_Details);
                         std::vector<double> probs = itp.probs;
                         probs.resize(itp.set.size());
-                        intsetelement cur = bs::get<intsetelement>(m_Traits[it->first].value);
+                        intsetelement cur = bs::get<intsetelement>(t_value);
 
                         int idx;
                         do 
@@ -394,15 +413,15 @@ namespace NEAT
                         while (cur.value == itp.set[idx].value);
 
                         // now choose the new idx from the set
-                        m_Traits[it->first].value = itp.set[idx];
+                        t_value = itp.set[idx];
                         did_mutate = true;
                     }
                     else if (it->second.type == "floatset")
                     {
-                        FloatSetTraitParameters itp = bs::get<FloatSetTraitParameters>(it->second.m_Details);
+                        const FloatSetTraitParameters &itp = bs::get<FloatSetTraitParameters>(it->second.m_Details);
                         std::vector<double> probs = itp.probs;
                         probs.resize(itp.set.size());
-                        floatsetelement cur = bs::get<floatsetelement>(m_Traits[it->first].value);
+                        floatsetelement cur = bs::get<floatsetelement>(t_value);
 
                         int idx;
                         do 
@@ -412,13 +431,13 @@ namespace NEAT
                         while (cur.value == itp.set[idx].value);
 
                         // now choose the new idx from the set
-                        m_Traits[it->first].value = itp.set[idx];
+                        t_value = itp.set[idx];
                         did_mutate = true;
                     }
 #ifdef USE_BOOST_PYTHON
                     else if ((it->second.type == "pyobject") || (it->second.type == "pyclassset"))
                     {
-                        m_Traits[it->first].value = bs::get<py::object>(m_Traits[it->first].value).attr("mutate")();
+                        t_value = bs::get<py::object>(t_value).attr("mutate")();
                         did_mutate = true;
                     }
 #endif
@@ -428,92 +447,151 @@ namespace NEAT
             return did_mutate;
         }
 
-        // Compute and return distances between each matching pair of traits
-        std::map<std::string, double> GetTraitDistances(const std::map<std::string, Trait> &other) const
+        bool MutateTraits(const std::map<std::string, TraitParameters> &tp, RNG &a_RNG)
         {
-            std::map<std::string, double> dist;
-            for(auto it = other.begin(); it!=other.end(); it++)
+            return MutateTraits(tp, *TraitLayout::Of(tp), a_RNG);
+        }
+
+        // The distance between my value of a trait and the other gene's value of it in a_Yours.
+        // Returns false if the trait is switched off by its dependency.
+        bool TraitDistance(const GeneTraits &other, unsigned int a_Yours, double &a_Distance) const
+        {
+            const bool t_same = (m_Traits.m_Layout == other.m_Layout);
+            int t_mine = t_same ? static_cast<int>(a_Yours) : m_Traits.Slot(other.Name(a_Yours));
+            if (t_mine < 0)
             {
-                const TraitType mine = m_Traits.at(it->first).value;
-                const TraitType yours = it->second.value;
+                throw std::out_of_range("No such trait " + other.Name(a_Yours));
+            }
 
-                if (!(mine.type() == yours.type()))
-                {
-                    throw std::runtime_error("Types of traits don't match");
-                }
+            const TraitType &mine = m_Traits.m_Values[t_mine];
+            const TraitType &yours = other.m_Values[a_Yours];
 
-                // only do it if the trait if it's enabled
-                // todo: not sure about the distance, think more about it
-                bool doit = false;
-                if (it->second.dep_key != "")
+            if (!(mine.type() == yours.type()))
+            {
+                throw std::runtime_error("Types of traits don't match");
+            }
+
+            // only do it if the trait if it's enabled
+            // todo: not sure about the distance, think more about it
+            bool doit = false;
+            const std::string &t_dep_key = other.m_Layout->m_DepKeys[a_Yours];
+            if (!t_dep_key.empty())
+            {
+                // there is such trait..
+                int t_my_dep = t_same ? other.m_Layout->m_DepSlots[a_Yours] : m_Traits.Slot(t_dep_key);
+                if (t_my_dep >= 0)
                 {
-                    // there is such trait..
-                    if (m_Traits.count(it->second.dep_key) != 0)
+                    int t_your_dep = other.m_Layout->m_DepSlots[a_Yours];
+                    if (t_your_dep < 0)
                     {
-                        // and it has the right value?
-                        // also the other genome has to have the trait turned on
-                        for(long unsigned int ix=0; ix<it->second.dep_values.size(); ix++)
+                        throw std::out_of_range("No such trait " + t_dep_key);
+                    }
+
+                    // and it has the right value?
+                    // also the other genome has to have the trait turned on
+                    const std::vector<TraitType> &t_dep_values = other.m_Layout->m_DepValues[a_Yours];
+                    for(long unsigned int ix=0; ix<t_dep_values.size(); ix++)
+                    {
+                        if ((m_Traits.m_Values[t_my_dep] == t_dep_values[ix]) &&
+                            (other.m_Values[t_your_dep] == t_dep_values[ix]))
                         {
-                            if ((m_Traits.at(it->second.dep_key).value == it->second.dep_values[ix]) &&
-                                (other.at(it->second.dep_key).value == it->second.dep_values[ix]))
-                            {
-                                doit = true;
-                                break;
-                            }
+                            doit = true;
+                            break;
                         }
                     }
                 }
-                else
+            }
+            else
+            {
+                doit = true;
+            }
+
+            if (!doit)
+            {
+                return false;
+            }
+
+            if (mine.type() == typeid(int))
+            {
+                // distance between ints - calculate directly
+                a_Distance = abs(bs::get<int>(mine) - bs::get<int>(yours));
+            }
+            if (mine.type() == typeid(double))
+            {
+                // distance between floats - calculate directly
+                a_Distance = abs(bs::get<double>(mine) - bs::get<double>(yours));
+            }
+            if (mine.type() == typeid(std::string))
+            {
+                // distance between strings - matching is 0, non-matching is 1
+                if (bs::get<std::string>(mine) == bs::get<std::string>(yours))
                 {
-                    doit = true;
+                    a_Distance = 0.0;
                 }
-
-                if (doit)
+                else
                 {
-                    if (mine.type() == typeid(int))
-                    {
-                        // distance between ints - calculate directly
-                        dist[it->first] = abs(bs::get<int>(mine) - bs::get<int>(yours));
-                    }
-                    if (mine.type() == typeid(double))
-                    {
-                        // distance between floats - calculate directly
-                        dist[it->first] = abs(bs::get<double>(mine) - bs::get<double>(yours));
-                    }
-                    if (mine.type() == typeid(std::string))
-                    {
-                        // distance between strings - matching is 0, non-matching is 1
-                        if (bs::get<std::string>(mine) == bs::get<std::string>(yours))
-                        {
-                            dist[it->first] = 0.0;
-                        }
-                        else
-                        {
-                            dist[it->first] = 1.0;
-                        }
-                    }
-                    if (mine.type() == typeid(intsetelement))
-                    {
-                        // distance between ints - calculate directly
-                        dist[it->first] = abs((bs::get<intsetelement>(mine)).value - (bs::get<intsetelement>(yours)).value);
-                    }
-                    if (mine.type() == typeid(floatsetelement))
-                    {
-                        // distance between floats - calculate directly
-                        dist[it->first] = abs((bs::get<floatsetelement>(mine)).value - (bs::get<floatsetelement>(yours)).value);
-                    }
+                    a_Distance = 1.0;
+                }
+            }
+            if (mine.type() == typeid(intsetelement))
+            {
+                // distance between ints - calculate directly
+                a_Distance = abs((bs::get<intsetelement>(mine)).value - (bs::get<intsetelement>(yours)).value);
+            }
+            if (mine.type() == typeid(floatsetelement))
+            {
+                // distance between floats - calculate directly
+                a_Distance = abs((bs::get<floatsetelement>(mine)).value - (bs::get<floatsetelement>(yours)).value);
+            }
 #ifdef USE_BOOST_PYTHON
-                    if (mine.type() == typeid(py::object))
-                    {
-                        // distance between objects - calculate via method
-                        dist[it->first] = py::extract<double>(bs::get<py::object>(mine).attr("distance_to")(bs::get<py::object>(yours)));
-                    }
+            if (mine.type() == typeid(py::object))
+            {
+                // distance between objects - calculate via method
+                a_Distance = py::extract<double>(bs::get<py::object>(mine).attr("distance_to")(bs::get<py::object>(yours)));
+            }
 #endif
+            return true;
+        }
+
+        // Compute and return distances between each matching pair of traits
+        std::map<std::string, double> GetTraitDistances(const GeneTraits &other) const
+        {
+            std::map<std::string, double> dist;
+            for(unsigned int i = 0; i < other.size(); i++)
+            {
+                double t_distance = 0.0;
+                if (TraitDistance(other, i, t_distance))
+                {
+                    dist[other.Name(i)] = t_distance;
                 }
             }
 
             return dist;
         }
+
+        // The same distances as GetTraitDistances(), added to a_Totals instead of
+        // returned, without allocating. a_Totals has a slot for every trait of a_Layout,
+        // the layout of the trait parameters.
+        void AddTraitDistances(const GeneTraits &other, const TraitLayout &a_Layout, double *a_Totals) const
+        {
+            const bool t_same = (other.m_Layout.get() == &a_Layout);
+            for(unsigned int i = 0; i < other.size(); i++)
+            {
+                double t_distance = 0.0;
+                if (!TraitDistance(other, i, t_distance))
+                {
+                    continue;
+                }
+
+                int t_slot = t_same ? static_cast<int>(i) : a_Layout.Slot(other.Name(i));
+                if (t_slot < 0)
+                {
+                    throw std::out_of_range("No parameters for trait " + other.Name(i));
+                }
+
+                a_Totals[t_slot] += t_distance;
+            }
+        }
     };
 
 
@@ -59,6 +59,15 @@ namespace NEAT
         return x * x;
     }
 
+    // Relaxes a CPPN after its inputs were set. A feed-forward CPPN needs a single
+    // sweep, one with loops is activated until it settles, at most a_Depth times.
+    // The CPPN remembers how long that took, the next query skips measuring the
+    // change for half of that.
+    inline void RelaxCPPN(NeuralNetwork &a_CPPN, int a_Depth)
+    {
+        a_CPPN.ActivateUntilStable(1e-9, a_Depth);
+    }
+
 
     // Create an empty genome
     Genome::Genome()
@@ -112,7 +121,11 @@ namespace NEAT
             m_ID = a_G.m_ID;
             m_Depth = a_G.m_Depth;
             m_NeuronRecursionLimit = a_G.m_NeuronRecursionLimit;
-            m_NeuronGenes = a_G.m_NeuronGenes;
+            // NeuronGene's assignment skips the parameters and traits of inputs and
+            // bias neurons, so the genes are copy-constructed. This way an assigned
+            // genome is the same as a copy-constructed or moved one.
+            m_NeuronGenes.clear();
+            m_NeuronGenes.insert(m_NeuronGenes.end(), a_G.m_NeuronGenes.begin(), a_G.m_NeuronGenes.end());
             m_LinkGenes = a_G.m_LinkGenes;
             m_GenomeGene = a_G.m_GenomeGene;
             m_Fitness = a_G.m_Fitness;
@@ -124,6 +137,7 @@ namespace NEAT
             m_PhenotypeBehavior = a_G.m_PhenotypeBehavior;
             m_initial_num_neurons = a_G.m_initial_num_neurons;
             m_initial_num_links = a_G.m_initial_num_links;
+            InvalidateIndexes();
 #ifdef USE_BOOST_PYTHON
             m_behavior = a_G.m_behavior;
 #endif
@@ -132,6 +146,78 @@ namespace NEAT
         return *this;
     }
     
+    // move constructor
+    Genome::Genome(Genome &&a_G) noexcept
+        : m_ID(a_G.m_ID),
+          m_NumInputs(a_G.m_NumInputs),
+          m_NumOutputs(a_G.m_NumOutputs),
+          m_Fitness(a_G.m_Fitness),
+          m_AdjustedFitness(a_G.m_AdjustedFitness),
+          m_Depth(a_G.m_Depth),
+          m_NeuronRecursionLimit(a_G.m_NeuronRecursionLimit),
+          m_OffspringAmount(a_G.m_OffspringAmount),
+          // the genes keep their positions, so the indexes stay valid
+          m_NeuronIndex(std::move(a_G.m_NeuronIndex)),
+          m_LinkIndex(std::move(a_G.m_LinkIndex)),
+          m_InnovationIndex(std::move(a_G.m_InnovationIndex)),
+          m_NeuronsIndexed(a_G.m_NeuronsIndexed),
+          m_LinksIndexed(a_G.m_LinksIndexed),
+          m_NeuronGenes(std::move(a_G.m_NeuronGenes)),
+          m_LinkGenes(std::move(a_G.m_LinkGenes)),
+          m_Evaluated(a_G.m_Evaluated),
+          m_initial_num_neurons(a_G.m_initial_num_neurons),
+          m_initial_num_links(a_G.m_initial_num_links),
+          m_PhenotypeBehavior(a_G.m_PhenotypeBehavior)
+#ifdef USE_BOOST_PYTHON
+          , m_behavior(a_G.m_behavior)
+#endif
+    {
+        m_GenomeGene.m_Traits = std::move(a_G.m_GenomeGene.m_Traits);
+
+        a_G.m_NeuronGenes.clear();
+        a_G.m_LinkGenes.clear();
+        a_G.InvalidateIndexes();
+    }
+
+    // move assignment operator
+    Genome &Genome::operator=(Genome &&a_G) noexcept
+    {
+        if (this != &a_G)
+        {
+            m_ID = a_G.m_ID;
+            m_Depth = a_G.m_Depth;
+            m_NeuronRecursionLimit = a_G.m_NeuronRecursionLimit;
+            m_NeuronGenes = std::move(a_G.m_NeuronGenes);
+            m_LinkGenes = std::move(a_G.m_LinkGenes);
+            m_GenomeGene.m_Traits = std::move(a_G.m_GenomeGene.m_Traits);
+            m_Fitness = a_G.m_Fitness;
+            m_AdjustedFitness = a_G.m_AdjustedFitness;
+            m_NumInputs = a_G.m_NumInputs;
+            m_NumOutputs = a_G.m_NumOutputs;
+            m_OffspringAmount = a_G.m_OffspringAmount;
+            m_Evaluated = a_G.m_Evaluated;
+            m_PhenotypeBehavior = a_G.m_PhenotypeBehavior;
+            m_initial_num_neurons = a_G.m_initial_num_neurons;
+            m_initial_num_links = a_G.m_initial_num_links;
+#ifdef USE_BOOST_PYTHON
+            m_behavior = a_G.m_behavior;
+#endif
+
+            // the genes keep their positions, so the indexes stay valid
+            m_NeuronIndex = std::move(a_G.m_NeuronIndex);
+            m_LinkIndex = std::move(a_G.m_LinkIndex);
+            m_InnovationIndex = std::move(a_G.m_InnovationIndex);
+            m_NeuronsIndexed = a_G.m_NeuronsIndexed;
+            m_LinksIndexed = a_G.m_LinksIndexed;
+
+            a_G.m_NeuronGenes.clear();
+            a_G.m_LinkGenes.clear();
+            a_G.InvalidateIndexes();
+        }
+
+        return *this;
+    }
+
     // New constructor that creates a fully-connected CTRNN
     Genome::Genome(unsigned int a_ID,
                    unsigned int a_NumInputs,
@@ -157,14 +243,14 @@ namespace NEAT
             {
                 NeuronGene n = NeuronGene(INPUT, t_nnum, 0.0);
                 // Initialize the traits
-                n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+                n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
                 m_NeuronGenes.push_back(n);
                 t_nnum++;
             }
             // add the bias
             NeuronGene n = NeuronGene(BIAS, t_nnum, 0.0);
             // Initialize the traits
-            n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
         
             m_NeuronGenes.push_back(n);
             t_nnum++;
@@ -177,7 +263,7 @@ namespace NEAT
             {
                 NeuronGene n = NeuronGene(INPUT, t_nnum, 0.0);
                 // Initialize the traits
-                n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+                n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
             
                 m_NeuronGenes.push_back(n);
                 t_nnum++;
@@ -195,7 +281,7 @@ namespace NEAT
                          (a_Parameters.MinNeuronBias + a_Parameters.MaxNeuronBias) / 2.0f,
                          a_OutputActType);
             // Initialize the traits
-            t_ngene.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
         
             m_NeuronGenes.push_back(t_ngene);
             t_nnum++;
@@ -211,7 +297,7 @@ namespace NEAT
                          (a_Parameters.MinNeuronBias + a_Parameters.MaxNeuronBias) / 2.0f,
                          a_HiddenActType);
             // Initialize the traits
-            t_ngene.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
             t_ngene.m_SplitY = 0.5;
         
             m_NeuronGenes.push_back(t_ngene);
@@ -226,14 +312,14 @@ namespace NEAT
                 // add the link
                 // created with zero weights. needs future random initialization. !!!!!!!!
                 LinkGene l = LinkGene(j + 1, i + 1, t_innovnum, 0.0, false);
-                l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                 m_LinkGenes.push_back(l);
                 t_innovnum++;
             }
         }
     
         // Also initialize the Genome's traits
-        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, t_RNG);
+        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, a_Parameters.GenomeTraitLayout(), t_RNG);
     
         m_Evaluated = false;
         m_NumInputs = a_NumInputs;
@@ -282,14 +368,14 @@ namespace NEAT
             {
                 NeuronGene n = NeuronGene(INPUT, t_nnum, 0.0);
                 // Initialize the traits
-                n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+                n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
                 m_NeuronGenes.push_back(n);
                 t_nnum++;
             }
             // add the bias
             NeuronGene n = NeuronGene(BIAS, t_nnum, 0.0);
             // Initialize the traits
-            n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
 
             m_NeuronGenes.push_back(n);
             t_nnum++;
@@ -302,7 +388,7 @@ namespace NEAT
             {
                 NeuronGene n = NeuronGene(INPUT, t_nnum, 0.0);
                 // Initialize the traits
-                n.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+                n.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
 
                 m_NeuronGenes.push_back(n);
                 t_nnum++;
@@ -320,7 +406,7 @@ namespace NEAT
                          (a_Parameters.MinNeuronBias + a_Parameters.MaxNeuronBias) / 2.0f,
                          a_OutputActType);
             // Initialize the traits
-            t_ngene.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
 
             m_NeuronGenes.push_back(t_ngene);
             t_nnum++;
@@ -337,7 +423,7 @@ namespace NEAT
                          (a_Parameters.MinNeuronBias + a_Parameters.MaxNeuronBias) / 2.0f,
                          UNSIGNED_STEP);
             // Initialize the traits
-            t_ngene.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+            t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
 
             m_NeuronGenes.push_back(t_ngene);
             t_nnum++;
@@ -361,7 +447,7 @@ namespace NEAT
                                  (a_Parameters.MinNeuronBias + a_Parameters.MaxNeuronBias) / 2.0f,
                                  a_HiddenActType);
                     // Initialize the traits
-                    t_ngene.InitTraits(a_Parameters.NeuronTraits, t_RNG);
+                    t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), t_RNG);
                     t_ngene.m_SplitY = initlt;
         
                     m_NeuronGenes.push_back(t_ngene);
@@ -388,7 +474,7 @@ namespace NEAT
                             // created with zero weights. needs future random initialization. !!!!!!!!
                             // init traits (TODO: maybe init empty traits?)
                             LinkGene l = LinkGene(j + last_src_id, i + last_dest_id, t_innovnum, 0.0, false);
-                            l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                            l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                             m_LinkGenes.push_back(l);
                             t_innovnum++;
                         }
@@ -418,7 +504,7 @@ namespace NEAT
                         // created with zero weights. needs future random initialization. !!!!!!!!
                         // init traits (TODO: maybe init empty traits?)
                         LinkGene l = LinkGene(j + last_src_id, i + last_dest_id, t_innovnum, 0.0, false);
-                        l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                        l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                         m_LinkGenes.push_back(l);
                         t_innovnum++;
                     }
@@ -432,7 +518,7 @@ namespace NEAT
                         // add the link
                         // created with zero weights. needs future random initialization. !!!!!!!!
                         LinkGene l = LinkGene(a_NumInputs, i + last_dest_id, t_innovnum, 0.0, false);
-                        l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                        l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                         m_LinkGenes.push_back(l);
                         t_innovnum++;
                     }
@@ -450,7 +536,7 @@ namespace NEAT
                         // add the link
                         // created with zero weights. needs future random initialization. !!!!!!!!
                         LinkGene l = LinkGene(j + 1, i + a_NumInputs + 1, t_innovnum, 0.0, false);
-                        l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                        l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                         m_LinkGenes.push_back(l);
                         t_innovnum++;
                     }
@@ -468,14 +554,14 @@ namespace NEAT
 
                     // created with zero weights. needs future random initialization. !!!!!!!!
                     LinkGene l = LinkGene(t_inp_id, t_outp_id, t_innovnum, 0.0, false);
-                    l.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                    l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                     m_LinkGenes.push_back(l);
                     t_innovnum++;
 
                     if (a_Parameters.DontUseBiasNeuron == false)
                     {
                         LinkGene bl = LinkGene(t_bias_id, t_outp_id, t_innovnum, 0.0, false);
-                        bl.InitTraits(a_Parameters.LinkTraits, t_RNG);
+                        bl.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), t_RNG);
                         m_LinkGenes.push_back(bl);
                         t_innovnum++;
                     }
@@ -484,7 +570,7 @@ namespace NEAT
         }
         
         // Also initialize the Genome's traits
-        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, t_RNG);
+        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, a_Parameters.GenomeTraitLayout(), t_RNG);
 
         m_Evaluated = false;
         m_NumInputs = a_NumInputs;
@@ -578,12 +664,13 @@ namespace NEAT
     LinkGene Genome::GetLinkByInnovID(int a_ID) const
     {
         ASSERT(HasLinkByInnovID(a_ID));
-        for (unsigned int i = 0; i < m_LinkGenes.size(); i++)
-            if (m_LinkGenes[i].InnovationID() == a_ID)
-                return m_LinkGenes[i];
-
-        // should never reach this code
-        throw std::exception();
+        int t_idx = GetLinkIndex(a_ID);
+        if (t_idx == -1)
+        {
+            // should never reach this code
+            throw std::exception();
+        }
+        return m_LinkGenes[t_idx];
     }
 
     NeuronGene Genome::GetNeuronByIndex(int a_idx) const
@@ -625,21 +712,76 @@ namespace NEAT
         m_Evaluated = false;
     }
 
+    bool neuron_compare(const NeuronGene &a_ls, const NeuronGene &a_rs)
+    {
+        return a_ls.ID() < a_rs.ID();
+    }
+
+    bool link_compare(const LinkGene &a_ls, const LinkGene &a_rs)
+    {
+        return a_ls.InnovationID() < a_rs.InnovationID();
+    }
+
+    // the key of a link in m_LinkIndex (neuron IDs are positive)
+    inline unsigned long long LinkKey(int a_FromID, int a_ToID)
+    {
+        return (static_cast<unsigned long long>(static_cast<unsigned int>(a_FromID)) << 32) |
+               static_cast<unsigned int>(a_ToID);
+    }
+
+    void Genome::IndexNeurons() const
+    {
+        if ((m_NeuronsIndexed == 0) || (m_NeuronsIndexed > NumNeurons()))
+        {
+            m_NeuronIndex.clear();
+            m_NeuronIndex.reserve(NumNeurons());
+            m_NeuronsIndexed = 0;
+        }
+
+        // only the appended genes, the first one of an ID wins like in a scan
+        for (unsigned int i = m_NeuronsIndexed; i < NumNeurons(); i++)
+        {
+            m_NeuronIndex.emplace(m_NeuronGenes[i].ID(), i);
+        }
+        m_NeuronsIndexed = NumNeurons();
+    }
+
+    void Genome::IndexLinks() const
+    {
+        if ((m_LinksIndexed == 0) || (m_LinksIndexed > NumLinks()))
+        {
+            m_LinkIndex.clear();
+            m_LinkIndex.reserve(NumLinks());
+            m_InnovationIndex.clear();
+            m_InnovationIndex.reserve(NumLinks());
+            m_LinksIndexed = 0;
+        }
+
+        for (unsigned int i = m_LinksIndexed; i < NumLinks(); i++)
+        {
+            m_LinkIndex.emplace(LinkKey(m_LinkGenes[i].FromNeuronID(), m_LinkGenes[i].ToNeuronID()), i);
+            m_InnovationIndex.emplace(m_LinkGenes[i].InnovationID(), i);
+        }
+        m_LinksIndexed = NumLinks();
+    }
+
     // A little helper function to find the index of a neuron, given its ID
     // returns -1 if not found
     int Genome::GetNeuronIndex(int a_ID) const
     {
         ASSERT(a_ID > 0);
 
-        for (unsigned int i = 0; i < NumNeurons(); i++)
+        IndexNeurons();
+        std::unordered_map<int, unsigned int>::const_iterator t_it = m_NeuronIndex.find(a_ID);
+        if ((t_it != m_NeuronIndex.end()) && (m_NeuronGenes[t_it->second].ID() != a_ID))
         {
-            if (m_NeuronGenes[i].ID() == a_ID)
-            {
-                return i;
-            }
+            // the genes were changed without InvalidateIndexes()
+            m_NeuronsIndexed = 0;
+            IndexNeurons();
+            t_it = m_NeuronIndex.find(a_ID);
         }
 
-        return -1;
+        return (t_it == m_NeuronIndex.end()) ? -1 : static_cast<int>(t_it->second);
     }
 
     // A little helper function to find the index of a link, given its innovation ID
@@ -649,15 +791,17 @@ namespace NEAT
         ASSERT(a_InnovID > 0);
         ASSERT(NumLinks() > 0);
 
-        for (unsigned int i = 0; i < NumLinks(); i++)
+        IndexLinks();
+        std::unordered_map<int, unsigned int>::const_iterator t_it = m_InnovationIndex.find(a_InnovID);
+        if ((t_it != m_InnovationIndex.end()) && (m_LinkGenes[t_it->second].InnovationID() != a_InnovID))
         {
-            if (m_LinkGenes[i].InnovationID() == a_InnovID)
-            {
-                return i;
-            }
+            // the genes were changed without InvalidateIndexes()
+            m_LinksIndexed = 0;
+            IndexLinks();
+            t_it = m_InnovationIndex.find(a_InnovID);
         }
 
-        return -1;
+        return (t_it == m_InnovationIndex.end()) ? -1 : static_cast<int>(t_it->second);
     }
 
 
@@ -699,15 +843,7 @@ namespace NEAT
         ASSERT(a_ID > 0);
         ASSERT(NumNeurons() > 0);
 
-        for (unsigned int i = 0; i < NumNeurons(); i++)
-        {
-            if (m_NeuronGenes[i].ID() == a_ID)
-            {
-                return true;
-            }
-        }
-
-        return false;
+        return GetNeuronIndex(a_ID) != -1;
     }
 
 
@@ -716,15 +852,20 @@ namespace NEAT
     {
         ASSERT((a_n1id > 0) && (a_n2id > 0));
 
-        for (unsigned int i = 0; i < NumLinks(); i++)
+        IndexLinks();
+        std::unordered_map<unsigned long long, unsigned int>::const_iterator t_it =
+                m_LinkIndex.find(LinkKey(a_n1id, a_n2id));
+        if ((t_it != m_LinkIndex.end()) &&
+            ((m_LinkGenes[t_it->second].FromNeuronID() != a_n1id) ||
+             (m_LinkGenes[t_it->second].ToNeuronID() != a_n2id)))
         {
-            if ((m_LinkGenes[i].FromNeuronID() == a_n1id) && (m_LinkGenes[i].ToNeuronID() == a_n2id))
-            {
-                return true;
-            }
+            // the genes were changed without InvalidateIndexes()
+            m_LinksIndexed = 0;
+            IndexLinks();
+            t_it = m_LinkIndex.find(LinkKey(a_n1id, a_n2id));
         }
 
-        return false;
+        return t_it != m_LinkIndex.end();
     }
 
     bool Genome::HasLoops()
@@ -759,21 +900,119 @@ namespace NEAT
     {
         ASSERT(id > 0);
 
+        return (NumLinks() > 0) && (GetLinkIndex(id) != -1);
+    }
+
+
+    // mixes a value into a structure signature
+    inline void MixSignature(unsigned long long &a_Hash, unsigned long long a_Value)
+    {
+        a_Hash ^= a_Value + 0x9e3779b97f4a7c15ULL + (a_Hash << 6) + (a_Hash >> 2);
+    }
+
+    unsigned long long Genome::StructureSignature() const
+    {
+        unsigned long long t_hash = 0;
+        MixSignature(t_hash, m_NumInputs);
+        MixSignature(t_hash, m_NumOutputs);
+
+        MixSignature(t_hash, NumNeurons());
+        for (unsigned int i = 0; i < NumNeurons(); i++)
+        {
+            MixSignature(t_hash, m_NeuronGenes[i].ID());
+            MixSignature(t_hash, m_NeuronGenes[i].Type());
+        }
+
+        MixSignature(t_hash, NumLinks());
         for (unsigned int i = 0; i < NumLinks(); i++)
         {
-            if (m_LinkGenes[i].InnovationID() == id)
-            {
-                return true;
-            }
+            MixSignature(t_hash, m_LinkGenes[i].FromNeuronID());
+            MixSignature(t_hash, m_LinkGenes[i].ToNeuronID());
+            MixSignature(t_hash, m_LinkGenes[i].IsRecurrent());
         }
 
-        return false;
+        // 0 means "no structure"
+        return (t_hash == 0) ? 1 : t_hash;
     }
 
+    // The Hebbian learning rates of a link, from its "hebb_rate" and "hebb_pre_rate" float traits
+    void GetHebbRates(const LinkGene &a_Link, double &a_HebbRate, double &a_HebbPreRate)
+    {
+        //////////////////////
+        // default values
+        a_HebbRate = 0.3;
+        a_HebbPreRate = 0.1;
+
+        // one lookup per trait, and a trait of another type is simply not used
+        const TraitType *t_trait = a_Link.m_Traits.Find("hebb_rate");
+        if (t_trait != NULL)
+        {
+            if (const double *t_value = boost::get<double>(t_trait))
+            {
+                a_HebbRate = *t_value;
+            }
+        }
+        t_trait = a_Link.m_Traits.Find("hebb_pre_rate");
+        if (t_trait != NULL)
+        {
+            if (const double *t_value = boost::get<double>(t_trait))
+            {
+                a_HebbPreRate = *t_value;
+            }
+        }
+    }
 
     // This builds a fastnetwork structure out from the genome
     void Genome::BuildPhenotype(NeuralNetwork &a_Net) const
     {
+        const unsigned long long t_signature = StructureSignature();
+
+        // The net was built from a genome of the same structure - only the
+        // weights and the neuron parameters can differ, patch them in place.
+        // The net may have been edited directly since (without Invalidate()),
+        // so its neuron types and connections are checked against the genes.
+        bool t_patch = (a_Net.GetStructureSignature() == t_signature) &&
+                       (a_Net.NumInputs() == m_NumInputs) && (a_Net.NumOutputs() == m_NumOutputs) &&
+                       (a_Net.m_neurons.size() == NumNeurons()) && (a_Net.m_connections.size() == NumLinks());
+        for (unsigned int i = 0; t_patch && (i < NumNeurons()); i++)
+        {
+            t_patch = (a_Net.m_neurons[i].m_type == m_NeuronGenes[i].Type());
+        }
+        for (unsigned int i = 0; t_patch && (i < NumLinks()); i++)
+        {
+            const Connection &t_c = a_Net.m_connections[i];
+            t_patch = (t_c.m_source_neuron_idx == GetNeuronIndex(m_LinkGenes[i].FromNeuronID())) &&
+                      (t_c.m_target_neuron_idx == GetNeuronIndex(m_LinkGenes[i].ToNeuronID())) &&
+                      (t_c.m_recur_flag == m_LinkGenes[i].IsRecurrent());
+        }
+
+        if (t_patch)
+        {
+            for (unsigned int i = 0; i < NumNeurons(); i++)
+            {
+                Neuron &t_n = a_Net.m_neurons[i];
+                t_n.m_a = m_NeuronGenes[i].m_A;
+                t_n.m_b = m_NeuronGenes[i].m_B;
+                t_n.m_timeconst = m_NeuronGenes[i].m_TimeConstant;
+                t_n.m_bias = m_NeuronGenes[i].m_Bias;
+                t_n.m_activation_function_type = m_NeuronGenes[i].m_ActFunction;
+                t_n.m_split_y = m_NeuronGenes[i].SplitY();
+                t_n.m_type = m_NeuronGenes[i].Type();
+            }
+            for (unsigned int i = 0; i < NumLinks(); i++)
+            {
+                Connection &t_c = a_Net.m_connections[i];
+                t_c.m_weight = m_LinkGenes[i].GetWeight();
+                GetHebbRates(m_LinkGenes[i], t_c.m_hebb_rate, t_c.m_hebb_pre_rate);
+            }
+
+            a_Net.UpdateParameters();
+            a_Net.Flush();
+            a_Net.FlushBatch();
+            a_Net.FlushCube();
+            return;
+        }
+
         // first clear out the network
         a_Net.Clear();
         a_Net.SetInputOutputDimentions(m_NumInputs, m_NumOutputs);
@@ -803,47 +1042,92 @@ namespace NEAT
             t_c.m_target_neuron_idx = GetNeuronIndex(m_LinkGenes[i].ToNeuronID());
             t_c.m_weight = m_LinkGenes[i].GetWeight();
             t_c.m_recur_flag = m_LinkGenes[i].IsRecurrent();
+            GetHebbRates(m_LinkGenes[i], t_c.m_hebb_rate, t_c.m_hebb_pre_rate);
+
+            a_Net.AddConnection(t_c);
+        }
+
+        a_Net.Flush();
+        a_Net.SetStructureSignature(t_signature);
+
+        // Note however that the RTRL variables are not initialized.
+        // The user must manually call the InitRTRLMatrix() method to do it.
+        // This is because of storage issues. RTRL need not to be used every time.
+    }
 
-            //////////////////////
-            // default values
-            t_c.m_hebb_rate = 0.3;
-            t_c.m_hebb_pre_rate = 0.1;
 
-            // if a float trait "hebb_rate" exists
-            if (m_LinkGenes[i].m_Traits.count("hebb_rate") == 1)
+    // This builds the compact inference-only network out from the genome
+    void Genome::BuildPhenotype(InferenceNetwork &a_Net) const
+    {
+        const unsigned long long t_signature = StructureSignature();
+
+        // same structure - patch the weights and the neuron parameters in place
+        if ((a_Net.m_structure == t_signature) &&
+            (a_Net.m_num_neurons == NumNeurons()) && (a_Net.m_num_links == NumLinks()))
+        {
+            for (unsigned int i = 0; i < NumNeurons(); i++)
             {
-                try
-                {
-                    t_c.m_hebb_rate = boost::get<double>(m_LinkGenes[i].m_Traits.at("hebb_rate").value);
-                }
-                catch(const std::exception &e)
-                {
-                    // do nothing
-                }
+                a_Net.m_act_type[i] = static_cast<unsigned char>(m_NeuronGenes[i].m_ActFunction);
+                a_Net.m_a[i] = m_NeuronGenes[i].m_A;
+                a_Net.m_b[i] = m_NeuronGenes[i].m_B;
+                a_Net.m_bias[i] = m_NeuronGenes[i].m_Bias;
+                a_Net.m_timeconst[i] = m_NeuronGenes[i].m_TimeConstant;
             }
-            // if a float trait "hebb_pre_rate" exists
-            if (m_LinkGenes[i].m_Traits.count("hebb_pre_rate") == 1)
+            for (unsigned int i = 0; i < NumLinks(); i++)
             {
-                try
+                if (a_Net.m_connection_slot[i] != InferenceNetwork::NO_SLOT)
                 {
-                    t_c.m_hebb_pre_rate = boost::get<double>(m_LinkGenes[i].m_Traits.at("hebb_pre_rate").value);
-                }
-                catch(const std::exception &e)
-                {
-                    // do nothing
+                    a_Net.m_weight[a_Net.m_connection_slot[i]] = m_LinkGenes[i].GetWeight();
                 }
             }
 
-            //////////////////////
+            a_Net.Flush();
+            return;
+        }
+
+        // room for every link, the ones into inputs are left out below
+        a_Net.Layout(NumNeurons(), NumLinks());
+        a_Net.m_num_inputs = m_NumInputs;
+        a_Net.m_num_outputs = m_NumOutputs;
 
-            a_Net.AddConnection(t_c);
+        for (unsigned int i = 0; i < NumNeurons(); i++)
+        {
+            a_Net.m_act_type[i] = static_cast<unsigned char>(m_NeuronGenes[i].m_ActFunction);
+            a_Net.m_a[i] = m_NeuronGenes[i].m_A;
+            a_Net.m_b[i] = m_NeuronGenes[i].m_B;
+            a_Net.m_bias[i] = m_NeuronGenes[i].m_Bias;
+            a_Net.m_timeconst[i] = m_NeuronGenes[i].m_TimeConstant;
+            a_Net.m_row_start[i + 1] = 0;
         }
 
-        a_Net.Flush();
+        // count the incoming links of every neuron, then place them in order
+        for (unsigned int i = 0; i < NumLinks(); i++)
+        {
+            unsigned int t_target = GetNeuronIndex(m_LinkGenes[i].ToNeuronID());
+            if (t_target >= m_NumInputs)
+            {
+                a_Net.m_row_start[t_target + 1]++;
+            }
+        }
+        a_Net.BeginRows();
+        for (unsigned int i = 0; i < NumLinks(); i++)
+        {
+            unsigned int t_target = GetNeuronIndex(m_LinkGenes[i].ToNeuronID());
+            if (t_target >= m_NumInputs)
+            {
+                unsigned int t_slot = a_Net.PlaceConnection(i, t_target);
+                a_Net.m_source[t_slot] = GetNeuronIndex(m_LinkGenes[i].FromNeuronID());
+                a_Net.m_weight[t_slot] = m_LinkGenes[i].GetWeight();
+            }
+            else
+            {
+                a_Net.m_connection_slot[i] = InferenceNetwork::NO_SLOT;
+            }
+        }
+        a_Net.EndRows();
 
-        // Note however that the RTRL variables are not initialized.
-        // The user must manually call the InitRTRLMatrix() method to do it.
-        // This is because of storage issues. RTRL need not to be used every time.
+        a_Net.Flush();
+        a_Net.m_structure = t_signature;
     }
 
 
@@ -927,13 +1211,8 @@ namespace NEAT
         BuildPhenotype(t_temp_phenotype);
         t_temp_phenotype.Flush();
 
-        // To ensure network relaxation
+        // To ensure network relaxation (only used if the CPPN has loops)
         int dp = 8;
-        if (!HasLoops())
-        {
-            CalculateDepth();
-            dp = GetDepth();
-        }
 
         // now loop over every potential connection in the substrate and take its weight
 
@@ -972,10 +1251,8 @@ namespace NEAT
                 t_temp_phenotype.Input(t_inputs);
 
                 // activate as many times as deep
-                for (int d = 0; d < dp; d++)
-                {
-                    t_temp_phenotype.Activate();
-                }
+
+                RelaxCPPN(t_temp_phenotype, dp);
 
                 double t_tc = t_temp_phenotype.Output()[NumOutputs() - 2];
                 double t_bias = t_temp_phenotype.Output()[NumOutputs() - 1];
@@ -1184,10 +1461,8 @@ namespace NEAT
             t_temp_phenotype.Input(t_inputs);
 
             // activate as many times as deep
-            for (int d = 0; d < dp; d++)
-            {
-                t_temp_phenotype.Activate();
-            }
+
+            RelaxCPPN(t_temp_phenotype, dp);
 
             // the output is a weight
             double t_link = 0;
@@ -1246,6 +1521,43 @@ namespace NEAT
 
     // Returns the absolute distance between this genome and a_G
     double Genome::CompatibilityDistance(const Genome &a_G, const Parameters &a_Parameters) const
+    {
+        return CompatibilityDistance(a_G, a_Parameters, std::numeric_limits<double>::infinity());
+    }
+
+    // True if every term of the compatibility distance is non-negative,
+    // so that a partial sum is a lower bound of the distance
+    bool DistanceTermsNonNegative(const Parameters &a_Parameters)
+    {
+        if ((a_Parameters.ExcessCoeff < 0) || (a_Parameters.DisjointCoeff < 0) ||
+            (a_Parameters.WeightDiffCoeff < 0) || (a_Parameters.ActivationADiffCoeff < 0) ||
+            (a_Parameters.ActivationBDiffCoeff < 0) || (a_Parameters.TimeConstantDiffCoeff < 0) ||
+            (a_Parameters.BiasDiffCoeff < 0) || (a_Parameters.ActivationFunctionDiffCoeff < 0))
+        {
+            return false;
+        }
+
+        // Python traits compute their own distances, which may be negative
+        const std::map<std::string, TraitParameters> *t_traits[3] =
+                {&a_Parameters.LinkTraits, &a_Parameters.NeuronTraits, &a_Parameters.GenomeTraits};
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            for (auto &it : *t_traits[i])
+            {
+                if ((it.second.m_ImportanceCoeff < 0) || (it.second.type == "pyobject") ||
+                    (it.second.type == "pyclassset"))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Returns the absolute distance between this genome and a_G, or a lower bound
+    // of it once that exceeds a_Bound
+    double Genome::CompatibilityDistance(const Genome &a_G, const Parameters &a_Parameters, double a_Bound) const
     {
         // iterators for moving through the genomes' genes
         std::vector<LinkGene>::const_iterator t_g1;
@@ -1261,9 +1573,27 @@ namespace NEAT
         double t_total_A_difference = 0.0;
         double t_total_B_difference = 0.0;
         double t_total_num_activation_difference = 0.0;
-        std::map<std::string, double> t_total_neuron_trait_difference;
-        std::map<std::string, double> t_total_link_trait_difference;
-        std::map<std::string, double> t_genome_link_trait_difference;
+
+        // the trait differences, one slot per trait in the order of the parameters:
+        // link traits, then neuron traits, then genome traits
+        // on the stack unless there are very many traits
+        const TraitLayout &t_link_traits = a_Parameters.LinkTraitLayout();
+        const TraitLayout &t_neuron_traits = a_Parameters.NeuronTraitLayout();
+        const TraitLayout &t_genome_traits = a_Parameters.GenomeTraitLayout();
+        const unsigned int t_num_link_traits = t_link_traits.size();
+        const unsigned int t_num_neuron_traits = t_neuron_traits.size();
+        const unsigned int t_num_traits = t_num_link_traits + t_num_neuron_traits + t_genome_traits.size();
+        double t_stack_slots[64];
+        std::vector<double> t_heap_slots;
+        double *t_total_link_trait_difference = t_stack_slots;
+        if (t_num_traits > 64)
+        {
+            t_heap_slots.resize(t_num_traits);
+            t_total_link_trait_difference = t_heap_slots.data();
+        }
+        std::fill(t_total_link_trait_difference, t_total_link_trait_difference + t_num_traits, 0.0);
+        double *t_total_neuron_trait_difference = t_total_link_trait_difference + t_num_link_traits;
+        double *t_genome_link_trait_difference = t_total_neuron_trait_difference + t_num_neuron_traits;
 
         // count of matching genes
         double t_num_excess = 0;
@@ -1271,13 +1601,56 @@ namespace NEAT
         double t_num_matching_links = 0;
         double t_num_matching_neurons = 0;
     
-        // calculate genome trait difference here
-        t_genome_link_trait_difference = m_GenomeGene.GetTraitDistances(a_G.m_GenomeGene.m_Traits);
-
         // used for percentage of excess/disjoint genes calculation
         int t_max_genome_size = static_cast<int> (NumLinks()   < a_G.NumLinks())   ? (a_G.NumLinks())   : (NumLinks());
         int t_max_neurons     = static_cast<int> (NumNeurons() < a_G.NumNeurons()) ? (a_G.NumNeurons()) : (NumNeurons());
 
+        // choose between normalizing for genome size or not
+        double t_normalizer = 1.0;
+        if (a_Parameters.NormalizeGenomeSize)
+        {
+            t_normalizer = static_cast<double>(t_max_genome_size);
+        }
+        if (t_normalizer <= 0.0)
+            t_normalizer = 1.0;
+
+        // With all terms non-negative, the distance is at least the excess, disjoint and
+        // weight terms seen so far, which are the cheapest to get. A link gene that does
+        // not match is excess or disjoint, whichever is cheaper is assumed until known.
+        const bool t_bounded = (a_Bound < std::numeric_limits<double>::infinity()) &&
+                               DistanceTermsNonNegative(a_Parameters);
+        const double t_mismatch_coeff = std::min(a_Parameters.ExcessCoeff, a_Parameters.DisjointCoeff) / t_normalizer;
+        if (t_bounded)
+        {
+            // at most this many links can match, from the gene counts and innovation ranges
+            unsigned int t_max_matching = std::min(NumLinks(), a_G.NumLinks());
+            if ((t_max_matching > 0) &&
+                std::is_sorted(m_LinkGenes.begin(), m_LinkGenes.end(), link_compare) &&
+                std::is_sorted(a_G.m_LinkGenes.begin(), a_G.m_LinkGenes.end(), link_compare))
+            {
+                // the genes of each genome within the innovation range of the other
+                std::vector<LinkGene>::const_iterator t_lo1 = std::lower_bound(m_LinkGenes.begin(), m_LinkGenes.end(),
+                                                                              a_G.m_LinkGenes.front(), link_compare);
+                std::vector<LinkGene>::const_iterator t_hi1 = std::upper_bound(m_LinkGenes.begin(), m_LinkGenes.end(),
+                                                                              a_G.m_LinkGenes.back(), link_compare);
+                std::vector<LinkGene>::const_iterator t_lo2 = std::lower_bound(a_G.m_LinkGenes.begin(), a_G.m_LinkGenes.end(),
+                                                                              m_LinkGenes.front(), link_compare);
+                std::vector<LinkGene>::const_iterator t_hi2 = std::upper_bound(a_G.m_LinkGenes.begin(), a_G.m_LinkGenes.end(),
+                                                                              m_LinkGenes.back(), link_compare);
+                t_max_matching = static_cast<unsigned int>(std::min(std::max(t_hi1 - t_lo1, (std::ptrdiff_t) 0),
+                                                                    std::max(t_hi2 - t_lo2, (std::ptrdiff_t) 0)));
+            }
+
+            double t_bound = t_mismatch_coeff * (NumLinks() + a_G.NumLinks() - 2 * t_max_matching);
+            if (t_bound > a_Bound)
+            {
+                return t_bound;
+            }
+        }
+
+        // calculate genome trait difference here
+        m_GenomeGene.AddTraitDistances(a_G.m_GenomeGene.m_Traits, t_genome_traits, t_genome_link_trait_difference);
+
         t_g1 = m_LinkGenes.cbegin();
         t_g2 = a_G.m_LinkGenes.cbegin();
 
@@ -1313,20 +1686,8 @@ namespace NEAT
                     if (t_wdiff < 0) t_wdiff = -t_wdiff; // make sure it is positive
                     t_total_weight_difference += t_wdiff;
 
-                    // calculate link trait difference here
-                    std::map<std::string, double> link_trait_difference = t_g1->GetTraitDistances(t_g2->m_Traits);
-                    // add to the totals
-                    for(auto it = link_trait_difference.cbegin(); it != link_trait_difference.cend(); it++)
-                    {
-                        if (t_total_link_trait_difference.count(it->first) == 0)
-                        {
-                            t_total_link_trait_difference[it->first] = it->second;
-                        }
-                        else
-                        {
-                            t_total_link_trait_difference[it->first] += it->second;
-                        }
-                    }
+                    // calculate link trait difference here and add to the totals
+                    t_g1->AddTraitDistances(t_g2->m_Traits, t_link_traits, t_total_link_trait_difference);
 
                     t_g1++;
                     t_g2++;
@@ -1342,68 +1703,93 @@ namespace NEAT
                     t_g2++;
                 }
             }
+
+            if (t_bounded)
+            {
+                // the rest of the genes can match at most min(rest1, rest2) times
+                double t_rest1 = static_cast<double>(m_LinkGenes.cend() - t_g1);
+                double t_rest2 = static_cast<double>(a_G.m_LinkGenes.cend() - t_g2);
+                double t_max_matching = t_num_matching_links + std::min(t_rest1, t_rest2);
+                double t_bound =
+                        (a_Parameters.ExcessCoeff * (t_num_excess / t_normalizer)) +
+                        (a_Parameters.DisjointCoeff * (t_num_disjoint / t_normalizer)) +
+                        t_mismatch_coeff * std::fabs(t_rest1 - t_rest2) +
+                        (a_Parameters.WeightDiffCoeff * (t_total_weight_difference / std::max(t_max_matching, 1.0)));
+                if (t_bound > a_Bound)
+                {
+                    return t_bound;
+                }
+            }
         }
 
         // find matching neuron IDs
+        // the genes are normally sorted by ID, then the genomes are merge-joined,
+        // otherwise the other genome's neurons are looked up by ID
+        bool t_sorted = std::is_sorted(m_NeuronGenes.begin(), m_NeuronGenes.end(), neuron_compare) &&
+                        std::is_sorted(a_G.m_NeuronGenes.begin(), a_G.m_NeuronGenes.end(), neuron_compare);
+        unsigned int t_j = 0;
         for (unsigned int i = 0; i < NumNeurons(); i++)
         {
+            const NeuronGene &t_n1 = m_NeuronGenes[i];
+
+            // the first neuron of a_G with this ID, if any
+            const NeuronGene *t_n2 = NULL;
+            if (t_sorted)
+            {
+                while ((t_j < a_G.NumNeurons()) && (a_G.m_NeuronGenes[t_j].ID() < t_n1.ID()))
+                {
+                    t_j++;
+                }
+                if ((t_j < a_G.NumNeurons()) && (a_G.m_NeuronGenes[t_j].ID() == t_n1.ID()))
+                {
+                    t_n2 = &a_G.m_NeuronGenes[t_j];
+                }
+            }
+            else if (a_G.NumNeurons() > 0)
+            {
+                int t_idx = a_G.GetNeuronIndex(t_n1.ID());
+                if (t_idx != -1)
+                {
+                    t_n2 = &a_G.m_NeuronGenes[t_idx];
+                }
+            }
+
             // no inputs considered for comparison
-            if ((m_NeuronGenes[i].Type() != INPUT) && (m_NeuronGenes[i].Type() != BIAS))
+            if ((t_n1.Type() != INPUT) && (t_n1.Type() != BIAS))
             {
                 // a match
-                if (a_G.HasNeuronID(m_NeuronGenes[i].ID()))
+                if (t_n2 != NULL)
                 {
                     t_num_matching_neurons++;
 
-                    double t_A_difference = m_NeuronGenes[i].m_A - a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_A;
+                    double t_A_difference = t_n1.m_A - t_n2->m_A;
                     if (t_A_difference < 0.0f) t_A_difference = -t_A_difference;
                     t_total_A_difference += t_A_difference;
 
-                    double t_B_difference = m_NeuronGenes[i].m_B - a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_B;
+                    double t_B_difference = t_n1.m_B - t_n2->m_B;
                     if (t_B_difference < 0.0f) t_B_difference = -t_B_difference;
                     t_total_B_difference += t_B_difference;
 
-                    double t_time_constant_difference =
-                            m_NeuronGenes[i].m_TimeConstant - a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_TimeConstant;
+                    double t_time_constant_difference = t_n1.m_TimeConstant - t_n2->m_TimeConstant;
                     if (t_time_constant_difference < 0.0f) t_time_constant_difference = -t_time_constant_difference;
                     t_total_timeconstant_difference += t_time_constant_difference;
 
-                    double t_bias_difference =
-                            m_NeuronGenes[i].m_Bias - a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_Bias;
+                    double t_bias_difference = t_n1.m_Bias - t_n2->m_Bias;
                     if (t_bias_difference < 0.0f) t_bias_difference = -t_bias_difference;
                     t_total_bias_difference += t_bias_difference;
 
                     // Activation function type difference is found
-                    if (m_NeuronGenes[i].m_ActFunction != a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_ActFunction)
+                    if (t_n1.m_ActFunction != t_n2->m_ActFunction)
                     {
                         t_total_num_activation_difference++;
                     }
 
-                    // calculate and add node trait difference here
-                    std::map<std::string, double> neuron_trait_difference = m_NeuronGenes[i].GetTraitDistances( a_G.GetNeuronByID(m_NeuronGenes[i].ID()).m_Traits );
-                    // add to the totals
-                    for(auto it = neuron_trait_difference.cbegin(); it != neuron_trait_difference.cend(); it++)
-                    {
-                        if (t_total_neuron_trait_difference.count(it->first) == 0)
-                        {
-                            t_total_neuron_trait_difference[it->first] = it->second;
-                        }
-                        else
-                        {
-                            t_total_neuron_trait_difference[it->first] += it->second;
-                        }
-                    }
+                    // calculate node trait difference here and add to the totals
+                    t_n1.AddTraitDistances(t_n2->m_Traits, t_neuron_traits, t_total_neuron_trait_difference);
                 }
             }
         }
 
-        // choose between normalizing for genome size or not
-        double t_normalizer = 1.0;
-        if (a_Parameters.NormalizeGenomeSize)
-        {
-            t_normalizer = static_cast<double>(t_max_genome_size);
-        }
-
         // if there are no matching links, make it 1.0 to avoid divide error
         if (t_num_matching_links <= 0)
             t_num_matching_links = 1;
@@ -1412,9 +1798,6 @@ namespace NEAT
         if (t_num_matching_neurons <= 0)
             t_num_matching_neurons = 1;
 
-        if (t_normalizer <= 0.0)
-            t_normalizer = 1.0;
-
         t_total_distance =
                 (a_Parameters.ExcessCoeff * (t_num_excess / t_normalizer)) +
                 (a_Parameters.DisjointCoeff * (t_num_disjoint / t_normalizer)) +
@@ -1426,17 +1809,20 @@ namespace NEAT
                 (a_Parameters.ActivationFunctionDiffCoeff * (t_total_num_activation_difference / t_num_matching_neurons));
 
         // add trait differences according to each one's coeff
-        for(auto & it : t_total_link_trait_difference)
+        unsigned int t_slot = 0;
+        for(auto & it : a_Parameters.LinkTraits)
         {
-            t_total_distance += (a_Parameters.LinkTraits.at(it.first).m_ImportanceCoeff * it.second) / t_num_matching_links;
+            t_total_distance += (it.second.m_ImportanceCoeff * t_total_link_trait_difference[t_slot++]) / t_num_matching_links;
         }
-        for(auto & it : t_total_neuron_trait_difference)
+        t_slot = 0;
+        for(auto & it : a_Parameters.NeuronTraits)
         {
-            t_total_distance += (a_Parameters.NeuronTraits.at(it.first).m_ImportanceCoeff * it.second) / t_num_matching_neurons;
+            t_total_distance += (it.second.m_ImportanceCoeff * t_total_neuron_trait_difference[t_slot++]) / t_num_matching_neurons;
         }
-        for(auto & it : t_genome_link_trait_difference)
+        t_slot = 0;
+        for(auto & it : a_Parameters.GenomeTraits)
         {
-            t_total_distance += (a_Parameters.GenomeTraits.at(it.first).m_ImportanceCoeff * it.second);
+            t_total_distance += (it.second.m_ImportanceCoeff * t_genome_link_trait_difference[t_slot++]);
         }
 
         return t_total_distance;
@@ -1455,7 +1841,8 @@ namespace NEAT
         if ((NumLinks() == 0) && (a_G.NumLinks() == 0))
             return true;
 
-        double t_total_distance = CompatibilityDistance(a_G, a_Parameters);
+        // stops as soon as it is known to be beyond the treshold
+        double t_total_distance = CompatibilityDistance(a_G, a_Parameters, a_Parameters.CompatTreshold);
 
         if (t_total_distance <= a_Parameters.CompatTreshold)
             return true;  // compatible
@@ -1753,6 +2140,7 @@ namespace NEAT
             {
                 // found it! now erase..
                 m_LinkGenes.erase(t_iter);
+                InvalidateIndexes();
                 break;
             }
         }
@@ -1804,7 +2192,7 @@ namespace NEAT
             // Initialize the traits
             if (a_RNG.RandFloat() < 0.5)
             {
-                t_ngene.InitTraits(a_Parameters.NeuronTraits, a_RNG);
+                t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), a_RNG);
             }
             else
             {   // mate instead of randomizing
@@ -1823,13 +2211,13 @@ namespace NEAT
             // First link
             LinkGene l1 = LinkGene(t_in, t_nid, t_l1id, 1.0, t_recurrentflag);
             // Init the link's traits
-            l1.InitTraits(a_Parameters.LinkTraits, a_RNG);
+            l1.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
             m_LinkGenes.push_back(l1);
 
             // Second link
             LinkGene l2 = LinkGene(t_nid, t_out, t_l2id, t_orig_weight, t_recurrentflag);
             // Init the link's traits
-            l2.InitTraits(a_Parameters.LinkTraits, a_RNG);
+            l2.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
             m_LinkGenes.push_back(l2);
         }
         else
@@ -1914,7 +2302,7 @@ namespace NEAT
             // Initialize the traits
             if (a_RNG.RandFloat() < 0.5)
             {
-                t_ngene.InitTraits(a_Parameters.NeuronTraits, a_RNG);
+                t_ngene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), a_RNG);
             }// mate instead of randomizing
             else
             {
@@ -1930,12 +2318,12 @@ namespace NEAT
             // First link
             LinkGene l1 = LinkGene(t_in, t_nid, t_l1id, 1.0, t_recurrentflag);
             // initialize the link's traits
-            l1.InitTraits(a_Parameters.LinkTraits, a_RNG);
+            l1.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
             m_LinkGenes.push_back(l1);
             // Second link
             LinkGene l2 = LinkGene(t_nid, t_out, t_l2id, t_orig_weight, t_recurrentflag);
             // initialize the link's traits
-            l2.InitTraits(a_Parameters.LinkTraits, a_RNG);
+            l2.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
             m_LinkGenes.push_back(l2);
         }
 
@@ -2152,7 +2540,7 @@ namespace NEAT
         // Create and add the link
         LinkGene l = LinkGene(t_n1id, t_n2id, t_innovid, t_weight, t_MakeRecurrent);
         // init the link's traits
-        l.InitTraits(a_Parameters.LinkTraits, a_RNG);
+        l.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
         m_LinkGenes.push_back(l);
 
         // All done.
@@ -2168,19 +2556,11 @@ namespace NEAT
     // Removes the link with the specified innovation ID
     void Genome::RemoveLinkGene(int a_InnovID)
     {
-        // for iterating through the genes
-        std::vector<LinkGene>::iterator t_curlink = m_LinkGenes.begin();
-
-        while (t_curlink != m_LinkGenes.end())
+        int t_idx = HasLinkByInnovID(a_InnovID) ? GetLinkIndex(a_InnovID) : -1;
+        if (t_idx != -1)
         {
-            if (t_curlink->InnovationID() == a_InnovID)
-            {
-                // found it - erase & quit
-                t_curlink = m_LinkGenes.erase(t_curlink);
-                break;
-            }
-
-            t_curlink++;
+            m_LinkGenes.erase(m_LinkGenes.begin() + t_idx);
+            InvalidateIndexes();
         }
     }
 
@@ -2189,40 +2569,29 @@ namespace NEAT
     // Links connected to this node are also removed
     void Genome::RemoveNeuronGene(int a_ID)
     {
-        // the list of links connected to this neuron
-        std::vector<int> t_link_removal_queue;
-
-        // OK find all links connected to this neuron ID
+        // remove all links connected to this neuron ID in one pass
+        unsigned int t_kept = 0;
         for (unsigned int i = 0; i < NumLinks(); i++)
         {
-            if ((m_LinkGenes[i].FromNeuronID() == a_ID) || (m_LinkGenes[i].ToNeuronID() == a_ID))
+            if ((m_LinkGenes[i].FromNeuronID() != a_ID) && (m_LinkGenes[i].ToNeuronID() != a_ID))
             {
-                // found one, add it
-                t_link_removal_queue.push_back(m_LinkGenes[i].InnovationID());
+                if (t_kept != i)
+                {
+                    m_LinkGenes[t_kept] = m_LinkGenes[i];
+                }
+                t_kept++;
             }
         }
-
-        // Now remove them
-        for (unsigned int i = 0; i < t_link_removal_queue.size(); i++)
-        {
-            RemoveLinkGene(t_link_removal_queue[i]);
-        }
+        m_LinkGenes.erase(m_LinkGenes.begin() + t_kept, m_LinkGenes.end());
 
         // Now is safe to remove the neuron
-        // find it first
-        std::vector<NeuronGene>::iterator t_curneuron = m_NeuronGenes.begin();
-
-        while (t_curneuron != m_NeuronGenes.end())
+        int t_idx = (NumNeurons() > 0) ? GetNeuronIndex(a_ID) : -1;
+        if (t_idx != -1)
         {
-            if (t_curneuron->ID() == a_ID)
-            {
-                // found it, erase and quit
-                m_NeuronGenes.erase(t_curneuron);
-                break;
-            }
-
-            t_curneuron++;
+            m_NeuronGenes.erase(m_NeuronGenes.begin() + t_idx);
         }
+
+        InvalidateIndexes();
     }
 
 
@@ -2600,14 +2969,14 @@ namespace NEAT
     {
         for (auto &m_NeuronGene : m_NeuronGenes)
         {
-            m_NeuronGene.InitTraits(a_Parameters.NeuronTraits, a_RNG);
+            m_NeuronGene.InitTraits(a_Parameters.NeuronTraits, a_Parameters.NeuronTraitLayout(), a_RNG);
         }
         for (auto &m_LinkGene : m_LinkGenes)
         {
-            m_LinkGene.InitTraits(a_Parameters.LinkTraits, a_RNG);
+            m_LinkGene.InitTraits(a_Parameters.LinkTraits, a_Parameters.LinkTraitLayout(), a_RNG);
         }
         
-        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, a_RNG);
+        m_GenomeGene.InitTraits(a_Parameters.GenomeTraits, a_Parameters.GenomeTraitLayout(), a_RNG);
     }
 
     // Perturbs the A parameters of the neuron activation functions
@@ -2715,13 +3084,14 @@ namespace NEAT
 
     bool Genome::Mutate_NeuronTraits(const Parameters &a_Parameters, RNG &a_RNG)
     {
+        const TraitLayout &t_layout = a_Parameters.NeuronTraitLayout();
         bool did_mutate = false;
         for(auto it = m_NeuronGenes.begin(); it != m_NeuronGenes.end(); it++)
         {
             // don't mutate inputs and bias
             if ((it->Type() != INPUT) && (it->Type() != BIAS))
             {
-                if (it->MutateTraits(a_Parameters.NeuronTraits, a_RNG))
+                if (it->MutateTraits(a_Parameters.NeuronTraits, t_layout, a_RNG))
                 {
                     did_mutate = true;
                 }
@@ -2732,10 +3102,11 @@ namespace NEAT
 
     bool Genome::Mutate_LinkTraits(const Parameters &a_Parameters, RNG &a_RNG)
     {
+        const TraitLayout &t_layout = a_Parameters.LinkTraitLayout();
         bool did_mutate = false;
         for(auto it = m_LinkGenes.begin(); it != m_LinkGenes.end(); it++)
         {
-            if ( it->MutateTraits(a_Parameters.LinkTraits, a_RNG) )
+            if ( it->MutateTraits(a_Parameters.LinkTraits, t_layout, a_RNG) )
             {
                 did_mutate = true;
             }
@@ -2745,14 +3116,14 @@ namespace NEAT
     
     bool Genome::Mutate_GenomeTraits(const Parameters &a_Parameters, RNG &a_RNG)
     {
-        return m_GenomeGene.MutateTraits(a_Parameters.GenomeTraits, a_RNG);
+        return m_GenomeGene.MutateTraits(a_Parameters.GenomeTraits, a_Parameters.GenomeTraitLayout(), a_RNG);
     }
 
     // Mate this genome with dad and return the baby
     // This is multipoint mating - genes inherited randomly
     // Disjoint and excess genes are inherited from the fittest parent
     // If fitness is equal, the smaller genome is assumed to be the better one
-    Genome Genome::Mate(Genome &a_Dad, bool a_MateAverage, bool a_InterSpecies, RNG &a_RNG, Parameters &a_Parameters)
+    Genome Genome::Mate(const Genome &a_Dad, bool a_MateAverage, bool a_InterSpecies, RNG &a_RNG, Parameters &a_Parameters) const
     {
         // Cannot mate with itself
         if (GetID() == a_Dad.GetID())
@@ -2772,8 +3143,8 @@ namespace NEAT
 
         // create iterators so we can step through each parents genes and set
         // them to the first gene of each parent
-        std::vector<LinkGene>::iterator t_curMom = m_LinkGenes.begin();
-        std::vector<LinkGene>::iterator t_curDad = a_Dad.m_LinkGenes.begin();
+        std::vector<LinkGene>::const_iterator t_curMom = m_LinkGenes.begin();
+        std::vector<LinkGene>::const_iterator t_curDad = a_Dad.m_LinkGenes.begin();
 
         // this will hold a copy of the gene we wish to add at each step
         LinkGene t_selectedgene(0, 0, -1, 0, false);
@@ -3184,20 +3555,11 @@ namespace NEAT
 
     // Sorts the genes of the genome
     // The neurons by IDs and the links by innovation numbers.
-    bool neuron_compare(NeuronGene a_ls, NeuronGene a_rs)
-    {
-        return a_ls.ID() < a_rs.ID();
-    }
-
-    bool link_compare(LinkGene a_ls, LinkGene a_rs)
-    {
-        return a_ls.InnovationID() < a_rs.InnovationID();
-    }
-
     void Genome::SortGenes()
     {
         std::sort(m_NeuronGenes.begin(), m_NeuronGenes.end(), neuron_compare);
         std::sort(m_LinkGenes.begin(), m_LinkGenes.end(), link_compare);
+        InvalidateIndexes();
     }
 
     unsigned int Genome::NeuronDepth(int a_NeuronID, unsigned int a_Depth)
@@ -3423,72 +3785,33 @@ namespace NEAT
         fprintf(a_file, "GenomeEnd\n\n");
     }
     
-    void Genome::PrintTraits(const std::map< std::string, Trait>& traits) const
+    void Genome::PrintTraits(const GeneTraits& traits) const
     {
-        for(auto t = traits.begin(); t != traits.end(); t++)
+        for(unsigned int t = 0; t < traits.size(); t++)
         {
-            bool doit = false;
-            std::string s = t->second.dep_key;
-            //std::string sv = bs::get<std::string>(t->second.dep_values);
-            if (s != "")
-            {
-                // there is such trait..
-                if (traits.count(s) != 0)
-                {
-                    /*int a; double b; std::string c;
-                    if ((*it).m_Traits[s].value.type() == typeid(int))
-                        a = bs::get<int>((*it).m_Traits[s].value);
-                    if ((*it).m_Traits[s].value.type() == typeid(double))
-                        b = bs::get<double>((*it).m_Traits[s].value);
-                    if ((*it).m_Traits[s].value.type() == typeid(std::string))
-                        c = bs::get<std::string>((*it).m_Traits[s].value);
-
-                    int a1; double b1; std::string c1;
-                    if ((t->second.dep_values).type() == typeid(int))
-                        a1 = bs::get<int>((t->second.dep_values));
-                    if ((t->second.dep_values).type() == typeid(double))
-                        b1 = bs::get<double>((t->second.dep_values));
-                    if ((t->second.dep_values).type() == typeid(std::string))
-                        c1 = bs::get<std::string>((t->second.dep_values));*/
-                
-                    // and it has the right value?
-                    for(long unsigned int ix=0; ix<t->second.dep_values.size(); ix++)
-                    {
-                        if (traits.at(s).value == (t->second.dep_values[ix]))
-                        {
-                            doit = true;
-                            break;
-                        }
-                    }
-                }
-            }
-            else
-            {
-                doit = true;
-            }
-        
-            if (doit)
+            if (traits.Enabled(t))
             {
-                std::cout << t->first << " - ";
-                if (t->second.value.type() == typeid(int))
+                const TraitType &value = traits.m_Values[t];
+                std::cout << traits.Name(t) << " - ";
+                if (value.type() == typeid(int))
                 {
-                    std::cout << bs::get<int>(t->second.value);
+                    std::cout << bs::get<int>(value);
                 }
-                if (t->second.value.type() == typeid(double))
+                if (value.type() == typeid(double))
                 {
-                    std::cout << bs::get<double>(t->second.value);
+                    std::cout << bs::get<double>(value);
                 }
-                if (t->second.value.type() == typeid(std::string))
+                if (value.type() == typeid(std::string))
                 {
-                    std::cout << "\"" << bs::get<std::string>(t->second.value) << "\"";
+                    std::cout << "\"" << bs::get<std::string>(value) << "\"";
                 }
-                if (t->second.value.type() == typeid(intsetelement))
+                if (value.type() == typeid(intsetelement))
                 {
-                    std::cout << (bs::get<intsetelement>(t->second.value)).value;
+                    std::cout << (bs::get<intsetelement>(value)).value;
                 }
-                if (t->second.value.type() == typeid(floatsetelement))
+                if (value.type() == typeid(floatsetelement))
                 {
-                    std::cout << (bs::get<floatsetelement>(t->second.value)).value;
+                    std::cout << (bs::get<floatsetelement>(value)).value;
                 }
             
                 std::cout << ", ";
@@ -3793,6 +4116,8 @@ namespace NEAT
         net.m_connections.reserve((maxNodes * (maxNodes - 1)) / 2);
         net.SetInputOutputDimentions(static_cast<unsigned short>(input_count),
                                      static_cast<unsigned short>(output_count));
+        // the neurons and connections are pushed into the lists directly
+        net.Invalidate();
 
 
         NeuralNetwork t_temp_phenotype(true);
@@ -4111,10 +4436,7 @@ namespace NEAT
                 cppn.Flush();
                 cppn.Input(t_inputs);
 
-                for (int d = 0; d < cppn_depth; d++)
-                {
-                    cppn.Activate();
-                }
+                RelaxCPPN(cppn, cppn_depth);
                 p->children[i]->weight = cppn.Output()[0];
                 if (params.Leo)
                 {
@@ -4305,10 +4627,7 @@ namespace NEAT
 
                     cppn.Input(inputs);
 
-                    for (int d = 0; d < cppn_depth; d++)
-                    {
-                        cppn.Activate();
-                    }
+                    RelaxCPPN(cppn, cppn_depth);
 
                     d_left = Abs(root->children[i]->weight - cppn.Output()[0]);
                     cppn.Flush();
@@ -4317,10 +4636,7 @@ namespace NEAT
                     inputs[root_index] += 2 * (root->width);
                     cppn.Input(inputs);
 
-                    for (int d = 0; d < cppn_depth; d++)
-                    {
-                        cppn.Activate();
-                    }
+                    RelaxCPPN(cppn, cppn_depth);
 
                     d_right = Abs(root->children[i]->weight - cppn.Output()[0]);
                     cppn.Flush();
@@ -4330,10 +4646,7 @@ namespace NEAT
                     inputs[root_index + 1] -= root->width;
                     cppn.Input(inputs);
 
-                    for (int d = 0; d < cppn_depth; d++)
-                    {
-                        cppn.Activate();
-                    }
+                    RelaxCPPN(cppn, cppn_depth);
 
                     d_top = Abs(root->children[i]->weight - cppn.Output()[0]);
                     cppn.Flush();
@@ -4341,10 +4654,7 @@ namespace NEAT
                     inputs[root_index + 1] += 2 * root->width;
                     cppn.Input(inputs);
 
-                    for (int d = 0; d < cppn_depth; d++)
-                    {
-                        cppn.Activate();
-                    }
+                    RelaxCPPN(cppn, cppn_depth);
 
                     d_bottom = Abs(root->children[i]->weight - cppn.Output()[0]);
                     cppn.Flush();
@@ -4486,59 +4796,38 @@ namespace NEAT
     }
 
 #ifdef USE_BOOST_PYTHON
-    py::dict Genome::TraitMap2Dict(const std::map< std::string, Trait>& tmap) const
+    py::dict Genome::TraitMap2Dict(const GeneTraits& tmap) const
     {
         py::dict traits;
-        for(auto tit=tmap.begin(); tit!=tmap.end(); tit++)
+        for(unsigned int i = 0; i < tmap.size(); i++)
         {
-            bool doit = false;
-            if (tit->second.dep_key != "")
-            {
-                // there is such trait..
-                if (tmap.count(tit->second.dep_key) != 0)
-                {
-                    // and it has the right value?
-                    for(long unsigned int ix=0; ix < tit->second.dep_values.size(); ix++)
-                    {
-                        if (tmap.at(tit->second.dep_key).value == tit->second.dep_values[ix])
-                        {
-                            doit = true;
-                            break;
-                        }
-                    }
-                }
-            }
-            else
-            {
-                doit = true;
-            }
-
-            if (doit)
+            if (tmap.Enabled(i))
             {
-                TraitType t = tit->second.value;
+                const TraitType &t = tmap.m_Values[i];
+                const std::string &name = tmap.Name(i);
                 if (t.type() == typeid(int))
                 {
-                    traits[tit->first] = bs::get<int>(t);
+                    traits[name] = bs::get<int>(t);
                 }
                 if (t.type() == typeid(double))
                 {
-                    traits[tit->first] = bs::get<double>(t);
+                    traits[name] = bs::get<double>(t);
                 }
                 if (t.type() == typeid(std::string))
                 {
-                    traits[tit->first] = bs::get<std::string>(t);
+                    traits[name] = bs::get<std::string>(t);
                 }
                 if (t.type() == typeid(intsetelement))
                 {
-                    traits[tit->first] = (bs::get<intsetelement>(t)).value;
+                    traits[name] = (bs::get<intsetelement>(t)).value;
                 }
                 if (t.type() == typeid(floatsetelement))
                 {
-                    traits[tit->first] = (bs::get<floatsetelement>(t)).value;
+                    traits[name] = (bs::get<floatsetelement>(t)).value;
                 }
                 if (t.type() == typeid(py::object))
                 {
-                    traits[tit->first] = bs::get<py::object>(t);
+                    traits[name] = bs::get<py::object>(t);
                 }
             }
         }
@@ -49,8 +49,10 @@
 
 #include <vector>
 #include <queue>
+#include <unordered_map>
 
 #include "NeuralNetwork.h"
+#include "InferenceNetwork.h"
 #include "Substrate.h"
 #include "Innovation.h"
 #include "Genes.h"
@@ -109,6 +111,20 @@ namespace NEAT
         // how many individuals this genome should spawn
         double m_OffspringAmount;
 
+        // Lookup indexes over the genes: neuron ID -> index, (from, to) neuron IDs -> link index
+        // and innovation ID -> link index. They are caches, built on the first lookup and
+        // extended when genes are appended. Every method that removes, reorders or replaces
+        // genes (assignment, SortGenes(), the mutations) calls InvalidateIndexes() and they
+        // are rebuilt on the next lookup, so a miss is trusted. Not copied with the genome.
+        mutable std::unordered_map<int, unsigned int> m_NeuronIndex;
+        mutable std::unordered_map<unsigned long long, unsigned int> m_LinkIndex;
+        mutable std::unordered_map<int, unsigned int> m_InnovationIndex;
+        mutable unsigned int m_NeuronsIndexed = 0, m_LinksIndexed = 0; // the genes in the indexes
+
+        // bring the indexes up to date with the genes
+        void IndexNeurons() const;
+        void IndexLinks() const;
+
         ////////////////////
         // Private methods
 
@@ -177,6 +193,11 @@ namespace NEAT
         // assignment operator
         Genome &operator=(const Genome &a_g);
 
+        // move constructor and assignment, they take over the genes and their indexes
+        // (noexcept, so that vectors of genomes move them when they grow)
+        Genome(Genome &&a_g) noexcept;
+        Genome &operator=(Genome &&a_g) noexcept;
+
         // comparison operator (nessesary for boost::python)
         // todo: implement a better comparison technique
         bool operator==(Genome const &other) const
@@ -235,6 +256,15 @@ namespace NEAT
         // A little helper function to find the index of a link, given its innovation ID
         int GetLinkIndex(int a_innovid) const;
 
+        // The lookups by ID use indexes that follow appended genes on their own. After
+        // removing, reordering or editing the IDs of genes in m_NeuronGenes or m_LinkGenes
+        // directly, call this (the methods of Genome do it themselves) - until then the
+        // lookups may not find the edited genes.
+        void InvalidateIndexes()
+        {
+            m_NeuronsIndexed = m_LinksIndexed = 0;
+        }
+
         unsigned int NumNeurons() const
         { return static_cast<unsigned int>(m_NeuronGenes.size()); }
 
@@ -315,9 +345,23 @@ namespace NEAT
 
         void SetOffspringAmount(double a_oa);
 
-        // This builds a fastnetwork structure out from the genome
+        // This builds a fastnetwork structure out from the genome.
+        // If the net was last built from a genome of the same structure (see
+        // StructureSignature()), e.g. the parent of a clone that only had its
+        // weights or neuron parameters mutated, it is patched in place in O(N + L)
+        // instead. Its connections are checked against the links first, so a net
+        // edited directly in between is rebuilt. The result is the same either way.
         void BuildPhenotype(NeuralNetwork &net) const;
 
+        // Builds the compact inference-only network (no display data, no learning),
+        // patching it in place like above when the structure is the same
+        void BuildPhenotype(InferenceNetwork &net) const;
+
+        // A hash of everything a phenotype's topology depends on: the neuron IDs
+        // and types and the links between them, in gene order. Weights, neuron
+        // parameters and activation functions do not count. Never 0.
+        unsigned long long StructureSignature() const;
+
         // Projects the phenotype's weights back to the genome
         void DerivePhenotypicChanges(NeuralNetwork &a_Net);
 
@@ -329,7 +373,7 @@ namespace NEAT
 
 #ifdef USE_BOOST_PYTHON
 
-        py::dict TraitMap2Dict(const std::map< std::string, Trait>& tmap) const;
+        py::dict TraitMap2Dict(const GeneTraits& tmap) const;
 
         py::object GetNeuronTraits() const;
 
@@ -348,7 +392,7 @@ namespace NEAT
         // Saves this genome to an already opened file for writing
         void Save(FILE *a_fstream) const;
 
-        void PrintTraits(const std::map< std::string, Trait>& traits) const;
+        void PrintTraits(const GeneTraits& traits) const;
         void PrintAllTraits() const;
 
         // returns the max neuron ID
@@ -373,6 +417,11 @@ namespace NEAT
         // returns the absolute compatibility distance between this genome and a_G
         double CompatibilityDistance(const Genome &a_G, const Parameters &a_Parameters) const;
 
+        // Like CompatibilityDistance(), but may stop as soon as the distance is known to be
+        // above a_Bound, returning a lower bound of it that is above a_Bound. Values up to
+        // a_Bound are exact.
+        double CompatibilityDistance(const Genome &a_G, const Parameters &a_Parameters, double a_Bound) const;
+
         // Calculates the network depth
         void CalculateDepth();
 
@@ -442,7 +491,7 @@ namespace NEAT
         // If the a_averagemating bool is true, then the genes are averaged
         // Disjoint and excess genes are inherited from the fittest parent
         // If fitness is equal, the smaller genome is assumed to be the better one
-        Genome Mate(Genome &a_dad, bool a_averagemating, bool a_interspecies, RNG &a_RNG, Parameters &a_Parameters);
+        Genome Mate(const Genome &a_dad, bool a_averagemating, bool a_interspecies, RNG &a_RNG, Parameters &a_Parameters) const;
 
 
         //////////
@@ -669,6 +718,7 @@ namespace NEAT
         template<class Archive>
         void serialize(Archive & ar, const unsigned int version)
         {
+            InvalidateIndexes();
             ar & m_ID;
             ar & m_NeuronGenes;
             ar & m_LinkGenes;
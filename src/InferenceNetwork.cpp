@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        InferenceNetwork.cpp
+// Description: Implementation of the compact, inference-only phenotype.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include "InferenceNetwork.h"
+#include "NeuralNetwork.h"
+#include "NetworkFile.h"
+#include "MultiNEATAssert.h"
+
+namespace NEAT
+{
+
+const unsigned int InferenceNetwork::NO_SLOT;
+
+InferenceNetwork::InferenceNetwork()
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_num_neurons = m_num_links = m_num_connections = 0;
+    m_structure = 0;
+    m_block = NULL;
+    m_block_size = 0;
+    m_weight = m_a = m_b = m_bias = m_timeconst = NULL;
+    m_activesum = m_activation = m_membrane_potential = NULL;
+    m_row_start = m_source = m_connection_slot = NULL;
+    m_act_type = NULL;
+    m_accuracy = ACTIVATION_EXACT;
+}
+
+InferenceNetwork::InferenceNetwork(const InferenceNetwork &a_Other)
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_num_neurons = m_num_links = m_num_connections = 0;
+    m_structure = 0;
+    m_block = NULL;
+    m_block_size = 0;
+    m_weight = m_a = m_b = m_bias = m_timeconst = NULL;
+    m_activesum = m_activation = m_membrane_potential = NULL;
+    m_row_start = m_source = m_connection_slot = NULL;
+    m_act_type = NULL;
+    m_accuracy = ACTIVATION_EXACT;
+
+    *this = a_Other;
+}
+
+InferenceNetwork &InferenceNetwork::operator=(const InferenceNetwork &a_Other)
+{
+    if (this == &a_Other)
+    {
+        return *this;
+    }
+
+    const unsigned int N = a_Other.m_num_neurons;
+    const unsigned int L = a_Other.m_num_links;
+    const unsigned int C = a_Other.m_num_connections;
+
+    // a mapped network shares the file, only the state is copied
+    if (a_Other.m_mapping)
+    {
+        LayoutState(N);
+        m_mapping = a_Other.m_mapping;
+        m_num_inputs = a_Other.m_num_inputs;
+        m_num_outputs = a_Other.m_num_outputs;
+        m_num_links = L;
+        m_num_connections = C;
+        m_structure = 0;
+        m_accuracy = a_Other.m_accuracy;
+
+        m_weight = a_Other.m_weight;
+        m_a = a_Other.m_a;
+        m_b = a_Other.m_b;
+        m_bias = a_Other.m_bias;
+        m_timeconst = a_Other.m_timeconst;
+        m_row_start = a_Other.m_row_start;
+        m_source = a_Other.m_source;
+        m_connection_slot = NULL;
+        m_act_type = a_Other.m_act_type;
+
+        memcpy(m_activesum, a_Other.m_activesum, N * sizeof(double));
+        memcpy(m_activation, a_Other.m_activation, N * sizeof(double));
+        memcpy(m_membrane_potential, a_Other.m_membrane_potential, N * sizeof(double));
+        return *this;
+    }
+
+    Layout(N, L);
+    m_num_inputs = a_Other.m_num_inputs;
+    m_num_outputs = a_Other.m_num_outputs;
+    m_num_connections = C;
+    m_structure = a_Other.m_structure;
+    m_accuracy = a_Other.m_accuracy;
+
+    if (a_Other.m_row_start)
+    {
+        memcpy(m_weight, a_Other.m_weight, C * sizeof(double));
+        memcpy(m_a, a_Other.m_a, N * sizeof(double));
+        memcpy(m_b, a_Other.m_b, N * sizeof(double));
+        memcpy(m_bias, a_Other.m_bias, N * sizeof(double));
+        memcpy(m_timeconst, a_Other.m_timeconst, N * sizeof(double));
+        memcpy(m_activesum, a_Other.m_activesum, N * sizeof(double));
+        memcpy(m_activation, a_Other.m_activation, N * sizeof(double));
+        memcpy(m_membrane_potential, a_Other.m_membrane_potential, N * sizeof(double));
+        memcpy(m_row_start, a_Other.m_row_start, (N + 1) * sizeof(unsigned int));
+        memcpy(m_source, a_Other.m_source, C * sizeof(unsigned int));
+        memcpy(m_connection_slot, a_Other.m_connection_slot, L * sizeof(unsigned int));
+        memcpy(m_act_type, a_Other.m_act_type, N);
+    }
+    else
+    {
+        m_row_start[0] = 0;
+    }
+
+    return *this;
+}
+
+InferenceNetwork::~InferenceNetwork()
+{
+    delete[] m_block;
+}
+
+size_t InferenceNetwork::BlockSize(unsigned int a_Neurons, unsigned int a_Links)
+{
+    return (a_Links + 7 * static_cast<size_t>(a_Neurons)) * sizeof(double) +
+           (2 * static_cast<size_t>(a_Links) + a_Neurons + 1) * sizeof(unsigned int) +
+           a_Neurons;
+}
+
+// The weights and sources get room for every link, the ones into inputs are simply not used
+void InferenceNetwork::Layout(unsigned int a_Neurons, unsigned int a_Links)
+{
+    m_mapping.reset();
+
+    size_t t_size = BlockSize(a_Neurons, a_Links);
+    if (t_size > m_block_size)
+    {
+        delete[] m_block;
+        m_block = new unsigned char[t_size];
+        m_block_size = t_size;
+    }
+
+    m_num_neurons = a_Neurons;
+    m_num_links = a_Links;
+    m_num_connections = 0;
+    m_structure = 0;
+
+    double *t_d = reinterpret_cast<double *>(m_block);
+    m_weight = t_d;             t_d += a_Links;
+    m_a = t_d;                  t_d += a_Neurons;
+    m_b = t_d;                  t_d += a_Neurons;
+    m_bias = t_d;               t_d += a_Neurons;
+    m_timeconst = t_d;          t_d += a_Neurons;
+    m_activesum = t_d;          t_d += a_Neurons;
+    m_activation = t_d;         t_d += a_Neurons;
+    m_membrane_potential = t_d; t_d += a_Neurons;
+
+    unsigned int *t_u = reinterpret_cast<unsigned int *>(t_d);
+    m_row_start = t_u;          t_u += a_Neurons + 1;
+    m_source = t_u;             t_u += a_Links;
+    m_connection_slot = t_u;    t_u += a_Links;
+
+    m_act_type = reinterpret_cast<unsigned char *>(t_u);
+}
+
+void InferenceNetwork::LayoutState(unsigned int a_Neurons)
+{
+    size_t t_size = 3 * static_cast<size_t>(a_Neurons) * sizeof(double);
+    if (t_size > m_block_size)
+    {
+        delete[] m_block;
+        m_block = new unsigned char[t_size];
+        m_block_size = t_size;
+    }
+
+    m_num_neurons = a_Neurons;
+
+    double *t_d = reinterpret_cast<double *>(m_block);
+    m_activesum = t_d;          t_d += a_Neurons;
+    m_activation = t_d;         t_d += a_Neurons;
+    m_membrane_potential = t_d;
+}
+
+bool InferenceNetwork::LoadMapped(const char *a_Filename, bool a_VerifyChecksum)
+{
+    std::shared_ptr<MappedFile> t_file(new MappedFile());
+    NetworkFileView t_view;
+    if (!t_file->Open(a_Filename) ||
+        !DecodeNetworkFile(t_file->Data(), t_file->Size(), a_VerifyChecksum, t_view))
+    {
+        return false;
+    }
+
+    LayoutState(t_view.m_num_neurons);
+    m_mapping = t_file;
+    m_num_inputs = t_view.m_num_inputs;
+    m_num_outputs = t_view.m_num_outputs;
+    m_num_links = t_view.m_num_links;
+    m_num_connections = t_view.m_num_connections;
+    m_structure = 0;
+
+    // read-only from here on, see m_mapping
+    m_weight = const_cast<double *>(t_view.m_weight);
+    m_a = const_cast<double *>(t_view.m_a);
+    m_b = const_cast<double *>(t_view.m_b);
+    m_bias = const_cast<double *>(t_view.m_bias);
+    m_timeconst = const_cast<double *>(t_view.m_timeconst);
+    m_row_start = const_cast<unsigned int *>(t_view.m_row_start);
+    m_source = const_cast<unsigned int *>(t_view.m_source);
+    m_connection_slot = NULL;
+    m_act_type = const_cast<unsigned char *>(t_view.m_act_type);
+
+    Flush();
+    return true;
+}
+
+void InferenceNetwork::BeginRows()
+{
+    m_row_start[0] = 0;
+    for (unsigned int i = 0; i < m_num_neurons; i++)
+    {
+        m_row_start[i + 1] += m_row_start[i];
+    }
+}
+
+void InferenceNetwork::EndRows()
+{
+    // every m_row_start[i] was advanced to the end of row i, which is the start of row i+1
+    for (unsigned int i = m_num_neurons; i > 0; i--)
+    {
+        m_row_start[i] = m_row_start[i - 1];
+    }
+    m_row_start[0] = 0;
+    m_num_connections = m_row_start[m_num_neurons];
+}
+
+void InferenceNetwork::Build(const std::vector<Neuron> &a_Neurons,
+                             const std::vector<Connection> &a_Connections,
+                             unsigned int a_NumInputs, unsigned int a_NumOutputs)
+{
+    const unsigned int t_num_neurons = static_cast<unsigned int>(a_Neurons.size());
+    const unsigned int t_num_conns = static_cast<unsigned int>(a_Connections.size());
+
+    Layout(t_num_neurons, t_num_conns);
+    m_num_inputs = a_NumInputs;
+    m_num_outputs = a_NumOutputs;
+
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        const Neuron &t_n = a_Neurons[i];
+        m_act_type[i] = static_cast<unsigned char>(t_n.m_activation_function_type);
+        m_a[i] = t_n.m_a;
+        m_b[i] = t_n.m_b;
+        m_bias[i] = t_n.m_bias;
+        m_timeconst[i] = t_n.m_timeconst;
+        m_activesum[i] = 0;
+        m_activation[i] = t_n.m_activation;
+        m_membrane_potential[i] = t_n.m_membrane_potential;
+        m_row_start[i + 1] = 0;
+    }
+
+    // Count the incoming connections of every neuron, then place them in order
+    for (unsigned int i = 0; i < t_num_conns; i++)
+    {
+        unsigned int t_target = a_Connections[i].m_target_neuron_idx;
+        ASSERT(t_target < t_num_neurons);
+        if (t_target >= m_num_inputs)
+        {
+            m_row_start[t_target + 1]++;
+        }
+    }
+    BeginRows();
+    for (unsigned int i = 0; i < t_num_conns; i++)
+    {
+        unsigned int t_target = a_Connections[i].m_target_neuron_idx;
+        if (t_target >= m_num_inputs)
+        {
+            unsigned int t_slot = PlaceConnection(i, t_target);
+            m_source[t_slot] = a_Connections[i].m_source_neuron_idx;
+            m_weight[t_slot] = a_Connections[i].m_weight;
+        }
+        else
+        {
+            m_connection_slot[i] = NO_SLOT;
+        }
+    }
+    EndRows();
+}
+
+void InferenceNetwork::Clear()
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_num_neurons = m_num_links = m_num_connections = 0;
+    m_structure = 0;
+    if (m_mapping)
+    {
+        // the block only has the state, Build() lays it out again
+        m_mapping.reset();
+        m_weight = m_a = m_b = m_bias = m_timeconst = NULL;
+        m_row_start = m_source = m_connection_slot = NULL;
+        m_act_type = NULL;
+    }
+    if (m_row_start)
+    {
+        m_row_start[0] = 0;
+    }
+}
+
+void InferenceNetwork::ComputeSums()
+{
+    for (unsigned int i = m_num_inputs; i < m_num_neurons; i++)
+    {
+        double t_sum = 0;
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            t_sum += m_activation[m_source[k]] * m_weight[k];
+        }
+        m_activesum[i] = t_sum;
+    }
+}
+
+void InferenceNetwork::ApplyActivations()
+{
+    unsigned int t_begin = m_num_inputs;
+    while (t_begin < m_num_neurons)
+    {
+        unsigned int t_end = t_begin + 1;
+        while ((t_end < m_num_neurons) && (m_act_type[t_end] == m_act_type[t_begin]))
+        {
+            t_end++;
+        }
+
+        ActivateSpan(static_cast<ActivationFunction>(m_act_type[t_begin]), m_activesum + t_begin,
+                     m_a + t_begin, m_b + t_begin, m_activation + t_begin, t_end - t_begin, m_accuracy);
+        t_begin = t_end;
+    }
+}
+
+void InferenceNetwork::ActivateFast()
+{
+    ComputeSums();
+
+    if (m_num_inputs < m_num_neurons)
+    {
+        ActivateSpan(UNSIGNED_SIGMOID, m_activesum + m_num_inputs, m_a + m_num_inputs, m_b + m_num_inputs,
+                     m_activation + m_num_inputs, m_num_neurons - m_num_inputs, m_accuracy);
+    }
+}
+
+void InferenceNetwork::Activate()
+{
+    ComputeSums();
+    ApplyActivations();
+}
+
+void InferenceNetwork::ActivateUseInternalBias()
+{
+    ComputeSums();
+
+    for (unsigned int i = m_num_inputs; i < m_num_neurons; i++)
+    {
+        m_activesum[i] += m_bias[i];
+    }
+    ApplyActivations();
+}
+
+void InferenceNetwork::ActivateLeaky(double a_dtime)
+{
+    ComputeSums();
+
+    // the leaky integrator step
+    for (unsigned int i = m_num_inputs; i < m_num_neurons; i++)
+    {
+        double t_const = a_dtime / m_timeconst[i];
+        m_membrane_potential[i] = (1.0 - t_const) * m_membrane_potential[i] + t_const * m_activesum[i];
+        m_activesum[i] = m_membrane_potential[i] + m_bias[i];
+    }
+    ApplyActivations();
+}
+
+void InferenceNetwork::Flush()
+{
+    for (unsigned int i = 0; i < m_num_neurons; i++)
+    {
+        m_activation[i] = 0;
+        m_activesum[i] = 0;
+        m_membrane_potential[i] = 0;
+    }
+}
+
+void InferenceNetwork::Input(const double *a_Inputs, unsigned int a_Count)
+{
+    if (a_Count > m_num_inputs)
+    {
+        a_Count = m_num_inputs;
+    }
+
+    for (unsigned int i = 0; i < a_Count; i++)
+    {
+        m_activation[i] = a_Inputs[i];
+    }
+}
+
+void InferenceNetwork::Input(const std::vector<double> &a_Inputs)
+{
+    Input(a_Inputs.data(), static_cast<unsigned int>(a_Inputs.size()));
+}
+
+#ifdef USE_BOOST_PYTHON
+
+void InferenceNetwork::Input_python_list(const py::list &a_Inputs)
+{
+    unsigned int t_len = static_cast<unsigned int>(py::len(a_Inputs));
+    if (t_len > m_num_inputs)
+    {
+        t_len = m_num_inputs;
+    }
+
+    for (unsigned int i = 0; i < t_len; i++)
+    {
+        m_activation[i] = py::extract<double>(a_Inputs[i]);
+    }
+}
+
+#endif
+
+void InferenceNetwork::Output(double *a_Outputs) const
+{
+    for (unsigned int i = 0; i < m_num_outputs; i++)
+    {
+        a_Outputs[i] = m_activation[m_num_inputs + i];
+    }
+}
+
+std::vector<double> InferenceNetwork::Output() const
+{
+    std::vector<double> t_output(m_num_outputs);
+    Output(t_output.data());
+    return t_output;
+}
+
+} // namespace NEAT
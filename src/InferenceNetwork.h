@@ -0,0 +1,186 @@
+#ifndef _INFERENCENETWORK_H
+#define _INFERENCENETWORK_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        InferenceNetwork.h
+// Description: Compact, inference-only phenotype.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <memory>
+#include "Genes.h"
+#include "ActivationKernels.h"
+
+namespace NEAT
+{
+
+class Neuron;
+class Connection;
+class MappedFile;
+
+//-----------------------------------------------------------------------
+// A phenotype for evaluation only.
+//
+// All of its data - the neuron parameters, the state and the connections in
+// compressed sparse row form - lives in plain arrays carved out of a single
+// memory block. Building it performs at most one allocation, and none at all
+// when the block of a previous build is large enough. There are no per-neuron
+// heap members, no display data and no learning; use NeuralNetwork for
+// visualisation, RTRL and Hebbian learning.
+//
+// The neurons keep the order they have in the genome, so the outputs are the
+// neurons right after the inputs, just like in NeuralNetwork. Activate(),
+// ActivateUseInternalBias() and ActivateLeaky() give the same results as the
+// NeuralNetwork methods of the same name.
+class InferenceNetwork
+{
+    unsigned int m_num_inputs, m_num_outputs;
+    unsigned int m_num_neurons;
+    unsigned int m_num_links;       // all connections it was built from
+    unsigned int m_num_connections; // not counting the ones into inputs
+
+    // see NeuralNetwork::GetStructureSignature()
+    unsigned long long m_structure;
+
+    // the memory block and its size in bytes
+    unsigned char *m_block;
+    size_t m_block_size;
+
+    ///////////////////
+    // Arrays inside the block (doubles first, then the indices, then the bytes)
+    double *m_weight;              // [connection slot]
+    double *m_a, *m_b;             // [neuron]
+    double *m_bias, *m_timeconst;  // [neuron]
+    double *m_activesum;           // [neuron]
+    double *m_activation;          // [neuron]
+    double *m_membrane_potential;  // [neuron]
+
+    // m_row_start[i] .. m_row_start[i+1] are the incoming connections of neuron i
+    unsigned int *m_row_start;
+    unsigned int *m_source;
+    unsigned int *m_connection_slot; // [link], NO_SLOT if it goes into an input
+
+    unsigned char *m_act_type; // ActivationFunction of every neuron
+
+    ActivationAccuracy m_accuracy;
+
+    // Set when the network runs on a file mapped by LoadMapped(). The parameter and
+    // row arrays then point into the file and are never written, the block only
+    // holds the state.
+    std::shared_ptr<MappedFile> m_mapping;
+
+    // the block size needed for this many neurons and connections
+    static size_t BlockSize(unsigned int a_Neurons, unsigned int a_Connections);
+
+    // points the arrays into the block, growing it if needed
+    void Layout(unsigned int a_Neurons, unsigned int a_Links);
+
+    // points the state arrays into the block, growing it if needed, for a mapped network
+    void LayoutState(unsigned int a_Neurons);
+
+    // finishes the rows after m_row_start[i + 1] was set to the number of connections into i
+    void BeginRows();
+    // places link a_Link, in the order they are given, returns its slot
+    unsigned int PlaceConnection(unsigned int a_Link, unsigned int a_Target)
+    {
+        return m_connection_slot[a_Link] = m_row_start[a_Target]++;
+    }
+    // restores m_row_start after all connections were placed
+    void EndRows();
+
+    // activates every non-input neuron on m_activesum, one span kernel call per run of equal functions
+    void ApplyActivations();
+
+    void ComputeSums();
+
+public:
+    static const unsigned int NO_SLOT = 0xFFFFFFFF;
+
+    InferenceNetwork();
+    InferenceNetwork(const InferenceNetwork &a_Other);
+    InferenceNetwork &operator=(const InferenceNetwork &a_Other);
+    ~InferenceNetwork();
+
+    // Builds the network out of NeuralNetwork data, e.g. a HyperNEAT phenotype.
+    // Connections into the inputs are dropped (inputs are never activated).
+    void Build(const std::vector<Neuron> &a_Neurons,
+               const std::vector<Connection> &a_Connections,
+               unsigned int a_NumInputs, unsigned int a_NumOutputs);
+
+    // Makes it empty, the memory block is kept for the next build
+    void Clear();
+
+    // Runs the network straight from a file written by NeuralNetwork::SaveBinary(),
+    // mapped into memory read-only: nothing is parsed or copied, only the state is
+    // allocated. The mapping is shared by copies of the network and released when
+    // the last of them is rebuilt, cleared or destroyed. A mapped network has no
+    // structure signature, so Genome::BuildPhenotype() always rebuilds it.
+    // Returns false if the file can't be read or is damaged (the checksum is only
+    // checked if a_VerifyChecksum is set, the structure always).
+    bool LoadMapped(const char *a_Filename, bool a_VerifyChecksum = true);
+    bool IsMapped() const { return m_mapping != NULL; }
+
+    void ActivateFast();          // assumes unsigned sigmoids everywhere.
+    void Activate();              // any activation functions are supported
+    void ActivateUseInternalBias(); // like Activate() but uses m_bias as well
+    void ActivateLeaky(double a_dtime); // activates in leaky integrator mode
+
+    void Flush(); // clears all activations
+
+    // see ActivationKernels.h, the default is ACTIVATION_EXACT
+    void SetActivationAccuracy(ActivationAccuracy a_Accuracy) { m_accuracy = a_Accuracy; }
+    ActivationAccuracy GetActivationAccuracy() const { return m_accuracy; }
+
+    // a_Count is clipped to the number of inputs
+    void Input(const double *a_Inputs, unsigned int a_Count);
+    void Input(const std::vector<double> &a_Inputs);
+
+#ifdef USE_BOOST_PYTHON
+
+    void Input_python_list(const py::list &a_Inputs);
+
+#endif
+
+    void Output(double *a_Outputs) const;
+    std::vector<double> Output() const;
+
+    // accessor methods
+    unsigned int NumInputs() const { return m_num_inputs; }
+    unsigned int NumOutputs() const { return m_num_outputs; }
+    unsigned int NumNeurons() const { return m_num_neurons; }
+    unsigned int NumConnections() const { return m_num_connections; }
+    size_t MemoryUsage() const { return m_block_size; }
+    unsigned long long GetStructureSignature() const { return m_structure; }
+
+    double GetActivation(unsigned int a_neuron) const { return m_activation[a_neuron]; }
+
+    friend class Genome;
+};
+
+} // namespace NEAT
+
+#endif
@@ -6,16 +6,24 @@
 #define MULTINEAT_MULTINEAT_H
 
 #include "MultiNEATAssert.h"
+#include "Activation.h"
+#include "ActivationKernels.h"
+#include "CompiledNetwork.h"
 #include "Genes.h"
 #include "Genome.h"
+#include "InferenceNetwork.h"
 #include "Innovation.h"
+#include "NetworkFile.h"
 #include "NeuralNetwork.h"
 #include "Parameters.h"
 #include "PhenotypeBehavior.h"
+#include "PhenotypePool.h"
 #include "Population.h"
+#include "QuantizedNetwork.h"
 #include "Random.h"
 #include "Species.h"
 #include "Substrate.h"
+#include "ThreadPool.h"
 #include "Traits.h"
 #include "Utils.h"
 
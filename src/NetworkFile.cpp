@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        NetworkFile.cpp
+// Description: Implementation of the binary network files.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <stdio.h>
+#include "NetworkFile.h"
+#include "NeuralNetwork.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace NEAT
+{
+
+static_assert(sizeof(NetworkFileHeader) == 64, "the header must be 64 bytes");
+static_assert(sizeof(unsigned int) == 4, "the file stores 32-bit indices");
+
+static const char NETWORK_FILE_MAGIC[8] = {'M', 'N', 'E', 'A', 'T', 'N', 'E', 'T'};
+
+// the offsets of the arrays in the payload
+struct NetworkFileSections
+{
+    size_t m_weight;
+    size_t m_a, m_b, m_bias, m_timeconst, m_split_y;
+    size_t m_link_weight, m_hebb_rate, m_hebb_pre_rate;
+    size_t m_row_start, m_source, m_link_source, m_link_target;
+    size_t m_act_type, m_neuron_type, m_recur;
+    size_t m_size;
+
+    NetworkFileSections(size_t a_Neurons, size_t a_Links, size_t a_Connections)
+    {
+        size_t t = 0;
+        m_weight = t;        t += a_Connections * sizeof(double);
+        m_a = t;             t += a_Neurons * sizeof(double);
+        m_b = t;             t += a_Neurons * sizeof(double);
+        m_bias = t;          t += a_Neurons * sizeof(double);
+        m_timeconst = t;     t += a_Neurons * sizeof(double);
+        m_split_y = t;       t += a_Neurons * sizeof(double);
+        m_link_weight = t;   t += a_Links * sizeof(double);
+        m_hebb_rate = t;     t += a_Links * sizeof(double);
+        m_hebb_pre_rate = t; t += a_Links * sizeof(double);
+        m_row_start = t;     t += (a_Neurons + 1) * sizeof(unsigned int);
+        m_source = t;        t += a_Connections * sizeof(unsigned int);
+        m_link_source = t;   t += a_Links * sizeof(unsigned int);
+        m_link_target = t;   t += a_Links * sizeof(unsigned int);
+        m_act_type = t;      t += a_Neurons;
+        m_neuron_type = t;   t += a_Neurons;
+        m_recur = t;         t += a_Links;
+        m_size = (t + 7) & ~static_cast<size_t>(7);
+    }
+};
+
+static bool HostIsLittleEndian()
+{
+    const unsigned int t_one = 1;
+    return *reinterpret_cast<const unsigned char *>(&t_one) == 1;
+}
+
+// FNV-1a over 64-bit words, a_Size is a multiple of 8
+static unsigned long long Checksum(const unsigned char *a_Data, size_t a_Size)
+{
+    unsigned long long t_hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < a_Size; i += 8)
+    {
+        unsigned long long t_word;
+        memcpy(&t_word, a_Data + i, 8);
+        t_hash = (t_hash ^ t_word) * 0x100000001b3ULL;
+    }
+    return t_hash ^ (t_hash >> 32);
+}
+
+bool EncodeNetworkFile(const std::vector<Neuron> &a_Neurons, const std::vector<Connection> &a_Connections,
+                       unsigned int a_NumInputs, unsigned int a_NumOutputs, unsigned long long a_Structure,
+                       std::vector<unsigned char> &a_File)
+{
+    if (!HostIsLittleEndian())
+    {
+        return false;
+    }
+
+    const unsigned int N = static_cast<unsigned int>(a_Neurons.size());
+    const unsigned int L = static_cast<unsigned int>(a_Connections.size());
+    unsigned int K = 0;
+    for (unsigned int i = 0; i < L; i++)
+    {
+        K += (a_Connections[i].m_target_neuron_idx >= static_cast<int>(a_NumInputs)) ? 1 : 0;
+    }
+
+    const NetworkFileSections t_sections(N, L, K);
+    a_File.assign(sizeof(NetworkFileHeader) + t_sections.m_size, 0);
+    unsigned char *t_payload = a_File.data() + sizeof(NetworkFileHeader);
+
+    double *t_weight = reinterpret_cast<double *>(t_payload + t_sections.m_weight);
+    double *t_a = reinterpret_cast<double *>(t_payload + t_sections.m_a);
+    double *t_b = reinterpret_cast<double *>(t_payload + t_sections.m_b);
+    double *t_bias = reinterpret_cast<double *>(t_payload + t_sections.m_bias);
+    double *t_timeconst = reinterpret_cast<double *>(t_payload + t_sections.m_timeconst);
+    double *t_split_y = reinterpret_cast<double *>(t_payload + t_sections.m_split_y);
+    double *t_link_weight = reinterpret_cast<double *>(t_payload + t_sections.m_link_weight);
+    double *t_hebb_rate = reinterpret_cast<double *>(t_payload + t_sections.m_hebb_rate);
+    double *t_hebb_pre_rate = reinterpret_cast<double *>(t_payload + t_sections.m_hebb_pre_rate);
+    unsigned int *t_row_start = reinterpret_cast<unsigned int *>(t_payload + t_sections.m_row_start);
+    unsigned int *t_source = reinterpret_cast<unsigned int *>(t_payload + t_sections.m_source);
+    unsigned int *t_link_source = reinterpret_cast<unsigned int *>(t_payload + t_sections.m_link_source);
+    unsigned int *t_link_target = reinterpret_cast<unsigned int *>(t_payload + t_sections.m_link_target);
+    unsigned char *t_act_type = t_payload + t_sections.m_act_type;
+    unsigned char *t_neuron_type = t_payload + t_sections.m_neuron_type;
+    unsigned char *t_recur = t_payload + t_sections.m_recur;
+
+    for (unsigned int i = 0; i < N; i++)
+    {
+        const Neuron &t_n = a_Neurons[i];
+        t_a[i] = t_n.m_a;
+        t_b[i] = t_n.m_b;
+        t_bias[i] = t_n.m_bias;
+        t_timeconst[i] = t_n.m_timeconst;
+        t_split_y[i] = t_n.m_split_y;
+        t_act_type[i] = static_cast<unsigned char>(t_n.m_activation_function_type);
+        t_neuron_type[i] = static_cast<unsigned char>(t_n.m_type);
+    }
+
+    // the rows, built like InferenceNetwork::Build() builds them
+    for (unsigned int i = 0; i < L; i++)
+    {
+        const Connection &t_c = a_Connections[i];
+        t_link_weight[i] = t_c.m_weight;
+        t_hebb_rate[i] = t_c.m_hebb_rate;
+        t_hebb_pre_rate[i] = t_c.m_hebb_pre_rate;
+        t_link_source[i] = t_c.m_source_neuron_idx;
+        t_link_target[i] = t_c.m_target_neuron_idx;
+        t_recur[i] = t_c.m_recur_flag ? 1 : 0;
+        if (t_c.m_target_neuron_idx >= static_cast<int>(a_NumInputs))
+        {
+            t_row_start[t_c.m_target_neuron_idx + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < N; i++)
+    {
+        t_row_start[i + 1] += t_row_start[i];
+    }
+    std::vector<unsigned int> t_next(t_row_start, t_row_start + N);
+    for (unsigned int i = 0; i < L; i++)
+    {
+        const Connection &t_c = a_Connections[i];
+        if (t_c.m_target_neuron_idx >= static_cast<int>(a_NumInputs))
+        {
+            const unsigned int t_slot = t_next[t_c.m_target_neuron_idx]++;
+            t_source[t_slot] = t_c.m_source_neuron_idx;
+            t_weight[t_slot] = t_c.m_weight;
+        }
+    }
+
+    NetworkFileHeader t_header;
+    memset(&t_header, 0, sizeof(t_header));
+    memcpy(t_header.m_magic, NETWORK_FILE_MAGIC, sizeof(t_header.m_magic));
+    t_header.m_version = NETWORK_FILE_VERSION;
+    t_header.m_header_size = sizeof(NetworkFileHeader);
+    t_header.m_num_inputs = a_NumInputs;
+    t_header.m_num_outputs = a_NumOutputs;
+    t_header.m_num_neurons = N;
+    t_header.m_num_links = L;
+    t_header.m_num_connections = K;
+    t_header.m_structure = a_Structure;
+    t_header.m_payload_size = t_sections.m_size;
+    t_header.m_checksum = Checksum(t_payload, t_sections.m_size);
+    memcpy(a_File.data(), &t_header, sizeof(t_header));
+    return true;
+}
+
+bool DecodeNetworkFile(const unsigned char *a_Data, size_t a_Size, bool a_VerifyChecksum,
+                       NetworkFileView &a_View)
+{
+    NetworkFileHeader t_header;
+    if (!HostIsLittleEndian() || (a_Size < sizeof(t_header)))
+    {
+        return false;
+    }
+    memcpy(&t_header, a_Data, sizeof(t_header));
+
+    if ((memcmp(t_header.m_magic, NETWORK_FILE_MAGIC, sizeof(t_header.m_magic)) != 0) ||
+        (t_header.m_version != NETWORK_FILE_VERSION) ||
+        (t_header.m_header_size != sizeof(NetworkFileHeader)))
+    {
+        return false;
+    }
+
+    const unsigned int N = t_header.m_num_neurons;
+    const unsigned int L = t_header.m_num_links;
+    const unsigned int K = t_header.m_num_connections;
+    const NetworkFileSections t_sections(N, L, K);
+    if ((t_header.m_payload_size != t_sections.m_size) ||
+        (t_sections.m_size > a_Size - sizeof(t_header)) ||
+        (K > L) ||
+        (static_cast<unsigned long long>(t_header.m_num_inputs) + t_header.m_num_outputs > N))
+    {
+        return false;
+    }
+
+    const unsigned char *t_payload = a_Data + sizeof(t_header);
+    if (a_VerifyChecksum && (Checksum(t_payload, t_sections.m_size) != t_header.m_checksum))
+    {
+        return false;
+    }
+
+    a_View.m_num_inputs = t_header.m_num_inputs;
+    a_View.m_num_outputs = t_header.m_num_outputs;
+    a_View.m_num_neurons = N;
+    a_View.m_num_links = L;
+    a_View.m_num_connections = K;
+    a_View.m_structure = t_header.m_structure;
+    a_View.m_weight = reinterpret_cast<const double *>(t_payload + t_sections.m_weight);
+    a_View.m_a = reinterpret_cast<const double *>(t_payload + t_sections.m_a);
+    a_View.m_b = reinterpret_cast<const double *>(t_payload + t_sections.m_b);
+    a_View.m_bias = reinterpret_cast<const double *>(t_payload + t_sections.m_bias);
+    a_View.m_timeconst = reinterpret_cast<const double *>(t_payload + t_sections.m_timeconst);
+    a_View.m_split_y = reinterpret_cast<const double *>(t_payload + t_sections.m_split_y);
+    a_View.m_link_weight = reinterpret_cast<const double *>(t_payload + t_sections.m_link_weight);
+    a_View.m_hebb_rate = reinterpret_cast<const double *>(t_payload + t_sections.m_hebb_rate);
+    a_View.m_hebb_pre_rate = reinterpret_cast<const double *>(t_payload + t_sections.m_hebb_pre_rate);
+    a_View.m_row_start = reinterpret_cast<const unsigned int *>(t_payload + t_sections.m_row_start);
+    a_View.m_source = reinterpret_cast<const unsigned int *>(t_payload + t_sections.m_source);
+    a_View.m_link_source = reinterpret_cast<const unsigned int *>(t_payload + t_sections.m_link_source);
+    a_View.m_link_target = reinterpret_cast<const unsigned int *>(t_payload + t_sections.m_link_target);
+    a_View.m_act_type = t_payload + t_sections.m_act_type;
+    a_View.m_neuron_type = t_payload + t_sections.m_neuron_type;
+    a_View.m_recur = t_payload + t_sections.m_recur;
+
+    // the indices are used unchecked later
+    if ((a_View.m_row_start[0] != 0) || (a_View.m_row_start[N] != K))
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < N; i++)
+    {
+        if ((a_View.m_row_start[i + 1] < a_View.m_row_start[i]) ||
+            ((i < a_View.m_num_inputs) && (a_View.m_row_start[i + 1] != a_View.m_row_start[i])) ||
+            (a_View.m_act_type[i] > SOFTPLUS) || (a_View.m_neuron_type[i] > OUTPUT))
+        {
+            return false;
+        }
+    }
+    for (unsigned int k = 0; k < K; k++)
+    {
+        if (a_View.m_source[k] >= N)
+        {
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < L; i++)
+    {
+        if ((a_View.m_link_source[i] >= N) || (a_View.m_link_target[i] >= N))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+MappedFile::MappedFile()
+{
+    m_data = NULL;
+    m_size = 0;
+    m_mapped = false;
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+    {
+#ifndef _WIN32
+        if (m_mapped)
+        {
+            munmap(const_cast<unsigned char *>(m_data), m_size);
+        }
+        else
+#endif
+        {
+            delete[] m_data;
+        }
+    }
+    m_data = NULL;
+    m_size = 0;
+    m_mapped = false;
+}
+
+bool MappedFile::Open(const char *a_Filename)
+{
+    Close();
+
+#ifndef _WIN32
+    int t_fd = open(a_Filename, O_RDONLY);
+    if (t_fd < 0)
+    {
+        return false;
+    }
+
+    struct stat t_stat;
+    if ((fstat(t_fd, &t_stat) == 0) && (t_stat.st_size > 0))
+    {
+        void *t_map = mmap(NULL, static_cast<size_t>(t_stat.st_size), PROT_READ, MAP_PRIVATE, t_fd, 0);
+        if (t_map != MAP_FAILED)
+        {
+            m_data = static_cast<const unsigned char *>(t_map);
+            m_size = static_cast<size_t>(t_stat.st_size);
+            m_mapped = true;
+        }
+    }
+    close(t_fd);
+    if (m_mapped)
+    {
+        return true;
+    }
+#endif
+
+    // no mapping, read it all at once
+    FILE *t_file = fopen(a_Filename, "rb");
+    if (!t_file)
+    {
+        return false;
+    }
+    fseek(t_file, 0, SEEK_END);
+    long t_size = ftell(t_file);
+    fseek(t_file, 0, SEEK_SET);
+    if (t_size <= 0)
+    {
+        fclose(t_file);
+        return false;
+    }
+
+    unsigned char *t_data = new unsigned char[t_size];
+    if (fread(t_data, 1, t_size, t_file) != static_cast<size_t>(t_size))
+    {
+        delete[] t_data;
+        fclose(t_file);
+        return false;
+    }
+    fclose(t_file);
+
+    m_data = t_data;
+    m_size = static_cast<size_t>(t_size);
+    return true;
+}
+
+} // namespace NEAT
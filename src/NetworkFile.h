@@ -0,0 +1,128 @@
+#ifndef _NETWORKFILE_H
+#define _NETWORKFILE_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        NetworkFile.h
+// Description: Binary network files, loadable in place from a memory mapping.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+#include <vector>
+
+namespace NEAT
+{
+
+class Neuron;
+class Connection;
+
+//-----------------------------------------------------------------------
+// The binary network file (little-endian):
+//
+//     NetworkFileHeader (64 bytes)
+//     the payload, m_payload_size bytes:
+//         doubles:      weight[K], a[N], b[N], bias[N], timeconst[N], split_y[N],
+//                       link weight[L], hebb rate[L], hebb pre rate[L]
+//         unsigned int: row start[N+1], source[K], link source[L], link target[L]
+//         bytes:        activation function[N], neuron type[N], recurrent flag[L]
+//         zeros up to a multiple of 8 bytes
+//
+// N neurons, L connections (the links, in the order of the network) and K of
+// them not going into an input. Those are also stored in compressed sparse
+// row form, grouped by target: the incoming connections of neuron i are
+// row start[i] .. row start[i+1]. That is exactly what InferenceNetwork
+// evaluates, so it can run on a mapped file without copying anything.
+//
+// The checksum covers the payload.
+const unsigned int NETWORK_FILE_VERSION = 1;
+
+struct NetworkFileHeader
+{
+    char m_magic[8]; // "MNEATNET"
+    unsigned int m_version;
+    unsigned int m_header_size;
+    unsigned int m_num_inputs, m_num_outputs;
+    unsigned int m_num_neurons, m_num_links, m_num_connections;
+    unsigned int m_flags; // 0, reserved
+    unsigned long long m_structure; // see NeuralNetwork::GetStructureSignature()
+    unsigned long long m_payload_size;
+    unsigned long long m_checksum;
+};
+
+// The arrays of a network file, pointing into its payload
+struct NetworkFileView
+{
+    unsigned int m_num_inputs, m_num_outputs;
+    unsigned int m_num_neurons, m_num_links, m_num_connections;
+    unsigned long long m_structure;
+
+    const double *m_weight;
+    const double *m_a, *m_b, *m_bias, *m_timeconst, *m_split_y;
+    const double *m_link_weight, *m_hebb_rate, *m_hebb_pre_rate;
+    const unsigned int *m_row_start, *m_source;
+    const unsigned int *m_link_source, *m_link_target;
+    const unsigned char *m_act_type, *m_neuron_type, *m_recur;
+};
+
+// Writes a network into a memory image of the file, false on a big-endian host
+bool EncodeNetworkFile(const std::vector<Neuron> &a_Neurons, const std::vector<Connection> &a_Connections,
+                       unsigned int a_NumInputs, unsigned int a_NumOutputs, unsigned long long a_Structure,
+                       std::vector<unsigned char> &a_File);
+
+// Checks a file image and points a_View into it. The structure is always
+// validated (so a damaged file can't make the network read out of bounds),
+// the checksum only if a_VerifyChecksum is set. Returns false for files that
+// are damaged, of another version or written on a host of other endianness.
+// a_Data must be 8-byte aligned.
+bool DecodeNetworkFile(const unsigned char *a_Data, size_t a_Size, bool a_VerifyChecksum,
+                       NetworkFileView &a_View);
+
+// A read-only file in memory: mapped where the platform supports it, read otherwise
+class MappedFile
+{
+    const unsigned char *m_data;
+    size_t m_size;
+    bool m_mapped;
+
+    // no copies, it owns the mapping
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+public:
+
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const char *a_Filename);
+    void Close();
+
+    const unsigned char *Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+};
+
+} // namespace NEAT
+
+#endif
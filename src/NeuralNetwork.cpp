@@ -30,13 +30,17 @@
 
 
 #include <math.h>
+#include <stdio.h>
 #include <float.h>
 #include <unordered_map>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <iostream>
 #include "NeuralNetwork.h"
+#include "NetworkFile.h"
+#include "Activation.h"
 #include "MultiNEATAssert.h"
 #include "Utils.h"
 
@@ -47,105 +51,6 @@
 namespace NEAT
 {
 
-/////////////////////////////////////
-// The set of activation functions //
-/////////////////////////////////////
-
-
-inline double af_sigmoid_unsigned(double aX, double aSlope, double aShift)
-{
-    return 1.0 / (1.0 + exp( - aSlope * aX - aShift));
-}
-
-inline double af_sigmoid_signed(double aX, double aSlope, double aShift)
-{
-    double tY = af_sigmoid_unsigned(aX, aSlope, aShift);
-    return (tY - 0.5) * 2.0;
-}
-
-inline double af_tanh(double aX, double aSlope, double aShift)
-{
-    return tanh(aX * aSlope);
-}
-
-inline double af_tanh_cubic(double aX, double aSlope, double aShift)
-{
-    return tanh(aX * aX * aX * aSlope);
-}
-
-inline double af_step_signed(double aX, double aShift)
-{
-    double tY;
-    if (aX > aShift)
-    {
-        tY = 1.0;
-    }
-    else
-    {
-        tY = -1.0;
-    }
-
-    return tY;
-}
-
-inline double af_step_unsigned(double aX, double aShift)
-{
-    if (aX > (0.5+aShift))
-    {
-        return 1.0;
-    }
-    else
-    {
-        return 0.0;
-    }
-}
-
-inline double af_gauss_signed(double aX, double aSlope, double aShift)
-{
-    double tY = exp( - aSlope * aX * aX + aShift); // TODO: Need separate a, b per activation function
-    return (tY-0.5)*2.0;
-}
-
-inline double af_gauss_unsigned(double aX, double aSlope, double aShift)
-{
-    return exp( - aSlope * aX * aX + aShift);
-}
-
-inline double af_abs(double aX, double aShift)
-{
-    return ((aX + aShift)< 0.0)? -(aX + aShift): (aX + aShift);
-}
-
-inline double af_sine_signed(double aX, double aFreq, double aShift)
-{
-    return sin(aX * aFreq + aShift);
-}
-
-inline double af_sine_unsigned(double aX, double aFreq, double aShift)
-{
-    double tY = sin((aX * aFreq + aShift) );
-    return (tY + 1.0) / 2.0;
-}
-
-
-inline double af_linear(double aX, double aShift)
-{
-    return (aX + aShift);
-}
-
-
-inline double af_relu(double aX)
-{
-    return (aX > 0)?aX:0;
-}
-
-
-inline double af_softplus(double aX)
-{
-    return log(1 + exp(aX));
-}
-
-
 double unsigned_sigmoid_derivative(double x)
 {
     return x * (1 - x);
@@ -161,6 +66,13 @@ double tanh_derivative(double x)
 ///////////////////////////////////////
 NeuralNetwork::NeuralNetwork(bool a_Minimal)
 {
+    m_plan_valid = false;
+    m_state_dirty = false;
+    m_structure = 0;
+    m_generation = 0;
+    m_stable_iterations = 0;
+    m_precision = PRECISION_DOUBLE;
+
     if (!a_Minimal)
     {
         // build an XOR network
@@ -258,6 +170,13 @@ NeuralNetwork::NeuralNetwork(bool a_Minimal)
 
 NeuralNetwork::NeuralNetwork()
 {
+    m_plan_valid = false;
+    m_state_dirty = false;
+    m_structure = 0;
+    m_generation = 0;
+    m_stable_iterations = 0;
+    m_precision = PRECISION_DOUBLE;
+
     // an empty network
     m_num_inputs = m_num_outputs = 0;
     m_total_error = 0;
@@ -274,302 +193,390 @@ NeuralNetwork::NeuralNetwork()
 
 void NeuralNetwork::InitRTRLMatrix()
 {
-    // Allocate memory for the neurons sensitivity matrices.
-    for (unsigned int i = 0; i < m_neurons.size(); i++)
+    const unsigned int t_num_neurons = static_cast<unsigned int>(m_neurons.size());
+    const unsigned int t_num_rows = (t_num_neurons > m_num_inputs) ? (t_num_neurons - m_num_inputs) : 0;
+
+    // Find the learned weights. Only the first connection between a pair of
+    // neurons is learned, the rest is left alone.
+    std::unordered_map<unsigned long long, unsigned int> t_first;
+    std::vector< std::vector< std::pair<int, unsigned int> > > t_incoming(t_num_rows);
+    for (unsigned int i = 0; i < m_connections.size(); i++)
     {
-        m_neurons[i].m_sensitivity_matrix.resize(m_neurons.size()); // first dimention
-        for (unsigned int j = 0; j < m_neurons.size(); j++)
+        int t_to = m_connections[i].m_target_neuron_idx;
+        int t_from = m_connections[i].m_source_neuron_idx;
+        if ((t_to < static_cast<int>(m_num_inputs)) || (t_to >= static_cast<int>(t_num_neurons)) ||
+            (t_from < 0) || (t_from >= static_cast<int>(t_num_neurons)))
         {
-            m_neurons[i].m_sensitivity_matrix[j].resize(m_neurons.size()); // second dimention
+            continue;
         }
+
+        unsigned long long t_key = (static_cast<unsigned long long>(t_to) << 32) | static_cast<unsigned int>(t_from);
+        if (t_first.insert(std::make_pair(t_key, i)).second)
+        {
+            t_incoming[t_to - m_num_inputs].push_back(std::make_pair(t_from, i));
+        }
+    }
+
+    // group them by target, sorted by source
+    m_rtrl_weight_start.resize(t_num_rows + 1);
+    m_rtrl_weight_connection.clear();
+    m_rtrl_weight_start[0] = 0;
+    for (unsigned int k = 0; k < t_num_rows; k++)
+    {
+        std::sort(t_incoming[k].begin(), t_incoming[k].end());
+        for (unsigned int i = 0; i < t_incoming[k].size(); i++)
+        {
+            m_rtrl_weight_connection.push_back(t_incoming[k][i].second);
+        }
+        m_rtrl_weight_start[k + 1] = static_cast<unsigned int>(m_rtrl_weight_connection.size());
     }
 
+    m_rtrl_sensitivity.resize(t_num_rows * m_rtrl_weight_connection.size());
+    m_rtrl_row.resize(m_rtrl_weight_connection.size());
+
     // now clear it
     FlushCube();
     // clear out the other RTRL stuff as well
     m_total_error = 0;
-    m_total_weight_change.resize(m_connections.size());
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    m_total_weight_change.assign(m_connections.size(), 0.0);
+}
+
+bool NeuralNetwork::RTRLMatchesNetwork() const
+{
+    unsigned int t_num_rows = (m_neurons.size() > m_num_inputs) ? (static_cast<unsigned int>(m_neurons.size()) - m_num_inputs) : 0;
+    return (m_total_weight_change.size() == m_connections.size()) &&
+           (m_rtrl_weight_start.size() == t_num_rows + 1);
+}
+
+// true if the plan was compiled from a network of this shape
+template<typename T>
+bool PlanMatches(const BasicCompiledNetwork<T> &a_Plan, const NeuralNetwork &a_Net)
+{
+    return (a_Plan.NumNeurons() == a_Net.m_neurons.size()) &&
+           (a_Plan.NumConnections() == a_Net.m_connections.size()) &&
+           (a_Plan.NumInputs() == a_Net.m_num_inputs) &&
+           (a_Plan.NumOutputs() == a_Net.m_num_outputs);
+}
+
+template<typename T>
+void CopyWeights(const std::vector<Connection> &a_Connections, BasicCompiledNetwork<T> &a_Plan)
+{
+    for (unsigned int i = 0; i < a_Connections.size(); i++)
     {
-        m_total_weight_change[i] = 0;
+        unsigned int t_slot = a_Plan.ConnectionSlot(i);
+        if (t_slot != CompiledNetwork::NO_SLOT)
+        {
+            a_Plan.SetWeight(t_slot, a_Connections[i].m_weight);
+        }
     }
 }
 
-void NeuralNetwork::ActivateFast()
+void NeuralNetwork::Compile()
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    // keep the current state if the plan still matches the network
+    WriteBack();
+
+    if (m_precision == PRECISION_FLOAT)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        m_plan.Clear();
+        m_plan_float.Build(m_neurons, m_connections, m_num_inputs, m_num_outputs);
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    else
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        m_plan_float.Clear();
+        m_plan.Build(m_neurons, m_connections, m_num_inputs, m_num_outputs);
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    m_plan_valid = true;
+    m_state_dirty = false;
+}
+
+void NeuralNetwork::UpdateParameters()
+{
+    if (!m_plan_valid)
     {
-        double x = m_neurons[i].m_activesum;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-        m_neurons[i].m_activation = y;
+        return;
+    }
+
+    bool t_updated = false;
+    if (m_precision == PRECISION_FLOAT)
+    {
+        t_updated = PlanMatches(m_plan_float, *this) && m_plan_float.UpdateParameters(m_neurons, m_connections);
+    }
+    else
+    {
+        t_updated = PlanMatches(m_plan, *this) && m_plan.UpdateParameters(m_neurons, m_connections);
     }
+
+    if (!t_updated)
+    {
+        WriteBack();
+        m_plan_valid = false;
+    }
+    m_generation++;
 }
 
-void NeuralNetwork::Activate()
+void NeuralNetwork::EnsureCompiled()
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    if (!m_plan_valid)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        Compile();
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+}
+
+void NeuralNetwork::WriteBack()
+{
+    if (m_plan_valid && m_state_dirty)
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        if (m_precision == PRECISION_FLOAT)
+        {
+            if (m_plan_float.NumNeurons() == m_neurons.size())
+            {
+                m_plan_float.WriteBackState(m_neurons);
+            }
+        }
+        else if (m_plan.NumNeurons() == m_neurons.size())
+        {
+            m_plan.WriteBackState(m_neurons);
+        }
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    m_state_dirty = false;
+}
+
+void NeuralNetwork::PushWeights()
+{
+    m_generation++;
+    if (!m_plan_valid)
     {
-        double x = m_neurons[i].m_activesum;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        switch (m_neurons[i].m_activation_function_type)
-        {
-        case SIGNED_SIGMOID:
-            y = af_sigmoid_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SIGMOID:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH:
-            y = af_tanh(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH_CUBIC:
-            y = af_tanh_cubic(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case SIGNED_STEP:
-            y = af_step_signed(x, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_STEP:
-            y = af_step_unsigned(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_GAUSS:
-            y = af_gauss_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_GAUSS:
-            y = af_gauss_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case ABS:
-            y = af_abs(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_SINE:
-            y = af_sine_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SINE:
-            y = af_sine_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case LINEAR:
-            y = af_linear(x, m_neurons[i].m_b);
-            break;
-        case RELU:
-            y = af_relu(x);
-            break;
-        case SOFTPLUS:
-            y = af_softplus(x);
-            break;
-        default:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-
-        }
-        m_neurons[i].m_activation = y;
+        return;
     }
 
+    if (m_precision == PRECISION_FLOAT)
+    {
+        if (m_plan_float.NumConnections() == m_connections.size())
+        {
+            CopyWeights(m_connections, m_plan_float);
+        }
+    }
+    else if (m_plan.NumConnections() == m_connections.size())
+    {
+        CopyWeights(m_connections, m_plan);
+    }
 }
 
-void NeuralNetwork::ActivateUseInternalBias()
+void NeuralNetwork::SetPrecision(NetworkPrecision a_Precision)
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    if (a_Precision != m_precision)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        WriteBack();
+        m_precision = a_Precision;
+        m_plan_valid = false;
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+}
+
+void NeuralNetwork::SetParallelActivation(unsigned int a_Threads, unsigned int a_MinConnections)
+{
+    // both plans share the threads
+    std::shared_ptr<ThreadPool> t_pool;
+    if (a_Threads > 1)
+    {
+        t_pool = (GetParallelThreads() == a_Threads) ? m_plan.GetPool() : std::make_shared<ThreadPool>(a_Threads);
+    }
+    m_plan.SetParallel(t_pool, a_MinConnections);
+    m_plan_float.SetParallel(t_pool, a_MinConnections);
+}
+
+void NeuralNetwork::SetActivationAccuracy(ActivationAccuracy a_Accuracy)
+{
+    m_plan.SetAccuracy(a_Accuracy);
+    m_plan_float.SetAccuracy(a_Accuracy);
+}
+
+void NeuralNetwork::ActivateFast()
+{
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        m_plan_float.ActivateFast();
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    else
     {
-        double x = m_neurons[i].m_activesum + m_neurons[i].m_bias;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        switch (m_neurons[i].m_activation_function_type)
-        {
-        case SIGNED_SIGMOID:
-            y = af_sigmoid_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SIGMOID:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH:
-            y = af_tanh(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH_CUBIC:
-            y = af_tanh_cubic(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case SIGNED_STEP:
-            y = af_step_signed(x, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_STEP:
-            y = af_step_unsigned(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_GAUSS:
-            y = af_gauss_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_GAUSS:
-            y = af_gauss_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case ABS:
-            y = af_abs(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_SINE:
-            y = af_sine_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SINE:
-            y = af_sine_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case LINEAR:
-            y = af_linear(x, m_neurons[i].m_b);
-            break;
-        case RELU:
-            y = af_relu(x);
-            break;
-        case SOFTPLUS:
-            y = af_softplus(x);
-            break;
-        default:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        }
-        m_neurons[i].m_activation = y;
+        m_plan.ActivateFast();
+    }
+    m_state_dirty = true;
+}
+
+void NeuralNetwork::Activate()
+{
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
+    {
+        m_plan_float.Activate();
     }
+    else
+    {
+        m_plan.Activate();
+    }
+    m_state_dirty = true;
+}
 
+void NeuralNetwork::ActivateUseInternalBias()
+{
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
+    {
+        m_plan_float.ActivateUseInternalBias();
+    }
+    else
+    {
+        m_plan.ActivateUseInternalBias();
+    }
+    m_state_dirty = true;
 }
 
 void NeuralNetwork::ActivateLeaky(double a_dtime)
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        m_plan_float.ActivateLeaky(a_dtime);
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    else
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        m_plan.ActivateLeaky(a_dtime);
     }
-    // Now we have the leaky integrator step for the neurons
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    m_state_dirty = true;
+}
+
+void NeuralNetwork::ActivateFeedForward()
+{
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
     {
-        double t_const = a_dtime / m_neurons[i].m_timeconst;
-        m_neurons[i].m_membrane_potential = (1.0 - t_const)
-                * m_neurons[i].m_membrane_potential
-                + t_const * m_neurons[i].m_activesum;
+        m_plan_float.ActivateFeedForward();
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    else
     {
-        double x = m_neurons[i].m_membrane_potential + m_neurons[i].m_bias;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        switch (m_neurons[i].m_activation_function_type)
-        {
-        case SIGNED_SIGMOID:
-            y = af_sigmoid_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SIGMOID:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH:
-            y = af_tanh(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH_CUBIC:
-            y = af_tanh_cubic(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case SIGNED_STEP:
-            y = af_step_signed(x, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_STEP:
-            y = af_step_unsigned(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_GAUSS:
-            y = af_gauss_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_GAUSS:
-            y = af_gauss_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case ABS:
-            y = af_abs(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_SINE:
-            y = af_sine_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SINE:
-            y = af_sine_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case LINEAR:
-            y = af_linear(x, m_neurons[i].m_b);
-            break;
-        case RELU:
-            y = af_relu(x);
-            break;
-        case SOFTPLUS:
-            y = af_softplus(x);
-            break;
-        default:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        }
-        m_neurons[i].m_activation = y;
+        m_plan.ActivateFeedForward();
+    }
+    m_state_dirty = true;
+}
+
+int NeuralNetwork::ActivateUntilStable(double a_Tolerance, int a_MaxIterations)
+{
+    EnsureCompiled();
+
+    const unsigned int t_max = static_cast<unsigned int>(std::max(a_MaxIterations, 0));
+    // only half of the last count goes unmeasured, so one slow call costs the
+    // following fast ones little and the estimate decays geometrically
+    const unsigned int t_unchecked = m_stable_iterations / 2;
+    unsigned int t_steps;
+    if (m_precision == PRECISION_FLOAT)
+    {
+        t_steps = m_plan_float.ActivateUntilStable(a_Tolerance, t_max, t_unchecked);
+    }
+    else
+    {
+        t_steps = m_plan.ActivateUntilStable(a_Tolerance, t_max, t_unchecked);
+    }
+    m_state_dirty = true;
+
+    m_stable_iterations = t_steps;
+
+    return static_cast<int>(t_steps);
+}
+
+bool NeuralNetwork::IsFeedForward()
+{
+    EnsureCompiled();
+    return (m_precision == PRECISION_FLOAT) ? m_plan_float.IsFeedForward() : m_plan.IsFeedForward();
+}
+
+unsigned int NeuralNetwork::NumDenseBlocks()
+{
+    EnsureCompiled();
+    return (m_precision == PRECISION_FLOAT) ? m_plan_float.NumDenseBlocks() : m_plan.NumDenseBlocks();
+}
+
+void NeuralNetwork::ActivateBatch(const double* a_Inputs, size_t a_Batch, double* a_Outputs)
+{
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
+    {
+        m_plan_float.ActivateBatch(a_Inputs, static_cast<unsigned int>(a_Batch), a_Outputs);
+    }
+    else
+    {
+        m_plan.ActivateBatch(a_Inputs, static_cast<unsigned int>(a_Batch), a_Outputs);
+    }
+}
+
+// one step of RunSequence() on a plan
+template<typename Plan>
+void SequenceStep(Plan& a_Plan, SequenceMode a_Mode, double a_TimeStep)
+{
+    switch (a_Mode)
+    {
+    case SEQUENCE_FAST:
+        a_Plan.ActivateFast();
+        break;
+    case SEQUENCE_USE_INTERNAL_BIAS:
+        a_Plan.ActivateUseInternalBias();
+        break;
+    case SEQUENCE_LEAKY:
+        a_Plan.ActivateLeaky(a_TimeStep);
+        break;
+    case SEQUENCE_FEED_FORWARD:
+        a_Plan.ActivateFeedForward();
+        break;
+    default:
+        a_Plan.Activate();
+        break;
+    }
+}
+
+void NeuralNetwork::RunSequence(const double* a_Inputs, size_t a_Steps, double* a_Outputs,
+                                SequenceMode a_Mode, double a_TimeStep, Parameters* a_Adapt)
+{
+    EnsureCompiled();
+    for (size_t t = 0; t < a_Steps; t++)
+    {
+        const double* t_in = a_Inputs + t * m_num_inputs;
+        if (m_precision == PRECISION_FLOAT)
+        {
+            m_plan_float.Input(t_in, m_num_inputs);
+            SequenceStep(m_plan_float, a_Mode, a_TimeStep);
+        }
+        else
+        {
+            m_plan.Input(t_in, m_num_inputs);
+            SequenceStep(m_plan, a_Mode, a_TimeStep);
+        }
+        m_state_dirty = true;
+
+        if (a_Outputs)
+        {
+            double* t_out = a_Outputs + t * m_num_outputs;
+            if (m_precision == PRECISION_FLOAT)
+            {
+                m_plan_float.Output(t_out);
+            }
+            else
+            {
+                m_plan.Output(t_out);
+            }
+        }
+
+        if (a_Adapt)
+        {
+            Adapt(*a_Adapt);
+        }
     }
+}
 
+void NeuralNetwork::FlushBatch()
+{
+    m_plan.FlushBatch();
+    m_plan_float.FlushBatch();
 }
 
 void NeuralNetwork::Flush()
@@ -580,28 +587,32 @@ void NeuralNetwork::Flush()
         m_neurons[i].m_activesum = 0;
         m_neurons[i].m_membrane_potential = 0;
     }
+
+    if (m_plan_valid)
+    {
+        m_plan.Flush();
+        m_plan_float.Flush();
+    }
+    m_state_dirty = false;
 }
 
 void NeuralNetwork::FlushCube()
 {
-    // clear the cube
-    for (unsigned int i = 0; i < m_neurons.size(); i++)
-        for (unsigned int j = 0; j < m_neurons.size(); j++)
-            for (unsigned int k = 0; k < m_neurons.size(); k++)
-                m_neurons[k].m_sensitivity_matrix[i][j] = 0;
+    std::fill(m_rtrl_sensitivity.begin(), m_rtrl_sensitivity.end(), 0.0);
 }
+
 void NeuralNetwork::Input(const std::vector<double>& a_Inputs)
 {
-	unsigned mx = a_Inputs.size();
-	if (mx > m_num_inputs)
-	{
-		mx = m_num_inputs;
-	}
-
-    for (unsigned int i = 0; i < mx; i++)
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
+    {
+        m_plan_float.Input(a_Inputs.data(), static_cast<unsigned int>(a_Inputs.size()));
+    }
+    else
     {
-        m_neurons[i].m_activation = a_Inputs[i];
+        m_plan.Input(a_Inputs.data(), static_cast<unsigned int>(a_Inputs.size()));
     }
+    m_state_dirty = true;
 }
 
 #ifdef USE_BOOST_PYTHON
@@ -626,6 +637,71 @@ void NeuralNetwork::Input_python_list(const py::list& a_Inputs)
     Input(inp);
 }
 
+py::object NeuralNetwork::RunSequence_python(const py::object& a_Inputs, SequenceMode a_Mode,
+                                             double a_TimeStep, Parameters* a_Adapt)
+{
+    const size_t t_steps = py::len(a_Inputs);
+    std::vector<double> t_inputs(t_steps * m_num_inputs, 0.0);
+    std::vector<double> t_outputs(t_steps * m_num_outputs);
+
+    bool t_numpy = false;
+#if BOOST_VERSION >= 106500
+    // (numpy is only asked if it is an array at all, it may not even be loaded)
+    if (PyObject_HasAttrString(a_Inputs.ptr(), "__array_interface__") &&
+        py::extract<pyndarray>(a_Inputs).check())
+    {
+        t_numpy = true;
+
+        // one copy of the whole array, converted to C-contiguous doubles
+        pyndarray t_doubles = py::extract<pyndarray>(a_Inputs)().astype(py::numpy::dtype::get_builtin<double>()).copy();
+        const int t_columns = (t_doubles.get_nd() > 1) ? static_cast<int>(t_doubles.shape(1)) : 1;
+        const double* t_data = reinterpret_cast<const double*>(t_doubles.get_data());
+        for (size_t t = 0; t < t_steps; t++)
+        {
+            for (int i = 0; (i < t_columns) && (i < static_cast<int>(m_num_inputs)); i++)
+            {
+                t_inputs[t * m_num_inputs + i] = t_data[t * t_columns + i];
+            }
+        }
+    }
+    else
+#endif
+    {
+        for (size_t t = 0; t < t_steps; t++)
+        {
+            py::object t_row = a_Inputs[t];
+            const int t_columns = static_cast<int>(py::len(t_row));
+            for (int i = 0; (i < t_columns) && (i < static_cast<int>(m_num_inputs)); i++)
+            {
+                t_inputs[t * m_num_inputs + i] = py::extract<double>(t_row[i]);
+            }
+        }
+    }
+
+    RunSequence(t_inputs.data(), t_steps, t_outputs.data(), a_Mode, a_TimeStep, a_Adapt);
+
+#if BOOST_VERSION >= 106500
+    if (t_numpy)
+    {
+        pyndarray t_result = py::numpy::empty(py::make_tuple(t_steps, m_num_outputs),
+                                              py::numpy::dtype::get_builtin<double>());
+        std::copy(t_outputs.begin(), t_outputs.end(), reinterpret_cast<double*>(t_result.get_data()));
+        return t_result;
+    }
+#endif
+    py::list t_result;
+    for (size_t t = 0; t < t_steps; t++)
+    {
+        py::list t_row;
+        for (unsigned int i = 0; i < m_num_outputs; i++)
+        {
+            t_row.append(t_outputs[t * m_num_outputs + i]);
+        }
+        t_result.append(t_row);
+    }
+    return t_result;
+}
+
 void NeuralNetwork::Input_numpy(const pyndarray& a_Inputs)
 {
     int len = py::len(a_Inputs);
@@ -646,158 +722,175 @@ void NeuralNetwork::Input_numpy(const pyndarray& a_Inputs)
     Input(inp);
 }
 
-#endif
-
-std::vector<double> NeuralNetwork::Output()
+py::tuple NeuralNetwork::Optimize_python(const OptimizationOptions& a_Options) const
 {
-    std::vector<double> t_output;
-    for (unsigned int i = 0; i < m_num_outputs; i++)
+    OptimizationReport t_report;
+    NeuralNetwork t_net = Optimize(a_Options, &t_report);
+    return py::make_tuple(t_net, t_report);
+}
+
+std::string NeuralNetwork::EmitCpp_python(const EmitOptions& a_Options) const
+{
+    std::ostringstream t_source;
+    return EmitCpp(t_source, a_Options) ? t_source.str() : std::string();
+}
+
+#endif
+
+std::vector<double> NeuralNetwork::Output()
+{
+    EnsureCompiled();
+    std::vector<double> t_output(m_num_outputs);
+    if (m_precision == PRECISION_FLOAT)
+    {
+        m_plan_float.Output(t_output.data());
+    }
+    else
     {
-        t_output.emplace_back(m_neurons[i + m_num_inputs].m_activation);
+        m_plan.Output(t_output.data());
     }
     return t_output;
 }
 
-void NeuralNetwork::Adapt(Parameters& a_Parameters)
+// Hebbian learning on a plan and on the connections into inputs, which the plan does not keep
+template<typename T>
+void AdaptPlan(BasicCompiledNetwork<T> &a_Plan, std::vector<Connection> &a_Connections, double a_Limit)
 {
-    // find max absolute magnitude of the weight
-    double t_max_weight = -999999999;
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    const std::vector<unsigned int> &t_extra = a_Plan.InputConnections();
+
+    double t_max_weight = a_Plan.MaxAbsWeight();
+    for (unsigned int i = 0; i < t_extra.size(); i++)
     {
-        if (fabs(m_connections[i].m_weight) > t_max_weight)
-        {
-            t_max_weight = fabs(m_connections[i].m_weight);
-        }
+        t_max_weight = std::max(t_max_weight, fabs(a_Connections[t_extra[i]].m_weight));
     }
 
-    for (unsigned int i = 0; i < m_connections.size(); i++)
-    {
-        /////////////////////////////////////
-        // modify weight of that connection
-        ////
-        double t_incoming_neuron_activation =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation;
-        double t_outgoing_neuron_activation =
-                m_neurons[m_connections[i].m_target_neuron_idx].m_activation;
-        if (m_connections[i].m_weight > 0) // positive weight
-        {
-            double t_delta = (m_connections[i].m_hebb_rate
-                    * (t_max_weight - m_connections[i].m_weight)
-                    * t_incoming_neuron_activation
-                    * t_outgoing_neuron_activation)
-                    + m_connections[i].m_hebb_pre_rate * t_max_weight
-                            * t_incoming_neuron_activation
-                            * (t_outgoing_neuron_activation - 1.0);
-            m_connections[i].m_weight = (m_connections[i].m_weight + t_delta);
-        }
-        else if (m_connections[i].m_weight < 0) // negative weight
-        {
-            // In the inhibatory case, we strengthen the synapse when output is low and
-            // input is high
-            double t_delta = m_connections[i].m_hebb_pre_rate
-                    * (t_max_weight - m_connections[i].m_weight)
-                    * t_incoming_neuron_activation
-                    * (1.0 - t_outgoing_neuron_activation)
-                    - m_connections[i].m_hebb_rate * t_max_weight
-                            * t_incoming_neuron_activation
-                            * t_outgoing_neuron_activation;
-            m_connections[i].m_weight = -(m_connections[i].m_weight + t_delta);
-        }
+    a_Plan.Adapt(t_max_weight, a_Limit);
 
-        Clamp(m_connections[i].m_weight, -a_Parameters.MaxWeight,
-                a_Parameters.MaxWeight);
+    for (unsigned int i = 0; i < t_extra.size(); i++)
+    {
+        Connection &t_c = a_Connections[t_extra[i]];
+        t_c.m_weight = HebbianUpdate(t_c.m_weight, t_c.m_hebb_rate, t_c.m_hebb_pre_rate, t_max_weight,
+                                     a_Plan.GetActivation(t_c.m_source_neuron_idx),
+                                     a_Plan.GetActivation(t_c.m_target_neuron_idx), a_Limit);
     }
+
+    // the connections stay in sync with the plan
+    a_Plan.WriteBackWeights(a_Connections);
 }
 
-int NeuralNetwork::ConnectionExists(int a_to, int a_from)
+void NeuralNetwork::Adapt(Parameters& a_Parameters)
 {
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    EnsureCompiled();
+    if (m_precision == PRECISION_FLOAT)
     {
-        if ((m_connections[i].m_source_neuron_idx == a_from)
-                && (m_connections[i].m_target_neuron_idx == a_to))
-        {
-            return i;
-        }
+        AdaptPlan(m_plan_float, m_connections, a_Parameters.MaxWeight);
     }
-
-    return -1;
+    else
+    {
+        AdaptPlan(m_plan, m_connections, a_Parameters.MaxWeight);
+    }
+    m_generation++;
 }
 
 void NeuralNetwork::RTRL_update_gradients()
 {
-    // for every neuron
+    WriteBack();
+    if (!RTRLMatchesNetwork())
+    {
+        InitRTRLMatrix();
+    }
+
+    const unsigned int t_num_weights = static_cast<unsigned int>(m_rtrl_weight_connection.size());
+    if (t_num_weights == 0)
+    {
+        return;
+    }
+    double* t_row = &m_rtrl_row[0];
+
+    // The rows are updated in place in neuron order, so neuron k sees the new
+    // sensitivities of the neurons before it and the old ones of the rest.
     for (unsigned int k = m_num_inputs; k < m_neurons.size(); k++)
     {
-        // for all possible connections
-        for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
-            // to
-            for (unsigned int j = 0; j < m_neurons.size(); j++) // from
+        double* t_sensitivity = &m_rtrl_sensitivity[(k - m_num_inputs) * t_num_weights];
+
+        double t_derivative = 0;
+        if (m_neurons[k].m_activation_function_type == NEAT::UNSIGNED_SIGMOID)
+        {
+            t_derivative = unsigned_sigmoid_derivative(m_neurons[k].m_activation);
+        }
+        else if (m_neurons[k].m_activation_function_type == NEAT::TANH)
+        {
+            t_derivative = tanh_derivative(m_neurons[k].m_activation);
+        }
+
+        if (t_derivative == 0)
+        {
+            std::fill(t_sensitivity, t_sensitivity + t_num_weights, 0.0);
+            continue;
+        }
+
+        // the sum over the incoming weights of k, for all weights at once
+        std::fill(t_row, t_row + t_num_weights, 0.0);
+        const unsigned int t_begin = m_rtrl_weight_start[k - m_num_inputs];
+        const unsigned int t_end = m_rtrl_weight_start[k - m_num_inputs + 1];
+        for (unsigned int w = t_begin; w < t_end; w++)
+        {
+            const Connection& t_c = m_connections[m_rtrl_weight_connection[w]];
+            if (t_c.m_source_neuron_idx < static_cast<int>(m_num_inputs))
             {
-                int t_idx = ConnectionExists(i, j);
-                if (t_idx != -1)
-                {
-                    //double t_derivative = unsigned_sigmoid_derivative( m_neurons[k].m_activation );
-                    double t_derivative = 0;
-                    if (m_neurons[k].m_activation_function_type
-                            == NEAT::UNSIGNED_SIGMOID)
-                    {
-                        t_derivative = unsigned_sigmoid_derivative(
-                                m_neurons[k].m_activation);
-                    }
-                    else if (m_neurons[k].m_activation_function_type
-                            == NEAT::TANH)
-                    {
-                        t_derivative = tanh_derivative(
-                                m_neurons[k].m_activation);
-                    }
-
-                    double t_sum = 0;
-                    // calculate the other sum
-                    for (unsigned int l = 0; l < m_neurons.size(); l++)
-                    {
-                        int t_l_idx = ConnectionExists(k, l);
-                        if (t_l_idx != -1)
-                        {
-                            t_sum += m_connections[t_l_idx].m_weight
-                                    * m_neurons[l].m_sensitivity_matrix[i][j];
-                        }
-                    }
-
-                    if (i == k)
-                    {
-                        t_sum += m_neurons[j].m_activation;
-                    }
-                    m_neurons[k].m_sensitivity_matrix[i][j] = t_derivative
-                            * t_sum;
-                }
-                else
-                {
-                    m_neurons[k].m_sensitivity_matrix[i][j] = 0;
-                }
+                continue; // the inputs are not sensitive to any weight
             }
 
-    }
+            const double t_weight = t_c.m_weight;
+            const double* t_source = &m_rtrl_sensitivity[(t_c.m_source_neuron_idx - m_num_inputs) * t_num_weights];
+            for (unsigned int p = 0; p < t_num_weights; p++)
+            {
+                t_row[p] += t_weight * t_source[p];
+            }
+        }
 
+        // the direct effect of the weights into k
+        for (unsigned int w = t_begin; w < t_end; w++)
+        {
+            t_row[w] += m_neurons[m_connections[m_rtrl_weight_connection[w]].m_source_neuron_idx].m_activation;
+        }
+
+        for (unsigned int p = 0; p < t_num_weights; p++)
+        {
+            t_sensitivity[p] = t_derivative * t_row[p];
+        }
+    }
 }
 
-// please pay attention. notice here only one output is assumed
 void NeuralNetwork::RTRL_update_error(double a_target)
 {
+    RTRL_update_error(std::vector<double>(1, a_target));
+}
+
+void NeuralNetwork::RTRL_update_error(const std::vector<double>& a_targets)
+{
+    if (!RTRLMatchesNetwork())
+    {
+        InitRTRLMatrix();
+    }
+
+    std::vector<double> t_outputs = Output();
+    const unsigned int t_num_weights = static_cast<unsigned int>(m_rtrl_weight_connection.size());
+    const unsigned int t_count = static_cast<unsigned int>(std::min(a_targets.size(), t_outputs.size()));
+
     // add to total error
-    m_total_error = (a_target - Output()[0]);
-    // adjust each weight
-    for (unsigned int i = 0; i < m_neurons.size(); i++) // to
+    m_total_error = 0;
+    for (unsigned int o = 0; o < t_count; o++)
     {
-        for (unsigned int j = 0; j < m_neurons.size(); j++) // from
+        double t_error = a_targets[o] - t_outputs[o];
+        m_total_error += t_error;
+
+        // output o is neuron m_num_inputs + o, the row o of the sensitivities
+        const double* t_sensitivity = m_rtrl_sensitivity.data() + o * t_num_weights;
+        for (unsigned int w = 0; w < t_num_weights; w++)
         {
-            int t_idx = ConnectionExists(i, j);
-            if (t_idx != -1)
-            {
-                // we know the first output's index is m_num_inputs
-                double t_delta = m_total_error
-                        * m_neurons[m_num_inputs].m_sensitivity_matrix[i][j];
-                m_total_weight_change[t_idx] += t_delta * LEARNING_RATE;
-            }
+            double t_delta = t_error * t_sensitivity[w];
+            m_total_weight_change[m_rtrl_weight_connection[w]] += t_delta * LEARNING_RATE;
         }
     }
 }
@@ -810,6 +903,8 @@ void NeuralNetwork::RTRL_update_weights()
         m_total_weight_change[i] = 0; // clear this out
     }
     m_total_error = 0;
+
+    PushWeights();
 }
 
 void NeuralNetwork::Save(const char* a_filename)
@@ -821,6 +916,8 @@ void NeuralNetwork::Save(const char* a_filename)
 
 void NeuralNetwork::Save(FILE* a_file)
 {
+    WriteBack();
+
     fprintf(a_file, "NNstart\n");
     // save num inputs/outputs and stuff
     fprintf(a_file, "%d %d\n", m_num_inputs, m_num_outputs);
@@ -949,6 +1046,714 @@ bool NeuralNetwork::Load(const char *a_filename)
     return Load(t_DataFile);
 }
 
+// The connections of a network while it is optimized. Connections are only
+// marked dead, new ones are appended, so the surviving ones keep their order.
+struct OptimizerGraph
+{
+    std::vector<Connection> m_connections;
+    std::vector<char> m_connection_alive;
+    std::vector< std::vector<unsigned int> > m_in, m_out; // connection indices per neuron
+
+    explicit OptimizerGraph(unsigned int a_Neurons) : m_in(a_Neurons), m_out(a_Neurons) {}
+
+    void Add(const Connection& a_Connection)
+    {
+        const unsigned int t_idx = static_cast<unsigned int>(m_connections.size());
+        m_connections.push_back(a_Connection);
+        m_connection_alive.push_back(1);
+        m_in[a_Connection.m_target_neuron_idx].push_back(t_idx);
+        m_out[a_Connection.m_source_neuron_idx].push_back(t_idx);
+    }
+
+    // adds a_Weight to the connection a_Source -> a_Target, creating it if needed
+    void Merge(int a_Source, int a_Target, double a_Weight, bool a_Recurrent)
+    {
+        const std::vector<unsigned int>& t_out = m_out[a_Source];
+        for (unsigned int i = 0; i < t_out.size(); i++)
+        {
+            Connection& t_c = m_connections[t_out[i]];
+            if (m_connection_alive[t_out[i]] && (t_c.m_target_neuron_idx == a_Target))
+            {
+                t_c.m_weight += a_Weight;
+                return;
+            }
+        }
+
+        Connection t_c;
+        t_c.m_source_neuron_idx = a_Source;
+        t_c.m_target_neuron_idx = a_Target;
+        t_c.m_weight = a_Weight;
+        t_c.m_signal = 0;
+        t_c.m_recur_flag = a_Recurrent;
+        t_c.m_hebb_rate = 0;
+        t_c.m_hebb_pre_rate = 0;
+        Add(t_c);
+    }
+
+    // the live connections in a list of m_in or m_out
+    std::vector<unsigned int> Alive(const std::vector<unsigned int>& a_List) const
+    {
+        std::vector<unsigned int> t_alive;
+        for (unsigned int i = 0; i < a_List.size(); i++)
+        {
+            if (m_connection_alive[a_List[i]])
+            {
+                t_alive.push_back(a_List[i]);
+            }
+        }
+        return t_alive;
+    }
+
+    void Disconnect(unsigned int a_Neuron)
+    {
+        for (unsigned int i = 0; i < m_in[a_Neuron].size(); i++)
+        {
+            m_connection_alive[m_in[a_Neuron][i]] = 0;
+        }
+        for (unsigned int i = 0; i < m_out[a_Neuron].size(); i++)
+        {
+            m_connection_alive[m_out[a_Neuron][i]] = 0;
+        }
+    }
+};
+
+NeuralNetwork NeuralNetwork::Optimize(const OptimizationOptions& a_Options, OptimizationReport* a_Report) const
+{
+    const unsigned int t_num_neurons = static_cast<unsigned int>(m_neurons.size());
+    const unsigned int t_first_hidden = m_num_inputs + m_num_outputs;
+
+    OptimizationReport t_report;
+    t_report.m_neurons_before = t_num_neurons;
+    t_report.m_connections_before = static_cast<unsigned int>(m_connections.size());
+
+    OptimizerGraph t_graph(t_num_neurons);
+    for (unsigned int i = 0; i < m_connections.size(); i++)
+    {
+        const Connection& t_c = m_connections[i];
+
+        // Input() overwrites the inputs, what flows into them is never used
+        if (t_c.m_target_neuron_idx < static_cast<int>(m_num_inputs))
+        {
+            continue;
+        }
+        if ((a_Options.m_min_weight > 0) && (fabs(t_c.m_weight) < a_Options.m_min_weight))
+        {
+            t_report.m_weak_connections++;
+            continue;
+        }
+        t_graph.Add(t_c);
+    }
+
+    std::vector<char> t_alive(t_num_neurons, 1);
+
+    // the constant input folded away from every neuron
+    std::vector<double> t_constant(t_num_neurons, 0.0);
+
+    // the constant part of the sum of a neuron, besides its connections
+    auto t_constant_sum = [&](unsigned int a_Neuron)
+    {
+        return t_constant[a_Neuron] + (a_Options.m_use_bias ? m_neurons[a_Neuron].m_bias : 0.0);
+    };
+
+    if (a_Options.m_propagate_constants)
+    {
+        // Kahn's algorithm restricted to the neurons all of whose sources are
+        // constant, so anything on a loop or fed by an input stays out
+        std::vector<char> t_is_constant(t_num_neurons, 0);
+        std::vector<double> t_value(t_num_neurons, 0.0);
+        std::vector<unsigned int> t_pending(t_num_neurons, 0);
+        std::vector<unsigned int> t_queue;
+
+        for (unsigned int i = 0; i < t_num_neurons; i++)
+        {
+            if (i < m_num_inputs)
+            {
+                if (a_Options.m_bias_inputs_are_one && (m_neurons[i].m_type == BIAS))
+                {
+                    t_is_constant[i] = 1;
+                    t_value[i] = 1.0;
+                    t_queue.push_back(i);
+                }
+                continue;
+            }
+
+            t_pending[i] = static_cast<unsigned int>(t_graph.m_in[i].size());
+            if (t_pending[i] == 0)
+            {
+                const Neuron& t_n = m_neurons[i];
+                t_is_constant[i] = 1;
+                t_value[i] = Activation(t_n.m_activation_function_type, t_constant_sum(i), t_n.m_a, t_n.m_b);
+                t_queue.push_back(i);
+            }
+        }
+
+        for (unsigned int q = 0; q < t_queue.size(); q++)
+        {
+            const std::vector<unsigned int>& t_out = t_graph.m_out[t_queue[q]];
+            for (unsigned int j = 0; j < t_out.size(); j++)
+            {
+                const unsigned int t_target = t_graph.m_connections[t_out[j]].m_target_neuron_idx;
+                if (--t_pending[t_target] > 0)
+                {
+                    continue;
+                }
+
+                // all sources known, summed in the order Activate() sums them
+                double t_sum = t_constant_sum(t_target);
+                const std::vector<unsigned int>& t_in = t_graph.m_in[t_target];
+                for (unsigned int k = 0; k < t_in.size(); k++)
+                {
+                    const Connection& t_c = t_graph.m_connections[t_in[k]];
+                    t_sum += t_c.m_weight * t_value[t_c.m_source_neuron_idx];
+                }
+
+                const Neuron& t_n = m_neurons[t_target];
+                t_is_constant[t_target] = 1;
+                t_value[t_target] = Activation(t_n.m_activation_function_type, t_sum, t_n.m_a, t_n.m_b);
+                t_queue.push_back(t_target);
+            }
+        }
+
+        // Constant outputs stay, with their whole sum folded. The other constant
+        // neurons go, folded into the first non-constant neurons they feed.
+        for (unsigned int i = 0; i < t_graph.m_connections.size(); i++)
+        {
+            const Connection& t_c = t_graph.m_connections[i];
+            if (!t_graph.m_connection_alive[i] || !t_is_constant[t_c.m_source_neuron_idx])
+            {
+                continue;
+            }
+
+            const unsigned int t_target = t_c.m_target_neuron_idx;
+            if (!t_is_constant[t_target] || (t_target < t_first_hidden))
+            {
+                t_constant[t_target] += t_c.m_weight * t_value[t_c.m_source_neuron_idx];
+            }
+            t_graph.m_connection_alive[i] = 0;
+        }
+        for (unsigned int i = t_first_hidden; i < t_num_neurons; i++)
+        {
+            if (t_is_constant[i])
+            {
+                t_alive[i] = 0;
+                t_report.m_constant_neurons++;
+            }
+        }
+    }
+
+    if (a_Options.m_fold_linear)
+    {
+        for (unsigned int h = t_first_hidden; h < t_num_neurons; h++)
+        {
+            if (!t_alive[h] || (m_neurons[h].m_activation_function_type != LINEAR))
+            {
+                continue;
+            }
+
+            const std::vector<unsigned int> t_in = t_graph.Alive(t_graph.m_in[h]);
+            const std::vector<unsigned int> t_out = t_graph.Alive(t_graph.m_out[h]);
+
+            // every input-output pair becomes a connection
+            if (t_out.empty() || (t_in.size() * t_out.size() > t_in.size() + t_out.size()))
+            {
+                continue;
+            }
+            bool t_self_loop = false;
+            for (unsigned int i = 0; i < t_in.size(); i++)
+            {
+                t_self_loop = t_self_loop || (t_graph.m_connections[t_in[i]].m_source_neuron_idx == static_cast<int>(h));
+            }
+            if (t_self_loop)
+            {
+                continue;
+            }
+
+            // the activation of h is the sum of its inputs plus this
+            const double t_shift = t_constant_sum(h) + m_neurons[h].m_b;
+
+            t_graph.Disconnect(h);
+            for (unsigned int j = 0; j < t_out.size(); j++)
+            {
+                const Connection t_out_c = t_graph.m_connections[t_out[j]];
+                for (unsigned int i = 0; i < t_in.size(); i++)
+                {
+                    const Connection t_in_c = t_graph.m_connections[t_in[i]];
+                    t_graph.Merge(t_in_c.m_source_neuron_idx, t_out_c.m_target_neuron_idx,
+                                  t_out_c.m_weight * t_in_c.m_weight,
+                                  t_out_c.m_recur_flag || t_in_c.m_recur_flag);
+                }
+                t_constant[t_out_c.m_target_neuron_idx] += t_out_c.m_weight * t_shift;
+            }
+
+            t_alive[h] = 0;
+            t_report.m_folded_neurons++;
+        }
+    }
+
+    if (a_Options.m_remove_dead)
+    {
+        // everything the outputs can be reached from, walking the connections backwards
+        std::vector<char> t_useful(t_num_neurons, 0);
+        std::vector<unsigned int> t_queue;
+        for (unsigned int i = m_num_inputs; i < t_first_hidden; i++)
+        {
+            t_useful[i] = 1;
+            t_queue.push_back(i);
+        }
+        for (unsigned int q = 0; q < t_queue.size(); q++)
+        {
+            const std::vector<unsigned int>& t_in = t_graph.m_in[t_queue[q]];
+            for (unsigned int j = 0; j < t_in.size(); j++)
+            {
+                const unsigned int t_source = t_graph.m_connections[t_in[j]].m_source_neuron_idx;
+                if (t_graph.m_connection_alive[t_in[j]] && !t_useful[t_source])
+                {
+                    t_useful[t_source] = 1;
+                    t_queue.push_back(t_source);
+                }
+            }
+        }
+
+        for (unsigned int i = t_first_hidden; i < t_num_neurons; i++)
+        {
+            if (t_alive[i] && !t_useful[i])
+            {
+                t_alive[i] = 0;
+                t_report.m_dead_neurons++;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        if (!t_alive[i])
+        {
+            t_graph.Disconnect(i);
+        }
+    }
+
+    // the new network
+    NeuralNetwork t_net(true);
+    t_net.SetInputOutputDimentions(m_num_inputs, m_num_outputs);
+    t_net.SetPrecision(m_precision);
+    t_net.SetActivationAccuracy(GetActivationAccuracy());
+
+    std::vector<int> t_index(t_num_neurons, -1);
+    bool t_need_unit = false;
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        if (!t_alive[i])
+        {
+            continue;
+        }
+
+        t_index[i] = static_cast<int>(t_net.m_neurons.size());
+        Neuron t_n = m_neurons[i];
+        t_n.m_activesum = 0;
+        t_n.m_activation = 0;
+        t_n.m_membrane_potential = 0;
+
+        // a constant input goes into the bias or the shift where it can
+        if (t_constant[i] != 0)
+        {
+            if (a_Options.m_use_bias)
+            {
+                t_n.m_bias += t_constant[i];
+                t_constant[i] = 0;
+            }
+            else if (t_n.m_activation_function_type == LINEAR)
+            {
+                t_n.m_b += t_constant[i];
+                t_constant[i] = 0;
+            }
+            else
+            {
+                t_need_unit = true;
+            }
+        }
+        t_net.m_neurons.push_back(t_n);
+    }
+
+    for (unsigned int i = 0; i < t_graph.m_connections.size(); i++)
+    {
+        if (t_graph.m_connection_alive[i])
+        {
+            Connection t_c = t_graph.m_connections[i];
+            t_c.m_source_neuron_idx = t_index[t_c.m_source_neuron_idx];
+            t_c.m_target_neuron_idx = t_index[t_c.m_target_neuron_idx];
+            t_c.m_signal = 0;
+            t_net.m_connections.push_back(t_c);
+        }
+    }
+
+    // otherwise the constants come from a neuron that is always 1
+    if (t_need_unit)
+    {
+        Neuron t_unit = Neuron();
+        t_unit.m_activation_function_type = LINEAR;
+        t_unit.m_a = 1;
+        t_unit.m_b = 1;
+        t_unit.m_bias = 0;
+        t_unit.m_type = HIDDEN;
+        const int t_unit_index = static_cast<int>(t_net.m_neurons.size());
+        t_net.m_neurons.push_back(t_unit);
+
+        for (unsigned int i = 0; i < t_num_neurons; i++)
+        {
+            if (t_alive[i] && (t_constant[i] != 0))
+            {
+                Connection t_c;
+                t_c.m_source_neuron_idx = t_unit_index;
+                t_c.m_target_neuron_idx = t_index[i];
+                t_c.m_weight = t_constant[i];
+                t_c.m_signal = 0;
+                t_c.m_recur_flag = false;
+                t_c.m_hebb_rate = 0;
+                t_c.m_hebb_pre_rate = 0;
+                t_net.m_connections.push_back(t_c);
+            }
+        }
+    }
+
+    t_report.m_neurons_after = static_cast<unsigned int>(t_net.m_neurons.size());
+    t_report.m_connections_after = static_cast<unsigned int>(t_net.m_connections.size());
+    if (a_Report)
+    {
+        *a_Report = t_report;
+    }
+
+    return t_net;
+}
+
+// a constant of the generated code, rounded to float first if that is its type
+std::string EmitLiteral(double a_Value, bool a_Float)
+{
+    char t_buf[64];
+    if (a_Float)
+    {
+        snprintf(t_buf, sizeof(t_buf), "%.9g", static_cast<double>(static_cast<float>(a_Value)));
+    }
+    else
+    {
+        snprintf(t_buf, sizeof(t_buf), "%.17g", a_Value);
+    }
+
+    std::string t_literal(t_buf);
+    if (t_literal.find_first_of(".e") == std::string::npos)
+    {
+        t_literal += ".0";
+    }
+    if (a_Float)
+    {
+        t_literal += "f";
+    }
+    if (a_Value < 0)
+    {
+        t_literal = "(" + t_literal + ")";
+    }
+    return t_literal;
+}
+
+// the activation function of a_Neuron applied to a_X, written out like in Activation.h
+std::string EmitActivation(const Neuron& a_Neuron, const std::string& a_X, bool a_Float)
+{
+    const double t_a = a_Float ? static_cast<float>(a_Neuron.m_a) : a_Neuron.m_a;
+    const double t_b = a_Float ? static_cast<float>(a_Neuron.m_b) : a_Neuron.m_b;
+    const std::string t_one = EmitLiteral(1.0, a_Float);
+    const std::string t_half = EmitLiteral(0.5, a_Float);
+    const std::string t_two = EmitLiteral(2.0, a_Float);
+
+    const std::string t_sigmoid = t_one + " / (" + t_one + " + std::exp(" + EmitLiteral(-t_a, a_Float) + " * " + a_X +
+                                  " - " + EmitLiteral(t_b, a_Float) + "))";
+    const std::string t_gauss = "std::exp(" + EmitLiteral(-t_a, a_Float) + " * " + a_X + " * " + a_X +
+                                " + " + EmitLiteral(t_b, a_Float) + ")";
+    const std::string t_sine = "std::sin(" + a_X + " * " + EmitLiteral(t_a, a_Float) + " + " + EmitLiteral(t_b, a_Float) + ")";
+
+    switch (a_Neuron.m_activation_function_type)
+    {
+    case SIGNED_SIGMOID:
+        return "(" + t_sigmoid + " - " + t_half + ") * " + t_two;
+    case UNSIGNED_SIGMOID:
+        return t_sigmoid;
+    case TANH:
+        return "std::tanh(" + a_X + " * " + EmitLiteral(t_a, a_Float) + ")";
+    case TANH_CUBIC:
+        return "std::tanh(" + a_X + " * " + a_X + " * " + a_X + " * " + EmitLiteral(t_a, a_Float) + ")";
+    case SIGNED_STEP:
+        return "(" + a_X + " > " + EmitLiteral(t_b, a_Float) + ") ? " + t_one + " : " + EmitLiteral(-1.0, a_Float);
+    case UNSIGNED_STEP:
+    {
+        const double t_threshold = a_Float ? static_cast<double>(0.5f + static_cast<float>(t_b)) : 0.5 + t_b;
+        return "(" + a_X + " > " + EmitLiteral(t_threshold, a_Float) + ") ? " + t_one + " : " + EmitLiteral(0.0, a_Float);
+    }
+    case SIGNED_GAUSS:
+        return "(" + t_gauss + " - " + t_half + ") * " + t_two;
+    case UNSIGNED_GAUSS:
+        return t_gauss;
+    case ABS:
+        return "std::fabs(" + a_X + " + " + EmitLiteral(t_b, a_Float) + ")";
+    case SIGNED_SINE:
+        return t_sine;
+    case UNSIGNED_SINE:
+        return "(" + t_sine + " + " + t_one + ") / " + t_two;
+    case LINEAR:
+        return a_X + " + " + EmitLiteral(t_b, a_Float);
+    case RELU:
+        return "(" + a_X + " > " + EmitLiteral(0.0, a_Float) + ") ? " + a_X + " : " + EmitLiteral(0.0, a_Float);
+    case SOFTPLUS:
+        return "std::log(" + t_one + " + std::exp(" + a_X + "))";
+    default:
+        return t_sigmoid;
+    }
+}
+
+bool NeuralNetwork::EmitCpp(std::ostream& a_Stream, const EmitOptions& a_Options) const
+{
+    const bool t_feed_forward = (a_Options.m_mode == SEQUENCE_FEED_FORWARD);
+    const bool t_use_bias = (a_Options.m_mode == SEQUENCE_USE_INTERNAL_BIAS);
+    if (!t_feed_forward && !t_use_bias && (a_Options.m_mode != SEQUENCE_ACTIVATE))
+    {
+        return false;
+    }
+
+    const unsigned int t_num_neurons = static_cast<unsigned int>(m_neurons.size());
+    const bool t_float = a_Options.m_float;
+
+    // the incoming connections of every neuron, in the order Activate() sums them
+    std::vector< std::vector<unsigned int> > t_in(t_num_neurons);
+    for (unsigned int i = 0; i < m_connections.size(); i++)
+    {
+        if (m_connections[i].m_target_neuron_idx >= static_cast<int>(m_num_inputs))
+        {
+            t_in[m_connections[i].m_target_neuron_idx].push_back(i);
+        }
+    }
+
+    // A sweep computes only the neurons the outputs depend on, found walking the
+    // connections back from the outputs. A step keeps the state of all of them.
+    std::vector<bool> t_needed(t_num_neurons, !t_feed_forward);
+    if (t_feed_forward)
+    {
+        std::vector<unsigned int> t_stack;
+        for (unsigned int i = m_num_inputs; (i < m_num_inputs + m_num_outputs) && (i < t_num_neurons); i++)
+        {
+            t_needed[i] = true;
+            t_stack.push_back(i);
+        }
+        while (!t_stack.empty())
+        {
+            const unsigned int t_neuron = t_stack.back();
+            t_stack.pop_back();
+            for (unsigned int j = 0; j < t_in[t_neuron].size(); j++)
+            {
+                const unsigned int t_source = m_connections[t_in[t_neuron][j]].m_source_neuron_idx;
+                if (!t_needed[t_source])
+                {
+                    t_needed[t_source] = true;
+                    t_stack.push_back(t_source);
+                }
+            }
+        }
+    }
+
+    // the order the neurons are computed in, topological for a single sweep
+    std::vector<unsigned int> t_order;
+    if (t_feed_forward)
+    {
+        std::vector<unsigned int> t_pending(t_num_neurons, 0);
+        std::vector< std::vector<unsigned int> > t_out(t_num_neurons);
+        std::vector<unsigned int> t_queue;
+        for (unsigned int i = 0; i < t_num_neurons; i++)
+        {
+            for (unsigned int j = 0; j < t_in[i].size(); j++)
+            {
+                t_out[m_connections[t_in[i][j]].m_source_neuron_idx].push_back(i);
+            }
+            t_pending[i] = static_cast<unsigned int>(t_in[i].size());
+            if (t_pending[i] == 0)
+            {
+                t_queue.push_back(i);
+            }
+        }
+        for (unsigned int q = 0; q < t_queue.size(); q++)
+        {
+            if ((t_queue[q] >= m_num_inputs) && t_needed[t_queue[q]])
+            {
+                t_order.push_back(t_queue[q]);
+            }
+            for (unsigned int j = 0; j < t_out[t_queue[q]].size(); j++)
+            {
+                if (--t_pending[t_out[t_queue[q]][j]] == 0)
+                {
+                    t_queue.push_back(t_out[t_queue[q]][j]);
+                }
+            }
+        }
+        if (t_queue.size() < t_num_neurons)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+        {
+            t_order.push_back(i);
+        }
+    }
+
+    const std::string t_type = t_float ? "float" : "double";
+    const std::string t_name = a_Options.m_function_name;
+
+    // how the activation of neuron i is read
+    std::vector<std::string> t_value(t_num_neurons);
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        std::ostringstream t_ss;
+        t_ss << (t_feed_forward ? "n" : "state[") << i << (t_feed_forward ? "" : "]");
+        t_value[i] = t_ss.str();
+    }
+
+    a_Stream << "// Generated by NEAT::NeuralNetwork::EmitCpp()\n";
+    a_Stream << "// " << m_num_inputs << " inputs, " << m_num_outputs << " outputs, "
+             << t_num_neurons << " neurons, " << m_connections.size() << " connections\n";
+    if (t_feed_forward)
+    {
+        a_Stream << "// The same as Input(), ActivateFeedForward(), Output().\n";
+    }
+    else
+    {
+        a_Stream << "// One step of " << (t_use_bias ? "ActivateUseInternalBias()" : "Activate()")
+                 << ", state holds the " << t_num_neurons << " activations between the calls.\n";
+    }
+    a_Stream << "\n#include <cmath>\n\n";
+    a_Stream << "void " << t_name << "(const " << t_type << "* inputs, "
+             << (t_feed_forward ? "" : t_type + "* state, ") << t_type << "* outputs)\n{\n";
+
+    for (unsigned int i = 0; i < m_num_inputs; i++)
+    {
+        if (t_feed_forward)
+        {
+            if (t_needed[i])
+            {
+                a_Stream << "    const " << t_type << " " << t_value[i] << " = inputs[" << i << "];\n";
+            }
+        }
+        else
+        {
+            a_Stream << "    " << t_value[i] << " = inputs[" << i << "];\n";
+        }
+    }
+
+    for (unsigned int k = 0; k < t_order.size(); k++)
+    {
+        const unsigned int t_neuron = t_order[k];
+        a_Stream << "    const " << t_type << " s" << t_neuron << " = ";
+        if (t_in[t_neuron].empty())
+        {
+            a_Stream << EmitLiteral(0.0, t_float);
+        }
+        for (unsigned int j = 0; j < t_in[t_neuron].size(); j++)
+        {
+            const Connection& t_c = m_connections[t_in[t_neuron][j]];
+            a_Stream << (j ? " + " : "") << t_value[t_c.m_source_neuron_idx] << " * " << EmitLiteral(t_c.m_weight, t_float);
+        }
+        if (t_use_bias)
+        {
+            a_Stream << " + " << EmitLiteral(m_neurons[t_neuron].m_bias, t_float);
+        }
+        a_Stream << ";\n";
+
+        // in a sweep the activation follows at once, a step sums everything first
+        if (t_feed_forward)
+        {
+            std::ostringstream t_sum;
+            t_sum << "s" << t_neuron;
+            a_Stream << "    const " << t_type << " " << t_value[t_neuron] << " = "
+                     << EmitActivation(m_neurons[t_neuron], t_sum.str(), t_float) << ";\n";
+        }
+    }
+
+    if (!t_feed_forward)
+    {
+        for (unsigned int k = 0; k < t_order.size(); k++)
+        {
+            std::ostringstream t_sum;
+            t_sum << "s" << t_order[k];
+            a_Stream << "    " << t_value[t_order[k]] << " = "
+                     << EmitActivation(m_neurons[t_order[k]], t_sum.str(), t_float) << ";\n";
+        }
+    }
+
+    for (unsigned int i = 0; i < m_num_outputs; i++)
+    {
+        a_Stream << "    outputs[" << i << "] = " << t_value[m_num_inputs + i] << ";\n";
+    }
+    a_Stream << "}\n";
+
+    return true;
+}
+
+bool NeuralNetwork::SaveBinary(const char* a_filename)
+{
+    WriteBack();
+
+    std::vector<unsigned char> t_image;
+    if (!EncodeNetworkFile(m_neurons, m_connections, m_num_inputs, m_num_outputs, m_structure, t_image))
+    {
+        return false;
+    }
+
+    FILE* t_file = fopen(a_filename, "wb");
+    if (!t_file)
+    {
+        return false;
+    }
+    const bool t_ok = (fwrite(t_image.data(), 1, t_image.size(), t_file) == t_image.size());
+    return (fclose(t_file) == 0) && t_ok;
+}
+
+bool NeuralNetwork::LoadBinary(const char* a_filename)
+{
+    MappedFile t_file;
+    NetworkFileView t_view;
+    if (!t_file.Open(a_filename) || !DecodeNetworkFile(t_file.Data(), t_file.Size(), true, t_view))
+    {
+        return false;
+    }
+
+    Clear();
+    SetInputOutputDimentions(t_view.m_num_inputs, t_view.m_num_outputs);
+
+    m_neurons.resize(t_view.m_num_neurons, Neuron());
+    for (unsigned int i = 0; i < t_view.m_num_neurons; i++)
+    {
+        Neuron& t_n = m_neurons[i];
+        t_n.m_a = t_view.m_a[i];
+        t_n.m_b = t_view.m_b[i];
+        t_n.m_timeconst = t_view.m_timeconst[i];
+        t_n.m_bias = t_view.m_bias[i];
+        t_n.m_split_y = t_view.m_split_y[i];
+        t_n.m_type = static_cast<NeuronType>(t_view.m_neuron_type[i]);
+        t_n.m_activation_function_type = static_cast<ActivationFunction>(t_view.m_act_type[i]);
+    }
+
+    m_connections.resize(t_view.m_num_links, Connection());
+    for (unsigned int i = 0; i < t_view.m_num_links; i++)
+    {
+        Connection& t_c = m_connections[i];
+        t_c.m_source_neuron_idx = static_cast<int>(t_view.m_link_source[i]);
+        t_c.m_target_neuron_idx = static_cast<int>(t_view.m_link_target[i]);
+        t_c.m_weight = t_view.m_link_weight[i];
+        t_c.m_hebb_rate = t_view.m_hebb_rate[i];
+        t_c.m_hebb_pre_rate = t_view.m_hebb_pre_rate[i];
+        t_c.m_recur_flag = (t_view.m_recur[i] != 0);
+    }
+
+    m_structure = t_view.m_structure;
+    return true;
+}
+
 std::vector<const Connection*> GetNeuronOutConnections(const std::vector<Connection> &all_connections, int neuron_index)
 {
     std::vector<const Connection*> out_connections;
@@ -56,11 +56,24 @@ namespace py = boost::python;
 #endif
 
 #include <vector>
+#include <string>
+#include <ostream>
 #include "Genes.h"
+#include "CompiledNetwork.h"
 
 namespace NEAT
 {
 
+// How RunSequence() activates the network at every step
+enum SequenceMode
+{
+    SEQUENCE_ACTIVATE = 0,      // Activate()
+    SEQUENCE_FAST,              // ActivateFast()
+    SEQUENCE_USE_INTERNAL_BIAS, // ActivateUseInternalBias()
+    SEQUENCE_LEAKY,             // ActivateLeaky(a_TimeStep)
+    SEQUENCE_FEED_FORWARD       // ActivateFeedForward()
+};
+
 class Connection
 {
 public:
@@ -108,9 +121,6 @@ public:
     double m_split_y;
     NeuronType m_type;
 
-    // the sensitivity matrix of this neuron (for RTRL learning)
-    std::vector< std::vector< double > > m_sensitivity_matrix;
-
     // comparison operator (nessesary for boost::python)
     bool operator==(Neuron const& other) const
     {
@@ -125,6 +135,89 @@ public:
     }
 };
 
+// What NeuralNetwork::Optimize() may do to the network
+struct OptimizationOptions
+{
+    // hidden neurons with no path to an output, and their connections, are removed
+    bool m_remove_dead;
+
+    // connections with |weight| below this are removed (0 keeps them all).
+    // This is the only change that is not exact.
+    double m_min_weight;
+
+    // neurons whose activation can not depend on the inputs are evaluated
+    // once and their contribution is folded into the neurons they feed
+    bool m_propagate_constants;
+
+    // hidden LINEAR neurons are folded into the weights around them, when
+    // that does not make the network grow
+    bool m_fold_linear;
+
+    // the network runs with ActivateUseInternalBias(), so m_bias takes part
+    // in the sums (and folded constants go into it)
+    bool m_use_bias;
+
+    // BIAS inputs are always fed 1.0, which lets the subgraphs fed only by
+    // them be propagated as constants
+    bool m_bias_inputs_are_one;
+
+    OptimizationOptions()
+    {
+        m_remove_dead = true;
+        m_min_weight = 0.0;
+        m_propagate_constants = true;
+        m_fold_linear = true;
+        m_use_bias = false;
+        m_bias_inputs_are_one = false;
+    }
+};
+
+// What NeuralNetwork::Optimize() did
+struct OptimizationReport
+{
+    unsigned int m_neurons_before, m_neurons_after;
+    unsigned int m_connections_before, m_connections_after;
+
+    unsigned int m_dead_neurons;      // removed, no path to an output
+    unsigned int m_constant_neurons;  // removed, folded as constants
+    unsigned int m_folded_neurons;    // removed, LINEAR ones folded into weights
+    unsigned int m_weak_connections;  // removed, below m_min_weight
+
+    OptimizationReport()
+    {
+        m_neurons_before = m_neurons_after = 0;
+        m_connections_before = m_connections_after = 0;
+        m_dead_neurons = m_constant_neurons = m_folded_neurons = m_weak_connections = 0;
+    }
+};
+
+// How NeuralNetwork::EmitCpp() writes the network as C++ source
+struct EmitOptions
+{
+    // the name of the generated function
+    std::string m_function_name;
+
+    // SEQUENCE_FEED_FORWARD emits
+    //     void name(const T* inputs, T* outputs)
+    // computing what Input(), ActivateFeedForward(), Output() give. Only the
+    // neurons with a path to an output are computed.
+    // SEQUENCE_ACTIVATE and SEQUENCE_USE_INTERNAL_BIAS emit
+    //     void name(const T* inputs, T* state, T* outputs)
+    // doing one step of Activate() or ActivateUseInternalBias(). The state holds
+    // the activations of all neurons between the calls, zeroed means flushed.
+    SequenceMode m_mode;
+
+    // T is float instead of double
+    bool m_float;
+
+    EmitOptions()
+    {
+        m_function_name = "activate_network";
+        m_mode = SEQUENCE_FEED_FORWARD;
+        m_float = false;
+    }
+};
+
 class NeuralNetwork
 {
     /////////////////////
@@ -133,10 +226,54 @@ class NeuralNetwork
 
     // Always the size of m_connections
     std::vector<double> m_total_weight_change;
+
+    // The learned weights: the first connection between every pair of neurons
+    // whose target is not an input (later duplicates are not learned).
+    // Weight w spans m_rtrl_weight_connection[w], the weights are grouped by
+    // target neuron and sorted by source inside each group:
+    // m_rtrl_weight_start[k - m_num_inputs] .. m_rtrl_weight_start[k - m_num_inputs + 1]
+    // are the incoming weights of neuron k.
+    std::vector<unsigned int> m_rtrl_weight_start;
+    std::vector<unsigned int> m_rtrl_weight_connection;
+
+    // Sensitivity of every non-input neuron to every learned weight, one row
+    // per neuron: [k - m_num_inputs][w]. Inputs have zero sensitivities and
+    // pairs of unconnected neurons have no weight, so neither is stored.
+    std::vector<double> m_rtrl_sensitivity;
+    std::vector<double> m_rtrl_row; // scratch row
     /////////////////////
 
-    // returns the index if that connection exists or -1 otherwise
-    int ConnectionExists(int a_to, int a_from);
+    // false if the RTRL data was not built for the current neurons and connections
+    bool RTRLMatchesNetwork() const;
+
+    /////////////////////
+    // The compiled evaluation plan.
+    // All activation methods run over it; the neurons and connections
+    // below are only the description the plan is compiled from.
+    // Only the plan of the selected precision is built, the other one stays empty.
+    CompiledNetwork m_plan;
+    CompiledNetworkFloat m_plan_float;
+    NetworkPrecision m_precision;
+    bool m_plan_valid;
+
+    // true when the plan holds activations not yet written back to m_neurons
+    bool m_state_dirty;
+
+    // the structure signature of the genome this network was built from,
+    // 0 if it was not built from a genome or was changed since
+    unsigned long long m_structure;
+
+    // the steps the last ActivateUntilStable() took, 0 if it was not called yet
+    unsigned int m_stable_iterations;
+
+    // counts the changes of the neurons and connections, see GetGeneration()
+    unsigned long long m_generation;
+
+    // compiles the plan if it is missing or was invalidated
+    void EnsureCompiled();
+
+    // copies the weights of m_connections into the plan after they were learned
+    void PushWeights();
 
 public:
 
@@ -147,23 +284,155 @@ public:
     NeuralNetwork(bool a_Minimal); // if given false, the constructor will create a standard XOR network topology.
     NeuralNetwork();
 
-    void InitRTRLMatrix(); // initializes the sensitivity cube for RTRL learning.
+    void InitRTRLMatrix(); // initializes the sensitivities for RTRL learning.
     // assumes that neuron and connection data are already initialized
+    // (it is called again by RTRL_update_gradients() if connections are added later)
+
+    // Compiles m_neurons and m_connections into the flat evaluation plan.
+    // This happens automatically before the first activation and whenever the
+    // network was changed through its methods. The network can't see edits made
+    // directly to m_neurons, m_connections or the input/output counts - after
+    // those call Compile() or Invalidate() (or UpdateParameters() if only the
+    // weights and neuron parameters changed), or the old plan keeps running.
+    // The current network state is preserved.
+    void Compile();
+
+    // Discards the compiled plan, it will be rebuilt before the next activation.
+    // The network may have been changed in any way, so it also forgets the
+    // structure signature and Genome::BuildPhenotype() will rebuild it in full.
+    void Invalidate()
+    {
+        m_plan_valid = false;
+        m_structure = 0;
+        m_generation++;
+    }
+
+    // Changes whenever the neurons or connections are changed through the methods
+    // of the network: added, cleared, invalidated, updated with UpdateParameters()
+    // or learned by Adapt() and RTRL_update_weights(). Running the network does not
+    // change it. Code that keeps something derived from the network (an optimized
+    // or emitted copy, cached outputs) can compare it to tell when that is stale.
+    unsigned long long GetGeneration() const { return m_generation; }
+
+    // Like Compile(), but only for edits of the weights and neuron parameters:
+    // they are copied into the plan in place. Changed activation functions make
+    // the plan recompile before the next activation.
+    void UpdateParameters();
+
+    // see Genome::StructureSignature(), set by Genome::BuildPhenotype()
+    unsigned long long GetStructureSignature() const { return m_structure; }
+    void SetStructureSignature(unsigned long long a_Signature) { m_structure = a_Signature; }
+
+    // The activations live in the compiled plan while the network runs.
+    // This copies them back into m_neurons (it is done automatically by Save()
+    // and GetNeuronByIndex(), call it yourself before reading m_neurons directly).
+    void WriteBack();
 
     void ActivateFast();          // assumes unsigned sigmoids everywhere.
     void Activate();              // any activation functions are supported
     void ActivateUseInternalBias(); // like Activate() but uses m_bias as well
     void ActivateLeaky(double step); // activates in leaky integrator mode
 
+    // Activates the network in a single sweep over the neurons in topological order.
+    // For a feed-forward network the result is exactly what Activate() gives once it
+    // has been called enough times for the signal to reach the outputs, so there is
+    // no need to guess the depth. On a network with loops, the connections that
+    // close a loop may see activations of this or of the previous step - use
+    // Activate() there.
+    void ActivateFeedForward();
+
+    // true if the network has no loops (connections into inputs are ignored)
+    bool IsFeedForward();
+
+    // Calls Activate() until the largest change of an activation in one step is below
+    // a_Tolerance, at most a_MaxIterations times, and returns the number of steps taken.
+    // A feed-forward network needs a single ActivateFeedForward(), reported as one step.
+    //
+    // The number of steps is remembered as an estimate for the next call, which
+    // skips measuring the change for the first half of that many steps. This never
+    // stops early. A call that settles sooner than the estimate runs at most half
+    // the estimate plus one step, and the estimate halves with every such call.
+    int ActivateUntilStable(double a_Tolerance = 1e-6, int a_MaxIterations = 100);
+
+    // the estimate kept by ActivateUntilStable(), 0 before the first call
+    unsigned int GetStableIterations() const { return m_stable_iterations; }
+    void ResetStableIterations() { m_stable_iterations = 0; }
+
+    // The number of fully connected layers the compiled plan sums as dense
+    // matrix-vector products instead of connection by connection. A layer
+    // qualifies when all its neurons take their inputs from the same contiguous
+    // layer, in the same order - what a HyperNEAT substrate with only adjacent
+    // layers connected and Substrate::m_query_weights_only set builds. The layer
+    // must be fully connected, one missing connection makes it sparse.
+    unsigned int NumDenseBlocks();
+
+    // Runs one Activate() step for a_Batch independent samples at once.
+    // a_Inputs holds a_Batch rows of NumInputs() values and a_Outputs must have room
+    // for a_Batch rows of NumOutputs() values. Each sample has its own state, which
+    // persists between calls and is separate from the state used by Activate().
+    void ActivateBatch(const double* a_Inputs, size_t a_Batch, double* a_Outputs);
+    void FlushBatch(); // clears the state of all batch samples
+
+    // Streams a_Steps timesteps through the network: for every step t it inputs row t of
+    // a_Inputs (a_Steps rows of NumInputs() values), activates the network once in
+    // a_Mode and writes the outputs into row t of a_Outputs (a_Steps rows of NumOutputs()
+    // values, may be NULL). a_TimeStep is the step of SEQUENCE_LEAKY. If a_Adapt is given,
+    // Adapt() runs with it after every step. The result is exactly that of the
+    // equivalent Input()/Activate*()/Output() calls, without their per-step overhead.
+    void RunSequence(const double* a_Inputs, size_t a_Steps, double* a_Outputs,
+                     SequenceMode a_Mode = SEQUENCE_ACTIVATE, double a_TimeStep = 0,
+                     Parameters* a_Adapt = NULL);
+
+    // Opt-in multi-threaded activation for very large networks (e.g. HyperNEAT substrates).
+    // The sums of every activation step are split over a_Threads threads (the calling one
+    // included) when there are at least a_MinConnections connections to sum, smaller
+    // networks stay serial. The results are exactly the same as serial. 0 or 1 threads
+    // turns it off (the default); std::thread::hardware_concurrency() is a good choice.
+    void SetParallelActivation(unsigned int a_Threads, unsigned int a_MinConnections = 100000);
+    unsigned int GetParallelThreads() const { return m_plan.GetParallelThreads(); }
+
+    // Exact (default) or fast approximate activation functions, see ActivationKernels.h
+    void SetActivationAccuracy(ActivationAccuracy a_Accuracy);
+    ActivationAccuracy GetActivationAccuracy() const { return m_plan.GetAccuracy(); }
+
+    // The precision the network is evaluated in (double by default). The neurons and
+    // connections, and therefore genomes and evolution, always stay in double; in
+    // float mode only the compiled plan is, which halves its memory traffic and
+    // doubles the SIMD width. The setting survives Clear(), so it may be chosen
+    // before the network is passed to Genome::BuildPhenotype().
+    void SetPrecision(NetworkPrecision a_Precision);
+    NetworkPrecision GetPrecision() const { return m_precision; }
+
     void RTRL_update_gradients();
-    void RTRL_update_error(double a_target);
+    void RTRL_update_error(double a_target); // the target of the first output
+    // one target per output, extra targets are ignored and missing ones are not trained
+    void RTRL_update_error(const std::vector<double>& a_targets);
     void RTRL_update_weights();   // performs the backprop step
 
-    // Hebbian learning
+    // Hebbian learning, with the m_hebb_rate and m_hebb_pre_rate of every connection.
+    // It runs on the compiled plan, and the new weights are copied into m_connections.
     void Adapt(Parameters& a_Parameters);
 
+    // Returns an equivalent network with less work per activation, see OptimizationOptions.
+    // The inputs and outputs keep their indices, the hidden neurons their order, and the
+    // new network starts flushed. Removing dead neurons is exact in every mode. Propagated
+    // constants and folded LINEAR neurons give the same result as ActivateFeedForward(),
+    // and as Activate() once the network has settled, though a signal may now reach the
+    // outputs in fewer steps. They assume the activation functions of the neurons, so
+    // don't use them for networks run with ActivateFast() or ActivateLeaky().
+    // Connections created by folding have no Hebbian learning rates.
+    NeuralNetwork Optimize(const OptimizationOptions& a_Options,
+                           OptimizationReport* a_Report = NULL) const;
+
+    // Writes the network as a self-contained C++ function without loops or lookups:
+    // every weight and neuron parameter is a literal and every activation function is
+    // written out for its neuron, so the compiler can optimise the whole computation.
+    // The results match the network up to rounding. Returns false (writing nothing) if
+    // the mode is not supported, or it is SEQUENCE_FEED_FORWARD and the network has loops.
+    bool EmitCpp(std::ostream& a_Stream, const EmitOptions& a_Options = EmitOptions()) const;
+
     void Flush();     // clears all activations
-    void FlushCube(); // clears the sensitivity cube
+    void FlushCube(); // clears the RTRL sensitivities
 
     void Input(const std::vector<double>& a_Inputs);
 
@@ -172,23 +441,54 @@ public:
     void Input_python_list(const py::list& a_Inputs);
     void Input_numpy(const pyndarray& a_Inputs);
 
+    // RunSequence() on a 2D array of a_Steps x NumInputs() values or on a list of lists,
+    // returns the a_Steps x NumOutputs() outputs in the same form
+    py::object RunSequence_python(const py::object& a_Inputs, SequenceMode a_Mode,
+                                  double a_TimeStep, Parameters* a_Adapt);
+
+    // returns (optimized network, report)
+    py::tuple Optimize_python(const OptimizationOptions& a_Options) const;
+
+    // EmitCpp() into a string, empty if it fails
+    std::string EmitCpp_python(const EmitOptions& a_Options) const;
+
 #endif
 
     std::vector<double> Output();
 
     // accessor methods
-    void AddNeuron(const Neuron& a_n) { m_neurons.push_back( a_n ); }
-    void AddConnection(const Connection& a_c) { m_connections.push_back( a_c ); }
+    void AddNeuron(const Neuron& a_n)
+    {
+        WriteBack();
+        m_neurons.push_back( a_n );
+        Invalidate();
+    }
+    void AddConnection(const Connection& a_c)
+    {
+        WriteBack();
+        m_connections.push_back( a_c );
+        Invalidate();
+    }
     Connection GetConnectionByIndex(unsigned int a_idx) const
     {
         return m_connections[a_idx];
     }
     Neuron GetNeuronByIndex(unsigned int a_idx) const
     {
-        return m_neurons[a_idx];
+        Neuron t_n = m_neurons[a_idx];
+        if (m_plan_valid && m_state_dirty)
+        {
+            t_n.m_activation = (m_precision == PRECISION_FLOAT) ? m_plan_float.GetActivation(a_idx)
+                                                                : m_plan.GetActivation(a_idx);
+        }
+        return t_n;
     }
     void SetInputOutputDimentions(const unsigned int a_i, const unsigned int a_o)
     {
+        if ((a_i != m_num_inputs) || (a_o != m_num_outputs))
+        {
+            Invalidate();
+        }
         m_num_inputs = a_i;
         m_num_outputs = a_o;
     }
@@ -207,6 +507,14 @@ public:
         m_neurons.clear();
         m_connections.clear();
         m_total_weight_change.clear();
+        m_rtrl_weight_start.clear();
+        m_rtrl_weight_connection.clear();
+        m_rtrl_sensitivity.clear();
+        m_plan.Clear();
+        m_plan_float.Clear();
+        Invalidate();
+        m_state_dirty = false;
+        m_stable_iterations = 0;
         SetInputOutputDimentions(0, 0);
     }
 
@@ -234,6 +542,11 @@ public:
     // save/load from already opened files for reading/writing
     void Save(FILE* a_file);
     bool Load(std::ifstream& a_DataFile);
+
+    // Compact binary files (see NetworkFile.h), loaded without any parsing.
+    // InferenceNetwork::LoadMapped() runs on them in place.
+    bool SaveBinary(const char* a_filename);
+    bool LoadBinary(const char* a_filename);
 };
 
 } // namespace NEAT
@@ -360,6 +360,12 @@ public:
     double MutateLinkTraitsProb;
     double MutateGenomeTraitsProb;
 
+    // The layouts of the trait parameters above, resolved once and kept
+    // while the parameters don't change
+    const TraitLayout &NeuronTraitLayout() const { return m_NeuronTraitLayout.Get(NeuronTraits); }
+    const TraitLayout &LinkTraitLayout() const { return m_LinkTraitLayout.Get(LinkTraits); }
+    const TraitLayout &GenomeTraitLayout() const { return m_GenomeTraitLayout.Get(GenomeTraits); }
+
     /////////////////////////////////////
     // Speciation parameters
     /////////////////////////////////////
@@ -951,6 +957,8 @@ public:
     
 #endif
 
+private:
+    TraitLayoutCache m_NeuronTraitLayout, m_LinkTraitLayout, m_GenomeTraitLayout;
 };
 
 
@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        PhenotypePool.cpp
+// Description: Implementation of the phenotype pool.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <memory>
+#include "PhenotypePool.h"
+#include "Genome.h"
+#include "MultiNEATAssert.h"
+
+namespace NEAT
+{
+
+template<typename Net>
+BasicPhenotypePool<Net>::BasicPhenotypePool()
+{
+    m_hits = m_misses = 0;
+}
+
+template<typename Net>
+BasicPhenotypePool<Net>::~BasicPhenotypePool()
+{
+    for (unsigned int i = 0; i < m_networks.size(); i++)
+    {
+        delete m_networks[i];
+    }
+}
+
+template<typename Net>
+Net *BasicPhenotypePool<Net>::Acquire()
+{
+    if (!m_free.empty())
+    {
+        Net *t_net = m_free.back();
+        m_free.pop_back();
+        m_hits++;
+        return t_net;
+    }
+
+    // owned here until the pool holds it, in case push_back() throws
+    std::unique_ptr<Net> t_net(new Net());
+    m_networks.push_back(t_net.get());
+    t_net.release();
+    // so releasing never allocates
+    m_free.reserve(m_networks.capacity());
+    m_misses++;
+    return m_networks.back();
+}
+
+template<typename Net>
+Net *BasicPhenotypePool<Net>::Build(const Genome &a_Genome)
+{
+    Net *t_net = Acquire();
+    a_Genome.BuildPhenotype(*t_net);
+    return t_net;
+}
+
+template<typename Net>
+void BasicPhenotypePool<Net>::Release(Net *a_Net)
+{
+    ASSERT(std::find(m_networks.begin(), m_networks.end(), a_Net) != m_networks.end());
+    ASSERT(std::find(m_free.begin(), m_free.end(), a_Net) == m_free.end());
+    m_free.push_back(a_Net);
+}
+
+template<typename Net>
+void BasicPhenotypePool<Net>::ReleaseAll()
+{
+    m_free.assign(m_networks.begin(), m_networks.end());
+}
+
+template<typename Net>
+void BasicPhenotypePool<Net>::Shrink()
+{
+    for (unsigned int i = 0; i < m_free.size(); i++)
+    {
+        m_networks.erase(std::find(m_networks.begin(), m_networks.end(), m_free[i]));
+        delete m_free[i];
+    }
+    m_free.clear();
+}
+
+template class BasicPhenotypePool<NeuralNetwork>;
+template class BasicPhenotypePool<InferenceNetwork>;
+
+} // namespace NEAT
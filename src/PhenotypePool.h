@@ -0,0 +1,103 @@
+#ifndef _PHENOTYPEPOOL_H
+#define _PHENOTYPEPOOL_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        PhenotypePool.h
+// Description: Recycles phenotypes and their memory across builds.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "NeuralNetwork.h"
+#include "InferenceNetwork.h"
+
+namespace NEAT
+{
+
+class Genome;
+
+//-----------------------------------------------------------------------
+// A pool of phenotypes.
+//
+// Build() hands out a network built from a genome, Release() gives it back.
+// A released network keeps all of its memory, and the next Build() rebuilds
+// a released network in place, so once the pool has grown to the number of
+// networks alive at the same time and to the size of the largest phenotype,
+// building and activating perform no allocations, whether or not the new
+// genome has the structure of the old phenotype. Setting up learning
+// (InitRTRLMatrix()) still allocates, and Build() leaves it to the caller.
+//
+// Hits count the builds that reused a released network, misses the ones
+// that had to create a new network.
+//
+// Net is NeuralNetwork or InferenceNetwork. The pool owns its networks,
+// they are deleted together with it.
+template<typename Net>
+class BasicPhenotypePool
+{
+    std::vector<Net *> m_networks; // all of them
+    std::vector<Net *> m_free;     // the released ones
+
+    unsigned long m_hits, m_misses;
+
+    // no copies, the pool owns the networks
+    BasicPhenotypePool(const BasicPhenotypePool &);
+    BasicPhenotypePool &operator=(const BasicPhenotypePool &);
+
+public:
+
+    BasicPhenotypePool();
+    ~BasicPhenotypePool();
+
+    // Returns a network built from a_Genome, to be given back with Release()
+    Net *Build(const Genome &a_Genome);
+
+    // Returns a (possibly recycled) network without building it
+    Net *Acquire();
+
+    // Gives a network back to the pool. It must come from this pool.
+    void Release(Net *a_Net);
+
+    // Gives back all networks at once, e.g. at the end of a generation
+    void ReleaseAll();
+
+    // Deletes the released networks and their memory
+    void Shrink();
+
+    unsigned long Hits() const { return m_hits; }
+    unsigned long Misses() const { return m_misses; }
+    void ResetCounters() { m_hits = m_misses = 0; }
+
+    unsigned int NumNetworks() const { return static_cast<unsigned int>(m_networks.size()); }
+    unsigned int NumAvailable() const { return static_cast<unsigned int>(m_free.size()); }
+};
+
+typedef BasicPhenotypePool<NeuralNetwork> PhenotypePool;
+typedef BasicPhenotypePool<InferenceNetwork> InferencePhenotypePool;
+
+} // namespace NEAT
+
+#endif
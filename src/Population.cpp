@@ -94,7 +94,7 @@ Population::Population(const Genome& a_Seed, const Parameters& a_Parameters,
                     {
                         if (i != j) // don't compare the same genome
                         {
-                            if (m_Genomes[i].CompatibilityDistance(m_Genomes[j], m_Parameters) < 0.000001) // equal genomes?
+                            if (m_Genomes[i].CompatibilityDistance(m_Genomes[j], m_Parameters, 0.000001) < 0.000001) // equal genomes?
                             {
                                 is_invalid = true;
                                 break;
@@ -269,7 +269,7 @@ void Population::Speciate()
         // if not compatible, create a new species.
         for(unsigned int j=0; j<m_Species.size(); j++)
         {
-            Genome tmp = m_Species[j].GetRepresentative();
+            const Genome &tmp = m_Species[j].GetRepresentative();
             if (m_Genomes[i].IsCompatibleWith( tmp, m_Parameters ))
             {
                 // Compatible, add to species
@@ -870,12 +870,12 @@ void Population::ReassignSpecies(unsigned int a_genome_idx)
     else
     {
         // try to find a compatible species
-        Genome t_to_compare = t_cur_species->GetRepresentative();
+        const Genome *t_to_compare = &t_cur_species->GetRepresentative();
 
         t_found = false;
         while((t_cur_species != m_Species.end()) && (!t_found))
         {
-            if (t_genome.IsCompatibleWith( t_to_compare, m_Parameters ))
+            if (t_genome.IsCompatibleWith(*t_to_compare, m_Parameters ))
             {
                 // found a compatible species
                 t_cur_species->AddIndividual(t_genome);
@@ -887,7 +887,7 @@ void Population::ReassignSpecies(unsigned int a_genome_idx)
                 t_cur_species++;
                 if (t_cur_species != m_Species.end())
                 {
-                    t_to_compare = t_cur_species->GetRepresentative();
+                    t_to_compare = &t_cur_species->GetRepresentative();
                 }
             }
         }
@@ -1027,12 +1027,12 @@ Genome* Population::Tick(Genome& a_deleted_genome)
     else
     {
         // try to find a compatible species
-        Genome t_to_compare = t_cur_species->GetRepresentative();
+        const Genome *t_to_compare = &t_cur_species->GetRepresentative();
 
         t_found = false;
         while((t_cur_species != m_Species.end()) && (!t_found))
         {
-            if (t_baby.IsCompatibleWith( t_to_compare, m_Parameters))
+            if (t_baby.IsCompatibleWith(*t_to_compare, m_Parameters))
             {
                 // found a compatible species
                 t_cur_species->AddIndividual(t_baby);
@@ -1045,7 +1045,7 @@ Genome* Population::Tick(Genome& a_deleted_genome)
                 t_cur_species++;
                 if (t_cur_species != m_Species.end())
                 {
-                    t_to_compare = t_cur_species->GetRepresentative();
+                    t_to_compare = &t_cur_species->GetRepresentative();
                 }
             }
         }
@@ -187,7 +187,9 @@ public:
 
     unsigned int GetGeneration() const { return m_Generation; }
     double GetBestFitnessEver() const { return m_BestFitnessEver; }
-    Genome GetBestGenome() const
+    // refers to a member of a species, valid until the next Epoch() or speciation
+    // (the Python binding returns a copy)
+    const Genome &GetBestGenome() const
     {
         double best = -std::numeric_limits<double>::infinity();
         int idx_species = 0;
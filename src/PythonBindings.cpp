@@ -46,7 +46,9 @@
 #include "NeuralNetwork.h"
 #include "Genes.h"
 #include "Genome.h"
+#include "PhenotypePool.h"
 #include "Population.h"
+#include "QuantizedNetwork.h"
 #include "Species.h"
 #include "Parameters.h"
 #include "Random.h"
@@ -61,6 +63,49 @@ using namespace py;
     typedef typename numpy::ndarray pyndarray;
 #endif
 
+// The activations live in the compiled plan of the network, so they are
+// written back before Python looks at the neurons. Replacing the lists makes
+// the network recompile before the next activation. Reading them does not:
+// like in C++, edits made in place must be followed by Compile(), Invalidate()
+// or UpdateParameters().
+std::vector<Neuron>& NeuralNetwork_GetNeurons(NeuralNetwork& a_Net)
+{
+    a_Net.WriteBack();
+    return a_Net.m_neurons;
+}
+
+void NeuralNetwork_SetNeurons(NeuralNetwork& a_Net, const std::vector<Neuron>& a_Neurons)
+{
+    a_Net.m_neurons = a_Neurons;
+    a_Net.Invalidate();
+}
+
+std::vector<Connection>& NeuralNetwork_GetConnections(NeuralNetwork& a_Net)
+{
+    a_Net.WriteBack();
+    return a_Net.m_connections;
+}
+
+void NeuralNetwork_SetConnections(NeuralNetwork& a_Net, const std::vector<Connection>& a_Connections)
+{
+    a_Net.m_connections = a_Connections;
+    a_Net.Invalidate();
+}
+
+// Replacing the gene lists makes the genome rebuild its lookup indexes.
+// Genes edited in place must be followed by InvalidateIndexes().
+void Genome_SetNeuronGenes(Genome& a_G, const std::vector<NeuronGene>& a_Genes)
+{
+    a_G.m_NeuronGenes = a_Genes;
+    a_G.InvalidateIndexes();
+}
+
+void Genome_SetLinkGenes(Genome& a_G, const std::vector<LinkGene>& a_Genes)
+{
+    a_G.m_LinkGenes = a_Genes;
+    a_G.InvalidateIndexes();
+}
+
 BOOST_PYTHON_MODULE(_multineat)
 {
     Py_Initialize();
@@ -102,6 +147,24 @@ BOOST_PYTHON_MODULE(_multineat)
         .value("SOFTPLUS", SOFTPLUS)
         ;
 
+    enum_<ActivationAccuracy>("ActivationAccuracy")
+        .value("ACTIVATION_EXACT", ACTIVATION_EXACT)
+        .value("ACTIVATION_FAST", ACTIVATION_FAST)
+        ;
+
+    enum_<NetworkPrecision>("NetworkPrecision")
+        .value("PRECISION_DOUBLE", PRECISION_DOUBLE)
+        .value("PRECISION_FLOAT", PRECISION_FLOAT)
+        ;
+
+    enum_<SequenceMode>("SequenceMode")
+        .value("SEQUENCE_ACTIVATE", SEQUENCE_ACTIVATE)
+        .value("SEQUENCE_FAST", SEQUENCE_FAST)
+        .value("SEQUENCE_USE_INTERNAL_BIAS", SEQUENCE_USE_INTERNAL_BIAS)
+        .value("SEQUENCE_LEAKY", SEQUENCE_LEAKY)
+        .value("SEQUENCE_FEED_FORWARD", SEQUENCE_FEED_FORWARD)
+        ;
+
     enum_<SearchMode>("SearchMode")
         .value("COMPLEXIFYING", COMPLEXIFYING)
         .value("SIMPLIFYING", SIMPLIFYING)
@@ -155,11 +218,41 @@ BOOST_PYTHON_MODULE(_multineat)
     void (NeuralNetwork::*NN_Save)(const char*) = &NeuralNetwork::Save;
     bool (NeuralNetwork::*NN_Load)(const char*) = &NeuralNetwork::Load;
     void (Genome::*Genome_Save)(const char*) = &Genome::Save;
+    void (Genome::*Genome_BuildPhenotype)(NeuralNetwork&) const = &Genome::BuildPhenotype;
+    void (Genome::*Genome_BuildInferencePhenotype)(InferenceNetwork&) const = &Genome::BuildPhenotype;
     void (NeuralNetwork::*NN_Input)(const py::list&) = &NeuralNetwork::Input_python_list;
     void (NeuralNetwork::*NN_Input_numpy)(const pyndarray&) = &NeuralNetwork::Input_numpy;
+    void (NeuralNetwork::*NN_RTRL_update_error)(double) = &NeuralNetwork::RTRL_update_error;
+    void (NeuralNetwork::*NN_RTRL_update_error_multi)(const std::vector<double>&) = &NeuralNetwork::RTRL_update_error;
     void (Parameters::*Parameters_Save)(const char*) = &Parameters::Save;
     int (Parameters::*Parameters_Load)(const char*) = &Parameters::Load;
 
+    class_<OptimizationOptions>("OptimizationOptions", init<>())
+            .def_readwrite("remove_dead", &OptimizationOptions::m_remove_dead)
+            .def_readwrite("min_weight", &OptimizationOptions::m_min_weight)
+            .def_readwrite("propagate_constants", &OptimizationOptions::m_propagate_constants)
+            .def_readwrite("fold_linear", &OptimizationOptions::m_fold_linear)
+            .def_readwrite("use_bias", &OptimizationOptions::m_use_bias)
+            .def_readwrite("bias_inputs_are_one", &OptimizationOptions::m_bias_inputs_are_one)
+            ;
+
+    class_<OptimizationReport>("OptimizationReport", init<>())
+            .def_readonly("neurons_before", &OptimizationReport::m_neurons_before)
+            .def_readonly("neurons_after", &OptimizationReport::m_neurons_after)
+            .def_readonly("connections_before", &OptimizationReport::m_connections_before)
+            .def_readonly("connections_after", &OptimizationReport::m_connections_after)
+            .def_readonly("dead_neurons", &OptimizationReport::m_dead_neurons)
+            .def_readonly("constant_neurons", &OptimizationReport::m_constant_neurons)
+            .def_readonly("folded_neurons", &OptimizationReport::m_folded_neurons)
+            .def_readonly("weak_connections", &OptimizationReport::m_weak_connections)
+            ;
+
+    class_<EmitOptions>("EmitOptions", init<>())
+            .def_readwrite("function_name", &EmitOptions::m_function_name)
+            .def_readwrite("mode", &EmitOptions::m_mode)
+            .def_readwrite("use_float", &EmitOptions::m_float)
+            ;
+
     class_<NeuralNetwork>("NeuralNetwork", init<>())
 
             .def(init<bool>())
@@ -169,10 +262,23 @@ BOOST_PYTHON_MODULE(_multineat)
             .def("RTRL_update_gradients",
             &NeuralNetwork::RTRL_update_gradients)
             .def("RTRL_update_error",
-            &NeuralNetwork::RTRL_update_error)
+            NN_RTRL_update_error_multi)
+            .def("RTRL_update_error",
+            NN_RTRL_update_error)
             .def("RTRL_update_weights",
             &NeuralNetwork::RTRL_update_weights)
 
+            .def("Compile",
+            &NeuralNetwork::Compile)
+            .def("Invalidate",
+            &NeuralNetwork::Invalidate)
+            .def("GetGeneration",
+            &NeuralNetwork::GetGeneration)
+            .def("UpdateParameters",
+            &NeuralNetwork::UpdateParameters)
+            .def("WriteBack",
+            &NeuralNetwork::WriteBack)
+
             .def("ActivateFast",
             &NeuralNetwork::ActivateFast)
             .def("Activate",
@@ -181,6 +287,31 @@ BOOST_PYTHON_MODULE(_multineat)
             &NeuralNetwork::ActivateUseInternalBias)
             .def("ActivateLeaky",
             &NeuralNetwork::ActivateLeaky)
+            .def("ActivateFeedForward",
+            &NeuralNetwork::ActivateFeedForward)
+            .def("IsFeedForward",
+            &NeuralNetwork::IsFeedForward)
+            .def("NumDenseBlocks",
+            &NeuralNetwork::NumDenseBlocks)
+            .def("ActivateUntilStable",
+            &NeuralNetwork::ActivateUntilStable, (arg("tolerance") = 1e-6, arg("max_iterations") = 100))
+            .def("GetStableIterations",
+            &NeuralNetwork::GetStableIterations)
+            .def("ResetStableIterations",
+            &NeuralNetwork::ResetStableIterations)
+
+            .def("SetParallelActivation",
+            &NeuralNetwork::SetParallelActivation, (arg("threads"), arg("min_connections") = 100000))
+            .def("GetParallelThreads",
+            &NeuralNetwork::GetParallelThreads)
+            .def("SetActivationAccuracy",
+            &NeuralNetwork::SetActivationAccuracy)
+            .def("GetActivationAccuracy",
+            &NeuralNetwork::GetActivationAccuracy)
+            .def("SetPrecision",
+            &NeuralNetwork::SetPrecision)
+            .def("GetPrecision",
+            &NeuralNetwork::GetPrecision)
 
             .def("Adapt",
             &NeuralNetwork::Adapt)
@@ -201,6 +332,10 @@ BOOST_PYTHON_MODULE(_multineat)
             NN_Save)
             .def("Load",
             NN_Load)
+            .def("SaveBinary",
+            &NeuralNetwork::SaveBinary)
+            .def("LoadBinary",
+            &NeuralNetwork::LoadBinary)
 
             .def("Input",
             NN_Input)
@@ -208,6 +343,16 @@ BOOST_PYTHON_MODULE(_multineat)
             NN_Input_numpy)
             .def("Output",
             &NeuralNetwork::Output)
+            .def("RunSequence",
+            &NeuralNetwork::RunSequence_python,
+            (arg("inputs"), arg("mode") = SEQUENCE_ACTIVATE, arg("step") = 0.0,
+             arg("adapt_parameters") = ptr(static_cast<Parameters*>(NULL))))
+            .def("Optimize",
+            &NeuralNetwork::Optimize_python,
+            (arg("options") = OptimizationOptions()))
+            .def("EmitCpp",
+            &NeuralNetwork::EmitCpp_python,
+            (arg("options") = EmitOptions()))
             
             .def("AddNeuron",
             &NeuralNetwork::AddNeuron)
@@ -219,8 +364,123 @@ BOOST_PYTHON_MODULE(_multineat)
             .def("GetTotalConnectionLength", &NeuralNetwork::GetTotalConnectionLength)
 
 
-            .def_readwrite("neurons", &NeuralNetwork::m_neurons)
-            .def_readwrite("connections", &NeuralNetwork::m_connections)
+            .add_property("neurons",
+            make_function(&NeuralNetwork_GetNeurons, return_internal_reference<>()),
+            &NeuralNetwork_SetNeurons)
+            .add_property("connections",
+            make_function(&NeuralNetwork_GetConnections, return_internal_reference<>()),
+            &NeuralNetwork_SetConnections)
+            ;
+
+    std::vector<double> (InferenceNetwork::*IN_Output)() const = &InferenceNetwork::Output;
+
+    class_<InferenceNetwork>("InferenceNetwork", init<>())
+
+            .def("ActivateFast",
+            &InferenceNetwork::ActivateFast)
+            .def("Activate",
+            &InferenceNetwork::Activate)
+            .def("ActivateUseInternalBias",
+            &InferenceNetwork::ActivateUseInternalBias)
+            .def("ActivateLeaky",
+            &InferenceNetwork::ActivateLeaky)
+
+            .def("SetActivationAccuracy",
+            &InferenceNetwork::SetActivationAccuracy)
+            .def("GetActivationAccuracy",
+            &InferenceNetwork::GetActivationAccuracy)
+
+            .def("Flush",
+            &InferenceNetwork::Flush)
+            .def("Clear",
+            &InferenceNetwork::Clear)
+            .def("LoadMapped",
+            &InferenceNetwork::LoadMapped, (arg("filename"), arg("verify_checksum") = true))
+            .def("IsMapped",
+            &InferenceNetwork::IsMapped)
+
+            .def("NumInputs",
+            &InferenceNetwork::NumInputs)
+            .def("NumOutputs",
+            &InferenceNetwork::NumOutputs)
+            .def("NumNeurons",
+            &InferenceNetwork::NumNeurons)
+            .def("NumConnections",
+            &InferenceNetwork::NumConnections)
+            .def("MemoryUsage",
+            &InferenceNetwork::MemoryUsage)
+
+            .def("Input",
+            &InferenceNetwork::Input_python_list)
+            .def("Output",
+            IN_Output)
+            ;
+
+    class_<QuantizationReport>("QuantizationReport", init<>())
+            .def_readonly("max_error", &QuantizationReport::m_max_error)
+            .def_readonly("mean_error", &QuantizationReport::m_mean_error)
+            .def_readonly("samples", &QuantizationReport::m_samples)
+            ;
+
+    std::vector<double> (QuantizedNetwork8::*QN8_Output)() const = &QuantizedNetwork8::Output;
+    std::vector<double> (QuantizedNetwork16::*QN16_Output)() const = &QuantizedNetwork16::Output;
+
+    class_<QuantizedNetwork8>("QuantizedNetwork8", init<>())
+            .def("Build", &QuantizedNetwork8::Build_python_list,
+                 (arg("network"), arg("calibration"), arg("headroom") = 1.0))
+            .def("MeasureAccuracy", &QuantizedNetwork8::MeasureAccuracy_python_list)
+            .def("Activate", static_cast<void (QuantizedNetwork8::*)()>(&QuantizedNetwork8::Activate))
+            .def("ActivateUseInternalBias", &QuantizedNetwork8::ActivateUseInternalBias)
+            .def("Flush", &QuantizedNetwork8::Flush)
+            .def("Clear", &QuantizedNetwork8::Clear)
+            .def("Input", &QuantizedNetwork8::Input_python_list)
+            .def("Output", QN8_Output)
+            .def("NumInputs", &QuantizedNetwork8::NumInputs)
+            .def("NumOutputs", &QuantizedNetwork8::NumOutputs)
+            .def("NumNeurons", &QuantizedNetwork8::NumNeurons)
+            .def("NumConnections", &QuantizedNetwork8::NumConnections)
+            .def("MemoryUsage", &QuantizedNetwork8::MemoryUsage)
+            ;
+
+    class_<QuantizedNetwork16>("QuantizedNetwork16", init<>())
+            .def("Build", &QuantizedNetwork16::Build_python_list,
+                 (arg("network"), arg("calibration"), arg("headroom") = 1.0))
+            .def("MeasureAccuracy", &QuantizedNetwork16::MeasureAccuracy_python_list)
+            .def("Activate", static_cast<void (QuantizedNetwork16::*)()>(&QuantizedNetwork16::Activate))
+            .def("ActivateUseInternalBias", &QuantizedNetwork16::ActivateUseInternalBias)
+            .def("Flush", &QuantizedNetwork16::Flush)
+            .def("Clear", &QuantizedNetwork16::Clear)
+            .def("Input", &QuantizedNetwork16::Input_python_list)
+            .def("Output", QN16_Output)
+            .def("NumInputs", &QuantizedNetwork16::NumInputs)
+            .def("NumOutputs", &QuantizedNetwork16::NumOutputs)
+            .def("NumNeurons", &QuantizedNetwork16::NumNeurons)
+            .def("NumConnections", &QuantizedNetwork16::NumConnections)
+            .def("MemoryUsage", &QuantizedNetwork16::MemoryUsage)
+            ;
+
+    class_<PhenotypePool, boost::noncopyable>("PhenotypePool", init<>())
+            .def("Build", &PhenotypePool::Build, return_value_policy<reference_existing_object>())
+            .def("Release", &PhenotypePool::Release)
+            .def("ReleaseAll", &PhenotypePool::ReleaseAll)
+            .def("Shrink", &PhenotypePool::Shrink)
+            .def("Hits", &PhenotypePool::Hits)
+            .def("Misses", &PhenotypePool::Misses)
+            .def("ResetCounters", &PhenotypePool::ResetCounters)
+            .def("NumNetworks", &PhenotypePool::NumNetworks)
+            .def("NumAvailable", &PhenotypePool::NumAvailable)
+            ;
+
+    class_<InferencePhenotypePool, boost::noncopyable>("InferencePhenotypePool", init<>())
+            .def("Build", &InferencePhenotypePool::Build, return_value_policy<reference_existing_object>())
+            .def("Release", &InferencePhenotypePool::Release)
+            .def("ReleaseAll", &InferencePhenotypePool::ReleaseAll)
+            .def("Shrink", &InferencePhenotypePool::Shrink)
+            .def("Hits", &InferencePhenotypePool::Hits)
+            .def("Misses", &InferencePhenotypePool::Misses)
+            .def("ResetCounters", &InferencePhenotypePool::ResetCounters)
+            .def("NumNetworks", &InferencePhenotypePool::NumNetworks)
+            .def("NumAvailable", &InferencePhenotypePool::NumAvailable)
             ;
 
 
@@ -266,8 +526,13 @@ BOOST_PYTHON_MODULE(_multineat)
             .def("NumInputs", &Genome::NumInputs)
             .def("NumOutputs", &Genome::NumOutputs)
 
-            .def_readwrite("NeuronGenes", &Genome::m_NeuronGenes)
-            .def_readwrite("LinkGenes", &Genome::m_LinkGenes)
+            .add_property("NeuronGenes",
+            make_getter(&Genome::m_NeuronGenes, return_internal_reference<>()),
+            &Genome_SetNeuronGenes)
+            .add_property("LinkGenes",
+            make_getter(&Genome::m_LinkGenes, return_internal_reference<>()),
+            &Genome_SetLinkGenes)
+            .def("InvalidateIndexes", &Genome::InvalidateIndexes)
             .def_readwrite("behavior", &Genome::m_behavior)
 
             .def("GetFitness", &Genome::GetFitness)
@@ -279,12 +544,15 @@ BOOST_PYTHON_MODULE(_multineat)
             .def("GetDepth", &Genome::GetDepth)
             .def("CalculateDepth", &Genome::CalculateDepth)
             .def("DerivePhenotypicChanges", &Genome::DerivePhenotypicChanges)
-            .def("CompatibilityDistance", &Genome::CompatibilityDistance)
+            .def("CompatibilityDistance", static_cast<double (Genome::*)(const Genome&, const Parameters&) const>(&Genome::CompatibilityDistance))
+            .def("CompatibilityDistance", static_cast<double (Genome::*)(const Genome&, const Parameters&, double) const>(&Genome::CompatibilityDistance))
             .def("IsCompatibleWith", &Genome::IsCompatibleWith)
 
             .def("PrintAllTraits", &Genome::PrintAllTraits)
 
-            .def("BuildPhenotype", &Genome::BuildPhenotype)
+            .def("BuildPhenotype", Genome_BuildPhenotype)
+            .def("BuildPhenotype", Genome_BuildInferencePhenotype)
+            .def("StructureSignature", &Genome::StructureSignature)
             .def("BuildHyperNEATPhenotype", &Genome::BuildHyperNEATPhenotype)
             .def("BuildESHyperNEATPhenotype", &Genome::BuildESHyperNEATPhenotype)
 
@@ -320,7 +588,7 @@ BOOST_PYTHON_MODULE(_multineat)
 ///////////////////////////////////////////////////////////////////
 
     class_<Species>("Species", init<Genome, int>())
-            .def("GetLeader", &Species::GetLeader)
+            .def("GetLeader", &Species::GetLeader, return_value_policy<copy_const_reference>())
             .def("NumIndividuals", &Species::NumIndividuals)
             .def("GensNoImprovement", &Species::GensNoImprovement)
             .def("ID", &Species::ID)
@@ -403,7 +671,7 @@ BOOST_PYTHON_MODULE(_multineat)
             .def("NoveltySearchTick", &Population::NoveltySearchTick)
             .def("Save", &Population::Save)
             .def("GetBestFitnessEver", &Population::GetBestFitnessEver)
-            .def("GetBestGenome", &Population::GetBestGenome)
+            .def("GetBestGenome", &Population::GetBestGenome, return_value_policy<copy_const_reference>())
             .def("GetSearchMode", &Population::GetSearchMode)
             .def("GetCurrentMPC", &Population::GetCurrentMPC)
             .def("GetBaseMPC", &Population::GetBaseMPC)
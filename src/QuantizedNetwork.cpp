@@ -0,0 +1,453 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        QuantizedNetwork.cpp
+// Description: Implementation of the fixed-point inference export.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+#include "QuantizedNetwork.h"
+#include "NeuralNetwork.h"
+#include "MultiNEATAssert.h"
+
+namespace NEAT
+{
+
+const int QuantizationTraits<int8_t>::MAX;
+const int QuantizationTraits<int16_t>::MAX;
+
+///////////////////////////////////////
+// Activation lookup tables
+///////////////////////////////////////
+
+const unsigned int TABLE_SIZE = 2048;
+const double TWO_PI = 6.283185307179586;
+
+// y = f(t) sampled on [m_lo, m_hi], linearly interpolated in between and clamped outside
+struct ActivationTable
+{
+    float m_lo, m_hi, m_scale;
+    float m_y[TABLE_SIZE];
+
+    template<typename F>
+    void Init(double a_Lo, double a_Hi, F a_Function)
+    {
+        m_lo = static_cast<float>(a_Lo);
+        m_hi = static_cast<float>(a_Hi);
+        m_scale = static_cast<float>((TABLE_SIZE - 1) / (a_Hi - a_Lo));
+        for (unsigned int i = 0; i < TABLE_SIZE; i++)
+        {
+            m_y[i] = static_cast<float>(a_Function(a_Lo + (a_Hi - a_Lo) * i / (TABLE_SIZE - 1)));
+        }
+    }
+
+    float operator()(float a_T) const
+    {
+        float t_pos = (std::min(std::max(a_T, m_lo), m_hi) - m_lo) * m_scale;
+        unsigned int t_i = std::min(static_cast<unsigned int>(t_pos), TABLE_SIZE - 2);
+        float t_frac = t_pos - t_i;
+        return m_y[t_i] + t_frac * (m_y[t_i + 1] - m_y[t_i]);
+    }
+};
+
+double sigmoid(double t) { return 1.0 / (1.0 + exp(-t)); }
+double softplus(double t) { return log(1.0 + exp(t)); }
+
+struct ActivationTables
+{
+    ActivationTable m_sigmoid, m_tanh, m_exp, m_sine, m_softplus;
+
+    ActivationTables()
+    {
+        m_sigmoid.Init(-12.0, 12.0, sigmoid);
+        m_tanh.Init(-6.0, 6.0, static_cast<double (*)(double)>(tanh));
+        m_exp.Init(-16.0, 0.0, static_cast<double (*)(double)>(exp));
+        m_sine.Init(0.0, TWO_PI, static_cast<double (*)(double)>(sin));
+        m_softplus.Init(-12.0, 12.0, softplus);
+    }
+};
+
+const ActivationTables &Tables()
+{
+    static const ActivationTables t_tables;
+    return t_tables;
+}
+
+// The activation functions of Activation.h on top of the tables
+float QuantizedActivation(const ActivationTables &a_Tables, ActivationFunction a_Type, float a_X, float a_A, float a_B)
+{
+    switch (a_Type)
+    {
+    case SIGNED_SIGMOID:
+        return (a_Tables.m_sigmoid(a_A * a_X + a_B) - 0.5f) * 2.0f;
+    case UNSIGNED_SIGMOID:
+        return a_Tables.m_sigmoid(a_A * a_X + a_B);
+    case TANH:
+        return a_Tables.m_tanh(a_X * a_A);
+    case TANH_CUBIC:
+        return a_Tables.m_tanh(a_X * a_X * a_X * a_A);
+    case SIGNED_STEP:
+        return (a_X > a_B) ? 1.0f : -1.0f;
+    case UNSIGNED_STEP:
+        return (a_X > (0.5f + a_B)) ? 1.0f : 0.0f;
+    case SIGNED_GAUSS:
+    case UNSIGNED_GAUSS:
+    {
+        // the table holds exp() of the non-positive arguments
+        float t_t = -a_A * a_X * a_X + a_B;
+        float t_y = (t_t <= 0) ? a_Tables.m_exp(t_t) : static_cast<float>(exp(t_t));
+        return (a_Type == SIGNED_GAUSS) ? (t_y - 0.5f) * 2.0f : t_y;
+    }
+    case ABS:
+        return std::fabs(a_X + a_B);
+    case SIGNED_SINE:
+    case UNSIGNED_SINE:
+    {
+        double t_t = a_X * a_A + a_B;
+        float t_y = a_Tables.m_sine(static_cast<float>(t_t - TWO_PI * floor(t_t / TWO_PI)));
+        return (a_Type == SIGNED_SINE) ? t_y : (t_y + 1.0f) / 2.0f;
+    }
+    case LINEAR:
+        return a_X + a_B;
+    case RELU:
+        return (a_X > 0) ? a_X : 0.0f;
+    case SOFTPLUS:
+        return (a_X > 12.0f) ? a_X : a_Tables.m_softplus(a_X);
+    default:
+        return a_Tables.m_sigmoid(a_A * a_X + a_B);
+    }
+}
+
+// rounds to the nearest integer in [-MAX, MAX]
+template<typename W>
+W Quantize(double a_Value)
+{
+    const double t_max = QuantizationTraits<W>::MAX;
+    return static_cast<W>(std::min(std::max(static_cast<double>(lrint(a_Value)), -t_max), t_max));
+}
+
+///////////////////////////////////////
+// Quantised network
+///////////////////////////////////////
+
+template<typename W>
+BasicQuantizedNetwork<W>::BasicQuantizedNetwork()
+{
+    m_num_inputs = m_num_outputs = 0;
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Clear()
+{
+    m_num_inputs = m_num_outputs = 0;
+    m_row_start.clear();
+    m_source.clear();
+    m_weight.clear();
+    m_row_scale.clear();
+    m_scale.clear();
+    m_inv_scale.clear();
+    m_act_type.clear();
+    m_a.clear();
+    m_b.clear();
+    m_bias.clear();
+    m_activation.clear();
+    m_sum.clear();
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Build(const NeuralNetwork &a_Net, const std::vector< std::vector<double> > &a_Calibration,
+                                     double a_Headroom)
+{
+    const unsigned int t_num_neurons = static_cast<unsigned int>(a_Net.m_neurons.size());
+    const std::vector<Connection> &t_conns = a_Net.m_connections;
+
+    Clear();
+    m_num_inputs = a_Net.NumInputs();
+    m_num_outputs = a_Net.NumOutputs();
+
+    // calibrate - the largest absolute activation of every neuron
+    std::vector<double> t_range(t_num_neurons, 0.0);
+    if (a_Calibration.empty())
+    {
+        t_range.assign(t_num_neurons, 1.0);
+    }
+    else
+    {
+        NeuralNetwork t_net = a_Net;
+        t_net.SetPrecision(PRECISION_DOUBLE);
+        t_net.Flush();
+        for (unsigned int s = 0; s < a_Calibration.size(); s++)
+        {
+            t_net.Input(a_Calibration[s]);
+            t_net.Activate();
+            t_net.WriteBack();
+            for (unsigned int i = 0; i < t_num_neurons; i++)
+            {
+                t_range[i] = std::max(t_range[i], std::fabs(t_net.m_neurons[i].m_activation));
+            }
+        }
+    }
+
+    const double t_max = QuantizationTraits<W>::MAX;
+    m_scale.resize(t_num_neurons);
+    m_inv_scale.resize(t_num_neurons);
+    m_act_type.resize(t_num_neurons);
+    m_a.resize(t_num_neurons);
+    m_b.resize(t_num_neurons);
+    m_bias.resize(t_num_neurons);
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        // a neuron that was never active keeps the range [-1, 1]
+        double t_scale = ((t_range[i] > 0) && std::isfinite(t_range[i])) ? t_range[i] * a_Headroom / t_max : 1.0 / t_max;
+        m_scale[i] = static_cast<float>(t_scale);
+        m_inv_scale[i] = static_cast<float>(1.0 / t_scale);
+
+        const Neuron &t_n = a_Net.m_neurons[i];
+        m_act_type[i] = static_cast<unsigned char>(t_n.m_activation_function_type);
+        m_a[i] = static_cast<float>(t_n.m_a);
+        m_b[i] = static_cast<float>(t_n.m_b);
+        m_bias[i] = static_cast<float>(t_n.m_bias);
+    }
+
+    // the rows, in the original order of the connections; connections into inputs are dropped
+    m_row_start.assign(t_num_neurons + 1, 0);
+    for (unsigned int i = 0; i < t_conns.size(); i++)
+    {
+        if (static_cast<unsigned int>(t_conns[i].m_target_neuron_idx) >= m_num_inputs)
+        {
+            m_row_start[t_conns[i].m_target_neuron_idx + 1]++;
+        }
+    }
+    for (unsigned int i = 0; i < t_num_neurons; i++)
+    {
+        m_row_start[i + 1] += m_row_start[i];
+    }
+
+    // the weights times the scales of their sources, in double until they are quantised
+    std::vector<double> t_weight(m_row_start[t_num_neurons]);
+    std::vector<unsigned int> t_fill(m_row_start.begin(), m_row_start.end() - 1);
+    m_source.resize(t_weight.size());
+    for (unsigned int i = 0; i < t_conns.size(); i++)
+    {
+        const unsigned int t_target = t_conns[i].m_target_neuron_idx;
+        if (t_target < m_num_inputs)
+        {
+            continue;
+        }
+        const unsigned int t_slot = t_fill[t_target]++;
+        m_source[t_slot] = t_conns[i].m_source_neuron_idx;
+        t_weight[t_slot] = t_conns[i].m_weight * m_scale[m_source[t_slot]];
+    }
+
+    m_weight.resize(t_weight.size());
+    m_row_scale.assign(t_num_neurons, 0.0f);
+    for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+    {
+        double t_largest = 0;
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            t_largest = std::max(t_largest, std::fabs(t_weight[k]));
+        }
+
+        const double t_row_scale = (t_largest > 0) ? t_largest / t_max : 1.0;
+        m_row_scale[i] = static_cast<float>(t_row_scale);
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            m_weight[k] = Quantize<W>(t_weight[k] / t_row_scale);
+        }
+    }
+
+    m_activation.assign(t_num_neurons, 0);
+    m_sum.assign(t_num_neurons, 0.0f);
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Activate(bool a_UseBias)
+{
+    const ActivationTables &t_tables = Tables();
+    const unsigned int t_num_neurons = NumNeurons();
+    const W *t_act = m_activation.data();
+    const W *t_w = m_weight.data();
+    const unsigned int *t_src = m_source.data();
+
+    // all sums first, every neuron sees the activations of the previous step
+    for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+    {
+        Accumulator t_acc = 0;
+        for (unsigned int k = m_row_start[i]; k < m_row_start[i + 1]; k++)
+        {
+            t_acc += static_cast<Accumulator>(t_w[k]) * t_act[t_src[k]];
+        }
+        m_sum[i] = static_cast<float>(t_acc) * m_row_scale[i];
+    }
+
+    for (unsigned int i = m_num_inputs; i < t_num_neurons; i++)
+    {
+        const float t_x = a_UseBias ? (m_sum[i] + m_bias[i]) : m_sum[i];
+        const float t_y = QuantizedActivation(t_tables, static_cast<ActivationFunction>(m_act_type[i]),
+                                              t_x, m_a[i], m_b[i]);
+        m_activation[i] = Quantize<W>(t_y * m_inv_scale[i]);
+    }
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Flush()
+{
+    std::fill(m_activation.begin(), m_activation.end(), 0);
+    std::fill(m_sum.begin(), m_sum.end(), 0.0f);
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Input(const double *a_Inputs, unsigned int a_Count)
+{
+    const unsigned int t_count = std::min(a_Count, m_num_inputs);
+    for (unsigned int i = 0; i < t_count; i++)
+    {
+        m_activation[i] = Quantize<W>(a_Inputs[i] * m_inv_scale[i]);
+    }
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Input(const std::vector<double> &a_Inputs)
+{
+    Input(a_Inputs.data(), static_cast<unsigned int>(a_Inputs.size()));
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Output(double *a_Outputs) const
+{
+    for (unsigned int i = 0; i < m_num_outputs; i++)
+    {
+        a_Outputs[i] = GetActivation(m_num_inputs + i);
+    }
+}
+
+template<typename W>
+std::vector<double> BasicQuantizedNetwork<W>::Output() const
+{
+    std::vector<double> t_outputs(m_num_outputs);
+    Output(t_outputs.data());
+    return t_outputs;
+}
+
+template<typename W>
+QuantizationReport BasicQuantizedNetwork<W>::MeasureAccuracy(const NeuralNetwork &a_Net,
+                                                            const std::vector< std::vector<double> > &a_Samples)
+{
+    NeuralNetwork t_net = a_Net;
+    t_net.SetPrecision(PRECISION_DOUBLE);
+    t_net.Flush();
+    Flush();
+
+    QuantizationReport t_report;
+    t_report.m_max_error = 0;
+    t_report.m_mean_error = 0;
+    t_report.m_samples = static_cast<unsigned int>(a_Samples.size());
+
+    std::vector<double> t_outputs(m_num_outputs);
+    for (unsigned int s = 0; s < a_Samples.size(); s++)
+    {
+        t_net.Input(a_Samples[s]);
+        t_net.Activate();
+        Input(a_Samples[s]);
+        Activate();
+
+        std::vector<double> t_reference = t_net.Output();
+        Output(t_outputs.data());
+        for (unsigned int i = 0; i < m_num_outputs; i++)
+        {
+            double t_error = std::fabs(t_outputs[i] - t_reference[i]);
+            t_report.m_max_error = std::max(t_report.m_max_error, t_error);
+            t_report.m_mean_error += t_error;
+        }
+    }
+    if (!a_Samples.empty() && (m_num_outputs > 0))
+    {
+        t_report.m_mean_error /= static_cast<double>(a_Samples.size()) * m_num_outputs;
+    }
+
+    return t_report;
+}
+
+template<typename W>
+size_t BasicQuantizedNetwork<W>::MemoryUsage() const
+{
+    return (m_row_start.size() + m_source.size()) * sizeof(unsigned int) +
+           (m_weight.size() + m_activation.size()) * sizeof(W) +
+           (m_row_scale.size() + m_scale.size() + m_inv_scale.size() + m_a.size() + m_b.size() +
+            m_bias.size() + m_sum.size()) * sizeof(float) +
+           m_act_type.size();
+}
+
+#ifdef USE_BOOST_PYTHON
+
+std::vector< std::vector<double> > ListOfRows(const py::list &a_Rows)
+{
+    std::vector< std::vector<double> > t_rows(py::len(a_Rows));
+    for (unsigned int s = 0; s < t_rows.size(); s++)
+    {
+        py::object t_row = a_Rows[s];
+        t_rows[s].resize(py::len(t_row));
+        for (unsigned int i = 0; i < t_rows[s].size(); i++)
+        {
+            t_rows[s][i] = py::extract<double>(t_row[i]);
+        }
+    }
+    return t_rows;
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Build_python_list(const NeuralNetwork &a_Net, const py::list &a_Calibration,
+                                                 double a_Headroom)
+{
+    Build(a_Net, ListOfRows(a_Calibration), a_Headroom);
+}
+
+template<typename W>
+QuantizationReport BasicQuantizedNetwork<W>::MeasureAccuracy_python_list(const NeuralNetwork &a_Net,
+                                                                        const py::list &a_Samples)
+{
+    return MeasureAccuracy(a_Net, ListOfRows(a_Samples));
+}
+
+template<typename W>
+void BasicQuantizedNetwork<W>::Input_python_list(const py::list &a_Inputs)
+{
+    std::vector<double> t_inputs(py::len(a_Inputs));
+    for (unsigned int i = 0; i < t_inputs.size(); i++)
+    {
+        t_inputs[i] = py::extract<double>(a_Inputs[i]);
+    }
+    Input(t_inputs);
+}
+
+#endif
+
+template class BasicQuantizedNetwork<int8_t>;
+template class BasicQuantizedNetwork<int16_t>;
+
+} // namespace NEAT
@@ -0,0 +1,167 @@
+#ifndef _QUANTIZEDNETWORK_H
+#define _QUANTIZEDNETWORK_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        QuantizedNetwork.h
+// Description: Fixed-point (int8/int16) inference export of a phenotype.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <stdint.h>
+#include "Genes.h"
+
+namespace NEAT
+{
+
+class NeuralNetwork;
+
+// The integer types of a quantised network with weights of type W
+template<typename W> struct QuantizationTraits;
+
+template<> struct QuantizationTraits<int8_t>
+{
+    typedef int32_t Accumulator;
+    static const int MAX = 127;
+};
+
+// int16 x int16 products overflow 32 bits after two terms, hence the wider accumulator
+template<> struct QuantizationTraits<int16_t>
+{
+    typedef int64_t Accumulator;
+    static const int MAX = 32767;
+};
+
+// How close a quantised network comes to the double precision one,
+// see BasicQuantizedNetwork::MeasureAccuracy()
+struct QuantizationReport
+{
+    double m_max_error;   // the largest absolute error of an output
+    double m_mean_error;  // the mean absolute error of the outputs
+    unsigned int m_samples;
+};
+
+//-----------------------------------------------------------------------
+// A fixed-point copy of a NeuralNetwork for deployment.
+//
+// The weights are W (int8_t or int16_t), the activations are W as well and
+// the sums are accumulated in integers (QuantizationTraits<W>::Accumulator).
+// Every neuron has its own activation scale, calibrated by running the
+// network on sample inputs: the largest absolute activation seen maps to
+// the largest W. The scale of the source neuron is folded into each weight,
+// and every row of weights gets its own scale, so a neuron's input sum is
+// one integer dot product times one float factor.
+//
+// The activation functions are evaluated on the dequantised sum, using
+// interpolated lookup tables for the transcendental ones (sigmoid, tanh,
+// gauss, sine, softplus). Activations outside the calibrated range saturate.
+//
+// The neurons keep the order they have in the NeuralNetwork. Only Activate()
+// and ActivateUseInternalBias() are supported, there is no learning.
+template<typename W>
+class BasicQuantizedNetwork
+{
+    typedef typename QuantizationTraits<W>::Accumulator Accumulator;
+
+    unsigned int m_num_inputs, m_num_outputs;
+
+    // m_row_start[i] .. m_row_start[i+1] are the incoming connections of neuron i
+    std::vector<unsigned int> m_row_start;
+    std::vector<unsigned int> m_source;
+    std::vector<W> m_weight;
+
+    std::vector<float> m_row_scale; // [neuron] the sum is the integer dot product times this
+    std::vector<float> m_scale;     // [neuron] an activation is its integer value times this
+    std::vector<float> m_inv_scale; // [neuron] 1 / m_scale
+
+    std::vector<unsigned char> m_act_type; // ActivationFunction of every neuron
+    std::vector<float> m_a, m_b, m_bias;
+
+    // state
+    std::vector<W> m_activation;
+    std::vector<float> m_sum;
+
+    void Activate(bool a_UseBias);
+
+public:
+
+    BasicQuantizedNetwork();
+
+    // Builds the quantised copy of a_Net. The activation scales are calibrated by
+    // feeding the rows of a_Calibration one after another into a flushed copy of
+    // a_Net, with one Activate() each - like the network will be used. Without
+    // calibration data every activation is assumed to lie within [-1, 1].
+    // The calibrated ranges are widened by a_Headroom, for inputs that drive the
+    // network a little further than the calibration data did.
+    void Build(const NeuralNetwork &a_Net, const std::vector< std::vector<double> > &a_Calibration,
+               double a_Headroom = 1.0);
+
+    void Clear();
+
+    void Activate() { Activate(false); }
+    void ActivateUseInternalBias() { Activate(true); }
+
+    void Flush(); // clears all activations
+
+    // Feeds the rows of a_Samples through a flushed copy of a_Net and through this
+    // network (flushed as well), one Activate() each, and compares their outputs.
+    QuantizationReport MeasureAccuracy(const NeuralNetwork &a_Net,
+                                       const std::vector< std::vector<double> > &a_Samples);
+
+    // a_Count is clipped to the number of inputs, out of range inputs saturate
+    void Input(const double *a_Inputs, unsigned int a_Count);
+    void Input(const std::vector<double> &a_Inputs);
+
+    void Output(double *a_Outputs) const;
+    std::vector<double> Output() const;
+
+#ifdef USE_BOOST_PYTHON
+
+    void Build_python_list(const NeuralNetwork &a_Net, const py::list &a_Calibration, double a_Headroom);
+    QuantizationReport MeasureAccuracy_python_list(const NeuralNetwork &a_Net, const py::list &a_Samples);
+    void Input_python_list(const py::list &a_Inputs);
+
+#endif
+
+    // accessor methods
+    unsigned int NumInputs() const { return m_num_inputs; }
+    unsigned int NumOutputs() const { return m_num_outputs; }
+    unsigned int NumNeurons() const { return static_cast<unsigned int>(m_act_type.size()); }
+    unsigned int NumConnections() const { return static_cast<unsigned int>(m_weight.size()); }
+
+    // the bytes of all arrays
+    size_t MemoryUsage() const;
+
+    double GetActivation(unsigned int a_neuron) const { return m_activation[a_neuron] * static_cast<double>(m_scale[a_neuron]); }
+    double GetScale(unsigned int a_neuron) const { return m_scale[a_neuron]; }
+};
+
+typedef BasicQuantizedNetwork<int8_t> QuantizedNetwork8;
+typedef BasicQuantizedNetwork<int16_t> QuantizedNetwork16;
+
+} // namespace NEAT
+
+#endif
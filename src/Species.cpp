@@ -46,12 +46,12 @@ namespace NEAT
     RNG global_rng;
     
     // Sorts the members of this species by fitness
-    bool fitness_greater(Genome *ls, Genome *rs)
+    bool fitness_greater(const Genome *ls, const Genome *rs)
     {
         return ((ls->GetFitness()) > (rs->GetFitness()));
     }
     
-    bool genome_greater(Genome ls, Genome rs)
+    bool genome_greater(const Genome &ls, const Genome &rs)
     {
         return (ls.GetFitness() > rs.GetFitness());
     }
@@ -118,34 +118,35 @@ namespace NEAT
 
 
     // returns an individual randomly selected from the best N%
-    Genome Species::GetIndividual(Parameters &a_Parameters, RNG &a_RNG) const
+    const Genome &Species::GetIndividual(Parameters &a_Parameters, RNG &a_RNG) const
     {
         ASSERT(m_Individuals.size() > 0);
 
         // Make a pool of only evaluated individuals!
-        std::vector<Genome> t_Evaluated;
+        std::vector<const Genome *> t_Evaluated;
+        t_Evaluated.reserve(m_Individuals.size());
         for (const Genome & m_Individual : m_Individuals)
         {
             if (m_Individual.IsEvaluated())
-                t_Evaluated.push_back(m_Individual);
+                t_Evaluated.push_back(&m_Individual);
         }
 
         ASSERT(t_Evaluated.size() > 0);
 
         if (t_Evaluated.size() == 1)
         {
-            return (t_Evaluated[0]);
+            return *(t_Evaluated[0]);
         }
         else if (t_Evaluated.size() == 2)
         {
-            return (t_Evaluated[Rounded(a_RNG.RandFloat())]);
+            return *(t_Evaluated[Rounded(a_RNG.RandFloat())]);
         }
 
         // Warning!!!! The individuals must be sorted by best fitness for this to work
         int t_chosen_one = 0;
         
         // then sort them here just to make sure
-        std::sort(t_Evaluated.begin(), t_Evaluated.end(), genome_greater);
+        std::sort(t_Evaluated.begin(), t_Evaluated.end(), fitness_greater);
 
         // Here might be introduced better selection scheme, but this works OK for now
         //TODO create tournament selection here
@@ -181,17 +182,17 @@ namespace NEAT
             std::vector<double> t_probs;
             for (unsigned int i = 0; i < t_Evaluated.size(); i++)
             {
-                t_probs.push_back(t_Evaluated[i].GetFitness());
+                t_probs.push_back(t_Evaluated[i]->GetFitness());
             }
             t_chosen_one = a_RNG.Roulette(t_probs);
         }
 
-        return (t_Evaluated[t_chosen_one]);
+        return *(t_Evaluated[t_chosen_one]);
     }
 
 
     // returns a completely random individual
-    Genome Species::GetRandomIndividual(RNG &a_RNG) const
+    const Genome &Species::GetRandomIndividual(RNG &a_RNG) const
     {
         if (BOOST_UNLIKELY(m_Individuals.empty())) // no members yet, return representative
         {
@@ -201,7 +202,7 @@ namespace NEAT
         }
         else if (m_Individuals.size() == 1)
         {
-            return m_Individuals[1];
+            return m_Individuals[0];
         }
         else
         {
@@ -212,7 +213,7 @@ namespace NEAT
     }
 
     // returns the leader (the member having the best fitness)
-    Genome Species::GetLeader() const
+    const Genome &Species::GetLeader() const
     {
         // Don't store the leader any more
         // Perform a search over the members and return the most fit member
@@ -241,7 +242,7 @@ namespace NEAT
     }
 
 
-    Genome Species::GetRepresentative() const
+    const Genome &Species::GetRepresentative() const
     {
         if (BOOST_UNLIKELY(m_Individuals.empty()))
         {
@@ -401,14 +402,14 @@ namespace NEAT
                         // else we can mate
                     else
                     {
-                        Genome t_mom = GetIndividual(a_Parameters, a_RNG);
+                        const Genome &t_mom = GetIndividual(a_Parameters, a_RNG);
 
                         // choose whether to mate at all
                         // Do not allow crossover when in simplifying phase
                         if ((a_RNG.RandFloat() < a_Parameters.CrossoverRate) && (a_Pop.GetSearchMode() != SIMPLIFYING))
                         {
                             // get the father
-                            Genome t_dad;
+                            const Genome *t_dad;
                             bool t_interspecies = false;
 
                             // There is a probability that the father may come from another species
@@ -417,31 +418,31 @@ namespace NEAT
                             {
                                 // Find different species (random one) // !!!!!!!!!!!!!!!!!
                                 int t_diffspec = a_RNG.RandInt(0, static_cast<int>(a_Pop.m_Species.size() - 1));
-                                t_dad = a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
                                 t_interspecies = true;
                             }
                             else
                             {
                                 // Mate within species
-                                t_dad = GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &GetIndividual(a_Parameters, a_RNG);
 
                                 // The other parent should be a different one
                                 // number of tries to find different parent
                                 int t_tries = 1024;
                                 if (!a_Parameters.AllowClones)
                                 {
-                                    while (((t_mom.GetID() == t_dad.GetID()) ||
-                                            (t_mom.CompatibilityDistance(t_dad, a_Parameters) < COMPAT_EQUALITY_DELTA)) &&
+                                    while (((t_mom.GetID() == t_dad->GetID()) ||
+                                            (t_mom.CompatibilityDistance(*t_dad, a_Parameters) < COMPAT_EQUALITY_DELTA)) &&
                                            (t_tries--))
                                     {
-                                        t_dad = GetIndividual(a_Parameters, a_RNG);
+                                        t_dad = &GetIndividual(a_Parameters, a_RNG);
                                     }
                                 }
                                 else
                                 {
-                                    while (((t_mom.GetID() == t_dad.GetID())) && (t_tries--))
+                                    while (((t_mom.GetID() == t_dad->GetID())) && (t_tries--))
                                     {
-                                        t_dad = GetIndividual(a_Parameters, a_RNG);
+                                        t_dad = &GetIndividual(a_Parameters, a_RNG);
                                     }
                                 }
                                 t_interspecies = false;
@@ -451,11 +452,11 @@ namespace NEAT
                             // Choose randomly one of two types of crossover
                             if (a_RNG.RandFloat() < a_Parameters.MultipointCrossoverRate)
                             {
-                                t_baby = t_mom.Mate(t_dad, false, t_interspecies, a_RNG, a_Parameters);
+                                t_baby = t_mom.Mate(*t_dad, false, t_interspecies, a_RNG, a_Parameters);
                             }
                             else
                             {
-                                t_baby = t_mom.Mate(t_dad, true, t_interspecies, a_RNG, a_Parameters);
+                                t_baby = t_mom.Mate(*t_dad, true, t_interspecies, a_RNG, a_Parameters);
                             }
 
                             t_mated = true;
@@ -560,12 +561,12 @@ namespace NEAT
             {
                 // try to find a compatible species
 
-                Genome t_to_compare = t_cur_species->GetRepresentative();
+                const Genome *t_to_compare = &t_cur_species->GetRepresentative();
 
                 t_found = false;
                 while ((t_cur_species != a_Pop.m_TempSpecies.end()) && (!t_found))
                 {
-                    if (t_baby.IsCompatibleWith(t_to_compare, a_Parameters))
+                    if (t_baby.IsCompatibleWith(*t_to_compare, a_Parameters))
                     {
                         // found a compatible species
                         t_cur_species->AddIndividual(t_baby);
@@ -577,7 +578,7 @@ namespace NEAT
                         t_cur_species++;
                         if (t_cur_species != a_Pop.m_TempSpecies.end())
                         {
-                            t_to_compare = t_cur_species->GetRepresentative();
+                            t_to_compare = &t_cur_species->GetRepresentative();
                         }
                     }
                 }
@@ -645,14 +646,14 @@ namespace NEAT
                 // else we can mate
             else
             {
-                Genome t_mom = GetIndividual(a_Parameters, a_RNG);
+                const Genome &t_mom = GetIndividual(a_Parameters, a_RNG);
             
                 // choose whether to mate at all
                 // Do not allow crossover when in simplifying phase
                 if ((a_RNG.RandFloat() < a_Parameters.CrossoverRate) && (a_Pop.GetSearchMode() != SIMPLIFYING))
                 {
                     // get the father
-                    Genome t_dad;
+                    const Genome *t_dad;
                     bool t_interspecies = false;
                 
                     // There is a probability that the father may come from another species
@@ -661,31 +662,31 @@ namespace NEAT
                     {
                         // Find different species (random one) // !!!!!!!!!!!!!!!!!
                         int t_diffspec = a_RNG.RandInt(0, static_cast<int>(a_Pop.m_Species.size() - 1));
-                        t_dad = a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
+                        t_dad = &a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
                         t_interspecies = true;
                     }
                     else
                     {
                         // Mate within species
-                        t_dad = GetIndividual(a_Parameters, a_RNG);
+                        t_dad = &GetIndividual(a_Parameters, a_RNG);
                     
                         // The other parent should be a different one
                         // number of tries to find different parent
                         int t_tries = 1024;
                         if (!a_Parameters.AllowClones)
                         {
-                            while (((t_mom.GetID() == t_dad.GetID()) ||
-                                    (t_mom.CompatibilityDistance(t_dad, a_Parameters) < COMPAT_EQUALITY_DELTA)) &&
+                            while (((t_mom.GetID() == t_dad->GetID()) ||
+                                    (t_mom.CompatibilityDistance(*t_dad, a_Parameters) < COMPAT_EQUALITY_DELTA)) &&
                                    (t_tries--))
                             {
-                                t_dad = GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &GetIndividual(a_Parameters, a_RNG);
                             }
                         }
                         else
                         {
-                            while (((t_mom.GetID() == t_dad.GetID())) && (t_tries--))
+                            while (((t_mom.GetID() == t_dad->GetID())) && (t_tries--))
                             {
-                                t_dad = GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &GetIndividual(a_Parameters, a_RNG);
                             }
                         }
                         t_interspecies = false;
@@ -695,11 +696,11 @@ namespace NEAT
                     // Choose randomly one of two types of crossover
                     if (a_RNG.RandFloat() < a_Parameters.MultipointCrossoverRate)
                     {
-                        t_baby = t_mom.Mate(t_dad, false, t_interspecies, a_RNG, a_Parameters);
+                        t_baby = t_mom.Mate(*t_dad, false, t_interspecies, a_RNG, a_Parameters);
                     }
                     else
                     {
-                        t_baby = t_mom.Mate(t_dad, true, t_interspecies, a_RNG, a_Parameters);
+                        t_baby = t_mom.Mate(*t_dad, true, t_interspecies, a_RNG, a_Parameters);
                     }
                 
                     t_mated = true;
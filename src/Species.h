@@ -159,23 +159,27 @@ public:
     int EvalsNoImprovement() { return m_EvalsNoImprovement; }
     int AgeGens() { return m_AgeGenerations; }
     int AgeEvals() { return m_AgeEvaluations; }
-    Genome GetIndividualByIdx(int a_idx) const { return (m_Individuals[a_idx]); }
+    const Genome &GetIndividualByIdx(int a_idx) const { return (m_Individuals[a_idx]); }
     bool IsBestSpecies() const { return m_BestSpecies; }
     bool IsWorstSpecies() const { return m_WorstSpecies; }
 
+    // The accessors below return references to members of m_Individuals. They stay
+    // valid only until the individuals change (AddIndividual(), sorting, reproduction,
+    // speciation), copy the genome to keep it longer. The Python bindings return copies.
+
     // returns the leader (the member having the best fitness, representing the species)
-    Genome GetLeader() const;
+    const Genome &GetLeader() const;
 
-    Genome GetRepresentative() const;
+    const Genome &GetRepresentative() const;
 
     // adds a new member to the species and updates variables
     void AddIndividual(const Genome &a_New);
 
     // returns an individual randomly selected from the best N%
-    Genome GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const;
+    const Genome &GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const;
 
     // returns a completely random individual
-    Genome GetRandomIndividual(RNG& a_RNG) const;
+    const Genome &GetRandomIndividual(RNG& a_RNG) const;
 
     // calculates how many babies this species will spawn in total
     void CountOffspring();
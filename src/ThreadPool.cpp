@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ThreadPool.cpp
+// Description: Implementation of the worker thread pool.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+
+namespace NEAT
+{
+
+ThreadPool::ThreadPool(unsigned int a_Threads)
+{
+    m_job = NULL;
+    m_count = m_next = m_busy = 0;
+    m_generation = 0;
+    m_stop = false;
+
+    for (unsigned int i = 1; i < a_Threads; i++)
+    {
+        m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, m_generation));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> t_lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (unsigned int i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+}
+
+void ThreadPool::Work(std::unique_lock<std::mutex> &a_Lock)
+{
+    while (m_next < m_count)
+    {
+        unsigned int t_task = m_next++;
+        const std::function<void(unsigned int)> &t_job = *m_job;
+
+        a_Lock.unlock();
+        t_job(t_task);
+        a_Lock.lock();
+    }
+}
+
+void ThreadPool::WorkerLoop(unsigned long a_Generation)
+{
+    std::unique_lock<std::mutex> t_lock(m_mutex);
+    // a job may have been posted before this thread got here, so start from
+    // the generation the pool had when the thread was created
+    unsigned long t_seen = a_Generation;
+
+    for (;;)
+    {
+        m_wake.wait(t_lock, [&] { return m_stop || (m_generation != t_seen); });
+        if (m_stop)
+        {
+            return;
+        }
+        t_seen = m_generation;
+
+        Work(t_lock);
+
+        if (--m_busy == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Run(unsigned int a_Count, const std::function<void(unsigned int)> &a_Task)
+{
+    std::lock_guard<std::mutex> t_run_lock(m_run_mutex);
+
+    if (m_workers.empty() || (a_Count < 2))
+    {
+        for (unsigned int i = 0; i < a_Count; i++)
+        {
+            a_Task(i);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> t_lock(m_mutex);
+    m_job = &a_Task;
+    m_count = a_Count;
+    m_next = 0;
+    m_busy = static_cast<unsigned int>(m_workers.size());
+    m_generation++;
+    m_wake.notify_all();
+
+    Work(t_lock);
+
+    // every worker has to leave the job before a_Task goes out of scope
+    m_done.wait(t_lock, [&] { return m_busy == 0; });
+    m_job = NULL;
+}
+
+} // namespace NEAT
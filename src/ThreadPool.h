@@ -0,0 +1,89 @@
+#ifndef _THREADPOOL_H
+#define _THREADPOOL_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        ThreadPool.h
+// Description: A small pool of worker threads for data-parallel loops.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace NEAT
+{
+
+//-----------------------------------------------------------------------
+// A fixed set of worker threads that run the tasks 0 .. a_Count-1 of one
+// Run() call at a time. The calling thread works on the tasks as well, so a
+// pool of N threads starts N-1 workers. The workers sleep between calls.
+//
+// Run() may be called from several threads, the calls are serialized.
+class ThreadPool
+{
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_run_mutex; // one Run() at a time
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+
+    // the current job, guarded by m_mutex
+    const std::function<void(unsigned int)> *m_job;
+    unsigned int m_count;      // tasks of the current job
+    unsigned int m_next;       // next task to hand out
+    unsigned int m_busy;       // workers still inside the current job
+    unsigned long m_generation; // incremented for every job
+    bool m_stop;
+
+    // a_Generation is m_generation at the time the worker was started
+    void WorkerLoop(unsigned long a_Generation);
+
+    // runs tasks of the current job until there are none left, m_mutex is held on entry and exit
+    void Work(std::unique_lock<std::mutex> &a_Lock);
+
+    // no copies
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+public:
+
+    explicit ThreadPool(unsigned int a_Threads);
+    ~ThreadPool();
+
+    // Calls a_Task(i) for every i < a_Count, spread over the threads,
+    // and returns once all of them have finished.
+    void Run(unsigned int a_Count, const std::function<void(unsigned int)> &a_Task);
+
+    unsigned int NumThreads() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+};
+
+} // namespace NEAT
+
+#endif
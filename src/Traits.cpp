@@ -2,5 +2,97 @@
 // Created by peter on 28.04.17.
 //
 
+#include <mutex>
+#include <algorithm>
 #include "Traits.h"
 
+namespace NEAT
+{
+    int TraitLayout::Slot(const std::string &a_Name) const
+    {
+        std::vector<std::string>::const_iterator t_it = std::lower_bound(m_Names.begin(), m_Names.end(), a_Name);
+        if ((t_it == m_Names.end()) || (*t_it != a_Name))
+        {
+            return -1;
+        }
+        return static_cast<int>(t_it - m_Names.begin());
+    }
+
+    bool TraitLayout::Matches(const std::map<std::string, TraitParameters> &a_Params) const
+    {
+        if (a_Params.size() != size())
+        {
+            return false;
+        }
+
+        unsigned int i = 0;
+        for (auto it = a_Params.begin(); it != a_Params.end(); it++, i++)
+        {
+            if ((it->first != m_Names[i]) || (it->second.dep_key != m_DepKeys[i]) ||
+                !(it->second.dep_values == m_DepValues[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::shared_ptr<const TraitLayout> TraitLayout::Of(const std::map<std::string, TraitParameters> &a_Params)
+    {
+        static const std::shared_ptr<const TraitLayout> s_empty = std::make_shared<TraitLayout>();
+        if (a_Params.empty())
+        {
+            return s_empty;
+        }
+
+        // never destroyed, the dependency values may be Python objects
+        static std::mutex *s_mutex = new std::mutex();
+        static std::vector< std::shared_ptr<const TraitLayout> > *s_layouts =
+                new std::vector< std::shared_ptr<const TraitLayout> >();
+
+        std::lock_guard<std::mutex> t_lock(*s_mutex);
+        for (unsigned int i = 0; i < s_layouts->size(); i++)
+        {
+            if ((*s_layouts)[i]->Matches(a_Params))
+            {
+                return (*s_layouts)[i];
+            }
+        }
+
+        std::shared_ptr<TraitLayout> t_layout = std::make_shared<TraitLayout>();
+        for (auto it = a_Params.begin(); it != a_Params.end(); it++)
+        {
+            t_layout->m_Names.push_back(it->first);
+            t_layout->m_DepKeys.push_back(it->second.dep_key);
+            t_layout->m_DepValues.push_back(it->second.dep_values);
+        }
+        for (unsigned int i = 0; i < t_layout->size(); i++)
+        {
+            int t_dep = -1;
+            if (!t_layout->m_DepKeys[i].empty())
+            {
+                t_dep = t_layout->Slot(t_layout->m_DepKeys[i]);
+                if (t_dep < 0)
+                {
+                    t_dep = -2;
+                }
+            }
+            t_layout->m_DepSlots.push_back(t_dep);
+        }
+
+        s_layouts->push_back(t_layout);
+        return t_layout;
+    }
+
+    const TraitLayout &TraitLayoutCache::Get(const std::map<std::string, TraitParameters> &a_Params) const
+    {
+        const TraitLayout *t_layout = m_Layout.load();
+        if ((t_layout == NULL) || !t_layout->Matches(a_Params))
+        {
+            // interned layouts live on, so a plain pointer to them stays valid
+            t_layout = TraitLayout::Of(a_Params).get();
+            m_Layout.store(t_layout);
+        }
+        return *t_layout;
+    }
+}
@@ -7,6 +7,9 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
 #include <boost/any.hpp>
 #include <boost/variant.hpp>
 #include <cmath>
@@ -152,5 +155,98 @@ namespace NEAT
         std::vector<TraitType> dep_values; // and has this value
     };
 
+    // The names and dependencies of the traits made from one set of trait parameters.
+    // They are interned, all genes whose traits come from the same parameters share
+    // one layout, and the genes only store the values. A trait's slot is its position
+    // in the parameters' map, so the slots are in name order. Interned layouts are
+    // never freed.
+    class TraitLayout : public std::enable_shared_from_this<TraitLayout>
+    {
+    public:
+        std::vector<std::string> m_Names;
+        std::vector<std::string> m_DepKeys; // empty if the trait has no dependency
+        std::vector<int> m_DepSlots; // slot of the dependency, -1 if none, -2 if there is no such trait
+        std::vector< std::vector<TraitType> > m_DepValues;
+
+        unsigned int size() const { return static_cast<unsigned int>(m_Names.size()); }
+
+        // The slot of a trait by name, -1 if there is no such trait
+        int Slot(const std::string &a_Name) const;
+
+        // True if this is the layout of a_Params
+        bool Matches(const std::map<std::string, TraitParameters> &a_Params) const;
+
+        // The interned layout of a_Params. Thread-safe.
+        static std::shared_ptr<const TraitLayout> Of(const std::map<std::string, TraitParameters> &a_Params);
+    };
+
+    // Remembers the interned layout of a set of trait parameters, so it is not
+    // looked up again for every gene. The layout is reused as long as it still
+    // matches the parameters, which may be edited in place at any time.
+    // Copies start out with the same layout. Thread-safe.
+    class TraitLayoutCache
+    {
+        mutable std::atomic<const TraitLayout *> m_Layout;
+
+    public:
+        TraitLayoutCache() : m_Layout(NULL) {}
+        TraitLayoutCache(const TraitLayoutCache &a_Other) : m_Layout(a_Other.m_Layout.load()) {}
+
+        TraitLayoutCache &operator=(const TraitLayoutCache &a_Other)
+        {
+            m_Layout.store(a_Other.m_Layout.load());
+            return *this;
+        }
+
+        // The layout of a_Params, interned on the first call or when they have changed
+        const TraitLayout &Get(const std::map<std::string, TraitParameters> &a_Params) const;
+    };
+
+    // The trait values of a gene, one per slot of the layout
+    class GeneTraits
+    {
+    public:
+        std::shared_ptr<const TraitLayout> m_Layout; // NULL until the traits are initialized
+        std::vector<TraitType> m_Values;
+
+        unsigned int size() const { return static_cast<unsigned int>(m_Values.size()); }
+
+        const std::string &Name(unsigned int a_Slot) const { return m_Layout->m_Names[a_Slot]; }
+
+        int Slot(const std::string &a_Name) const { return m_Layout ? m_Layout->Slot(a_Name) : -1; }
+
+        // The value of a trait by name, NULL if there is no such trait.
+        // For the Python side and printing, the evolution works on slots.
+        const TraitType *Find(const std::string &a_Name) const
+        {
+            int t_slot = Slot(a_Name);
+            return (t_slot < 0) ? NULL : &m_Values[t_slot];
+        }
+
+        // True if the trait in a_Slot is switched on by its dependency (or has none)
+        bool Enabled(unsigned int a_Slot) const
+        {
+            int t_dep = m_Layout->m_DepSlots[a_Slot];
+            if (t_dep == -1)
+            {
+                return true;
+            }
+            if (t_dep < 0)
+            {
+                return false;
+            }
+
+            const std::vector<TraitType> &t_values = m_Layout->m_DepValues[a_Slot];
+            for (unsigned int i = 0; i < t_values.size(); i++)
+            {
+                if (m_Values[t_dep] == t_values[i])
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
 }
 #endif //MULTINEAT_TRAITS_H
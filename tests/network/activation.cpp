@@ -0,0 +1,148 @@
+//
+// Checks the span activation kernels against the scalar activation functions
+// on every instruction set this CPU supports.
+//
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <ActivationKernels.h>
+#include <Activation.h>
+#include <Random.h>
+
+#define BOOST_TEST_MODULE Activation kernels test
+#include <boost/test/included/unit_test.hpp>
+
+using namespace NEAT;
+
+const double FAST_BOUND = 1e-12;
+
+struct Sample
+{
+    std::vector<double> x, a, b;
+};
+
+// Arguments spread over several orders of magnitude, |a*x + b| < 1e4
+Sample random_sample(RNG &rng, unsigned int count)
+{
+    Sample s;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        double t_scale = std::pow(10.0, rng.RandInt(-3, 3));
+        s.x.push_back(rng.RandFloatSigned() * t_scale);
+        s.a.push_back(0.1 + rng.RandFloat() * 5.0);
+        s.b.push_back(rng.RandFloatSigned());
+    }
+    return s;
+}
+
+std::vector<ActivationKernel> supported_kernels()
+{
+    std::vector<ActivationKernel> k;
+    for (int i = KERNEL_SCALAR; i <= BestActivationKernel(); i++)
+    {
+        k.push_back(static_cast<ActivationKernel>(i));
+    }
+    return k;
+}
+
+BOOST_AUTO_TEST_CASE(exact_spans_match_scalar_functions)
+{
+    RNG rng;
+    rng.Seed(10);
+    Sample s = random_sample(rng, 1003);
+
+    for (ActivationKernel k : supported_kernels())
+    {
+        SetActivationKernel(k);
+        for (int t = SIGNED_SIGMOID; t <= SOFTPLUS; t++)
+        {
+            ActivationFunction f = static_cast<ActivationFunction>(t);
+            std::vector<double> y(s.x.size()), yu(s.x.size());
+            ActivateSpan(f, s.x.data(), s.a.data(), s.b.data(), y.data(), s.x.size());
+            ActivateSpan(f, s.x.data(), s.a[0], s.b[0], yu.data(), s.x.size());
+
+            for (unsigned int i = 0; i < s.x.size(); i++)
+            {
+                BOOST_TEST(y[i] == Activation(f, s.x[i], s.a[i], s.b[i]));
+                BOOST_TEST(yu[i] == Activation(f, s.x[i], s.a[0], s.b[0]));
+            }
+        }
+    }
+    SetActivationKernel(BestActivationKernel());
+}
+
+BOOST_AUTO_TEST_CASE(fast_spans_within_documented_bound)
+{
+    RNG rng;
+    rng.Seed(11);
+    Sample s = random_sample(rng, 20001);
+
+    for (ActivationKernel k : supported_kernels())
+    {
+        SetActivationKernel(k);
+        for (int t = SIGNED_SIGMOID; t <= SOFTPLUS; t++)
+        {
+            ActivationFunction f = static_cast<ActivationFunction>(t);
+            std::vector<double> y(s.x.size());
+            ActivateSpan(f, s.x.data(), s.a.data(), s.b.data(), y.data(), s.x.size(), ACTIVATION_FAST);
+
+            // absolute error, relative for values larger than 1
+            double t_max_error = 0;
+            for (unsigned int i = 0; i < s.x.size(); i++)
+            {
+                double t_exact = Activation(f, s.x[i], s.a[i], s.b[i]);
+                double t_error = std::fabs(y[i] - t_exact) / std::max(1.0, std::fabs(t_exact));
+                t_max_error = std::max(t_max_error, t_error);
+            }
+
+            BOOST_TEST_MESSAGE("kernel " << k << " function " << t << " max error " << t_max_error);
+            BOOST_TEST(t_max_error <= FAST_BOUND);
+        }
+    }
+    SetActivationKernel(BestActivationKernel());
+}
+
+BOOST_AUTO_TEST_CASE(float_spans_close_to_double)
+{
+    RNG rng;
+    rng.Seed(12);
+
+    // |a*x + b| < 10
+    std::vector<float> x, a, b;
+    for (unsigned int i = 0; i < 5001; i++)
+    {
+        x.push_back(rng.RandFloatSigned() * 1.5);
+        a.push_back(0.1 + rng.RandFloat() * 5.0);
+        b.push_back(rng.RandFloatSigned());
+    }
+
+    for (ActivationKernel k : supported_kernels())
+    {
+        SetActivationKernel(k);
+        for (int t = SIGNED_SIGMOID; t <= SOFTPLUS; t++)
+        {
+            ActivationFunction f = static_cast<ActivationFunction>(t);
+            std::vector<float> exact(x.size()), fast(x.size());
+            ActivateSpan(f, x.data(), a.data(), b.data(), exact.data(), x.size());
+            ActivateSpan(f, x.data(), a.data(), b.data(), fast.data(), x.size(), ACTIVATION_FAST);
+
+            double t_max_error = 0;
+            for (unsigned int i = 0; i < x.size(); i++)
+            {
+                double t_ref = Activation(f, x[i], a[i], b[i]);
+                BOOST_TEST(exact[i] == static_cast<float>(t_ref));
+                if ((f == SIGNED_STEP) || (f == UNSIGNED_STEP))
+                {
+                    continue; // the threshold is compared in float
+                }
+                double t_error = std::fabs(fast[i] - t_ref) / std::max(1.0, std::fabs(t_ref));
+                t_max_error = std::max(t_max_error, t_error);
+            }
+
+            BOOST_TEST_MESSAGE("float kernel " << k << " function " << t << " max error " << t_max_error);
+            BOOST_TEST(t_max_error <= 1e-6);
+        }
+    }
+    SetActivationKernel(BestActivationKernel());
+}
@@ -0,0 +1,50 @@
+//
+// Writes the networks of emit_networks.h as C++ source, for emitted.cpp.
+//
+
+#include <fstream>
+#include <iostream>
+#include "emit_networks.h"
+
+using namespace NEAT;
+
+bool emit(std::ostream &out, const NeuralNetwork &net, const char *name, SequenceMode mode, bool use_float)
+{
+    EmitOptions options;
+    options.m_function_name = name;
+    options.m_mode = mode;
+    options.m_float = use_float;
+    if (!net.EmitCpp(out, options))
+    {
+        std::cerr << "can't emit " << name << std::endl;
+        return false;
+    }
+    out << "\n";
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " output.cpp" << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(argv[1]);
+    NeuralNetwork feed_forward = emit_test_network(1, true);
+    NeuralNetwork recurrent = emit_test_network(2, false);
+
+    // a network with loops can't be written as one sweep
+    EmitOptions options;
+    if (recurrent.EmitCpp(std::cerr, options))
+    {
+        return 1;
+    }
+
+    bool ok = emit(out, feed_forward, "emitted_feed_forward", SEQUENCE_FEED_FORWARD, false) &&
+              emit(out, feed_forward, "emitted_feed_forward_float", SEQUENCE_FEED_FORWARD, true) &&
+              emit(out, recurrent, "emitted_step", SEQUENCE_ACTIVATE, false) &&
+              emit(out, recurrent, "emitted_bias_step", SEQUENCE_USE_INTERNAL_BIAS, false);
+    return ok ? 0 : 1;
+}
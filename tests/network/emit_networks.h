@@ -0,0 +1,65 @@
+//
+// The networks written out by emit_network and checked by emitted.cpp.
+// Both build them from the same seeds, so they get the same networks.
+//
+
+#ifndef EMIT_NETWORKS_H
+#define EMIT_NETWORKS_H
+
+#include <NeuralNetwork.h>
+#include <Random.h>
+
+const unsigned int EMIT_INPUTS = 5;
+const unsigned int EMIT_OUTPUTS = 3;
+const unsigned int EMIT_HIDDEN = 30;
+
+// All activation functions, with loops unless a_FeedForward is set
+inline NEAT::NeuralNetwork emit_test_network(int a_Seed, bool a_FeedForward)
+{
+    using namespace NEAT;
+
+    RNG rng;
+    rng.Seed(a_Seed);
+
+    NeuralNetwork net;
+    net.SetInputOutputDimentions(EMIT_INPUTS, EMIT_OUTPUTS);
+
+    const unsigned int n = EMIT_INPUTS + EMIT_OUTPUTS + EMIT_HIDDEN;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        Neuron neuron = Neuron();
+        neuron.m_type = (i < EMIT_INPUTS) ? INPUT : ((i < EMIT_INPUTS + EMIT_OUTPUTS) ? OUTPUT : HIDDEN);
+        neuron.m_activation_function_type = static_cast<ActivationFunction>(i % (SOFTPLUS + 1));
+        neuron.m_a = 0.5 + rng.RandFloat() * 2.5;
+        neuron.m_b = rng.RandFloatSigned();
+        neuron.m_bias = rng.RandFloatSigned();
+        neuron.m_timeconst = 0.5;
+        neuron.m_split_y = 0;
+        net.AddNeuron(neuron);
+    }
+
+    for (unsigned int i = 0; i < 5 * n; i++)
+    {
+        Connection c = Connection();
+        if (a_FeedForward)
+        {
+            c.m_source_neuron_idx = rng.RandInt(0, n - 2);
+            c.m_target_neuron_idx = rng.RandInt(std::max(c.m_source_neuron_idx + 1, static_cast<int>(EMIT_INPUTS)), n - 1);
+        }
+        else
+        {
+            c.m_source_neuron_idx = rng.RandInt(0, n - 1);
+            c.m_target_neuron_idx = rng.RandInt(0, n - 1);
+        }
+        c.m_weight = rng.RandFloatSigned() * 2.0;
+        c.m_recur_flag = false;
+        c.m_hebb_rate = 0;
+        c.m_hebb_pre_rate = 0;
+        net.AddConnection(c);
+    }
+
+    net.Flush();
+    return net;
+}
+
+#endif
@@ -0,0 +1,88 @@
+//
+// Checks the C++ source written by NeuralNetwork::EmitCpp() (compiled in from
+// the output of emit_network) against the networks it was written from.
+//
+
+#include <cmath>
+#include <vector>
+#include "emit_networks.h"
+
+#define BOOST_TEST_MODULE Emitted network test
+#include <boost/test/included/unit_test.hpp>
+
+using namespace NEAT;
+
+void emitted_feed_forward(const double *inputs, double *outputs);
+void emitted_feed_forward_float(const float *inputs, float *outputs);
+void emitted_step(const double *inputs, double *state, double *outputs);
+void emitted_bias_step(const double *inputs, double *state, double *outputs);
+
+std::vector<double> random_inputs(RNG &rng)
+{
+    std::vector<double> in(EMIT_INPUTS);
+    for (auto &x : in)
+    {
+        x = rng.RandFloatSigned();
+    }
+    return in;
+}
+
+BOOST_AUTO_TEST_CASE(emitted_feed_forward_matches_network)
+{
+    NeuralNetwork net = emit_test_network(1, true);
+    NeuralNetwork net_float = net;
+    net_float.SetPrecision(PRECISION_FLOAT);
+
+    RNG rng;
+    rng.Seed(3);
+    for (int s = 0; s < 100; s++)
+    {
+        std::vector<double> in = random_inputs(rng);
+        std::vector<float> in_float(in.begin(), in.end());
+        double out[EMIT_OUTPUTS];
+        float out_float[EMIT_OUTPUTS];
+        emitted_feed_forward(in.data(), out);
+        emitted_feed_forward_float(in_float.data(), out_float);
+
+        net.Input(in);
+        net.ActivateFeedForward();
+        net_float.Input(in);
+        net_float.ActivateFeedForward();
+        std::vector<double> expected = net.Output(), expected_float = net_float.Output();
+
+        for (unsigned int i = 0; i < EMIT_OUTPUTS; i++)
+        {
+            BOOST_TEST(std::abs(out[i] - expected[i]) < 1e-9);
+            BOOST_TEST(std::abs(out_float[i] - expected_float[i]) < 1e-3);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(emitted_steps_match_network)
+{
+    NeuralNetwork net = emit_test_network(2, false);
+    NeuralNetwork net_bias = net;
+    std::vector<double> state(net.m_neurons.size(), 0.0), state_bias(net.m_neurons.size(), 0.0);
+
+    RNG rng;
+    rng.Seed(4);
+    for (int s = 0; s < 50; s++)
+    {
+        std::vector<double> in = random_inputs(rng);
+        double out[EMIT_OUTPUTS], out_bias[EMIT_OUTPUTS];
+        emitted_step(in.data(), state.data(), out);
+        emitted_bias_step(in.data(), state_bias.data(), out_bias);
+
+        net.Input(in);
+        net.Activate();
+        net_bias.Input(in);
+        net_bias.ActivateUseInternalBias();
+        std::vector<double> expected = net.Output(), expected_bias = net_bias.Output();
+
+        for (unsigned int i = 0; i < EMIT_OUTPUTS; i++)
+        {
+            BOOST_TEST(std::abs(out[i] - expected[i]) < 1e-9);
+            BOOST_TEST(std::abs(out_bias[i] - expected_bias[i]) < 1e-9);
+        }
+    }
+}
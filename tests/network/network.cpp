@@ -0,0 +1,1962 @@
+//
+// Checks the compiled evaluation plan of NeuralNetwork against a plain
+// implementation of the original per-connection activation.
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <NeuralNetwork.h>
+#include <InferenceNetwork.h>
+#include <Genome.h>
+#include <Innovation.h>
+#include <Parameters.h>
+#include <PhenotypePool.h>
+#include <QuantizedNetwork.h>
+#include <Substrate.h>
+#include <ThreadPool.h>
+#include <Activation.h>
+#include <Random.h>
+#include <Species.h>
+
+#define BOOST_TEST_MODULE Network test
+#include <boost/test/included/unit_test.hpp>
+
+using namespace NEAT;
+
+// Counts the allocations while g_count_allocations is set. The whole
+// family of replaceable operators is routed through the two functions below
+// so every allocation is released by its matching deallocation function.
+// They are kept out of line, otherwise GCC sees free() applied to the
+// result of operator new at the inlined call sites and warns.
+#if defined(__GNUC__)
+#define TEST_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define TEST_NOINLINE __declspec(noinline)
+#else
+#define TEST_NOINLINE
+#endif
+
+bool g_count_allocations = false;
+unsigned int g_allocations = 0;
+
+TEST_NOINLINE void *counted_alloc(size_t size) noexcept
+{
+    if (g_count_allocations)
+    {
+        g_allocations++;
+    }
+    return malloc(size ? size : 1);
+}
+
+TEST_NOINLINE void counted_free(void *p) noexcept
+{
+    free(p);
+}
+
+void *operator new(size_t size)
+{
+    void *p = counted_alloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    counted_free(p);
+}
+
+// Builds a random network with recurrent links, self loops and all activation functions
+NeuralNetwork random_network(RNG &rng, unsigned int inputs, unsigned int outputs, unsigned int hidden,
+                             unsigned int connections)
+{
+    NeuralNetwork net;
+    net.SetInputOutputDimentions(inputs, outputs);
+
+    for (unsigned int i = 0; i < inputs + outputs + hidden; i++)
+    {
+        Neuron n = Neuron();
+        n.m_type = (i < inputs) ? INPUT : ((i < inputs + outputs) ? OUTPUT : HIDDEN);
+        n.m_activation_function_type = static_cast<ActivationFunction>(rng.RandInt(0, SOFTPLUS));
+        n.m_a = 0.5 + rng.RandFloat() * 4.5;
+        n.m_b = rng.RandFloatSigned();
+        n.m_bias = rng.RandFloatSigned();
+        n.m_timeconst = 0.1 + rng.RandFloat();
+        n.m_split_y = 0;
+        net.AddNeuron(n);
+    }
+
+    for (unsigned int i = 0; i < connections; i++)
+    {
+        Connection c = Connection();
+        c.m_source_neuron_idx = rng.RandInt(0, inputs + outputs + hidden - 1);
+        c.m_target_neuron_idx = rng.RandInt(0, inputs + outputs + hidden - 1);
+        c.m_weight = rng.RandFloatSigned() * 3.0;
+        c.m_recur_flag = false;
+        c.m_hebb_rate = 0.3;
+        c.m_hebb_pre_rate = 0.1;
+        net.AddConnection(c);
+    }
+
+    net.Flush();
+    return net;
+}
+
+// The original two-pass activation over the Connection and Neuron structs
+void reference_activate(std::vector<Neuron> &neurons, std::vector<Connection> &connections,
+                        unsigned int inputs, bool use_bias)
+{
+    for (auto &c : connections)
+    {
+        c.m_signal = neurons[c.m_source_neuron_idx].m_activation * c.m_weight;
+    }
+    for (auto &c : connections)
+    {
+        neurons[c.m_target_neuron_idx].m_activesum += c.m_signal;
+    }
+    for (unsigned int i = inputs; i < neurons.size(); i++)
+    {
+        double x = neurons[i].m_activesum + (use_bias ? neurons[i].m_bias : 0.0);
+        neurons[i].m_activesum = 0;
+        neurons[i].m_activation = Activation(neurons[i].m_activation_function_type, x,
+                                             neurons[i].m_a, neurons[i].m_b);
+    }
+}
+
+// Like random_network(), but every connection goes from a lower to a higher index
+NeuralNetwork random_feed_forward_network(RNG &rng, unsigned int inputs, unsigned int outputs, unsigned int hidden,
+                                          unsigned int connections)
+{
+    NeuralNetwork net = random_network(rng, inputs, outputs, hidden, 0);
+    unsigned int n = inputs + outputs + hidden;
+
+    for (unsigned int i = 0; i < connections; i++)
+    {
+        Connection c = Connection();
+        c.m_source_neuron_idx = rng.RandInt(0, n - 2);
+        c.m_target_neuron_idx = rng.RandInt(std::max(c.m_source_neuron_idx + 1, static_cast<int>(inputs)), n - 1);
+        c.m_weight = rng.RandFloatSigned() * 3.0;
+        c.m_recur_flag = false;
+        net.AddConnection(c);
+    }
+
+    net.Flush();
+    return net;
+}
+
+std::vector<double> random_inputs(RNG &rng, unsigned int inputs)
+{
+    std::vector<double> in(inputs);
+    for (auto &x : in)
+    {
+        x = rng.RandFloatSigned();
+    }
+    return in;
+}
+
+BOOST_AUTO_TEST_CASE(compiled_activate_matches_reference)
+{
+    RNG rng;
+    rng.Seed(1);
+
+    for (int trial = 0; trial < 20; trial++)
+    {
+        NeuralNetwork net = random_network(rng, 4, 3, 30, 200);
+        std::vector<Neuron> neurons = net.m_neurons;
+        std::vector<Connection> connections = net.m_connections;
+
+        for (int step = 0; step < 10; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 4);
+            bool use_bias = (step % 2) == 1;
+
+            net.Input(in);
+            for (unsigned int i = 0; i < in.size(); i++)
+            {
+                neurons[i].m_activation = in[i];
+            }
+
+            if (use_bias)
+            {
+                net.ActivateUseInternalBias();
+            }
+            else
+            {
+                net.Activate();
+            }
+            reference_activate(neurons, connections, 4, use_bias);
+
+            std::vector<double> out = net.Output();
+            for (unsigned int i = 0; i < out.size(); i++)
+            {
+                BOOST_TEST(out[i] == neurons[4 + i].m_activation);
+            }
+        }
+
+        // the state written back into the neurons is the same too
+        net.WriteBack();
+        for (unsigned int i = 0; i < neurons.size(); i++)
+        {
+            BOOST_TEST(net.m_neurons[i].m_activation == neurons[i].m_activation);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compile_picks_up_in_place_edits)
+{
+    RNG rng;
+    rng.Seed(2);
+
+    NeuralNetwork net = random_network(rng, 2, 1, 5, 20);
+    net.Input(random_inputs(rng, 2));
+    net.Activate();
+
+    for (auto &c : net.m_connections)
+    {
+        c.m_weight = 0;
+    }
+    net.Compile();
+    net.Activate();
+
+    Neuron out = net.GetNeuronByIndex(2);
+    BOOST_TEST(net.Output()[0] == Activation(out.m_activation_function_type, 0.0, out.m_a, out.m_b));
+}
+
+BOOST_AUTO_TEST_CASE(invalidate_picks_up_in_place_edits)
+{
+    RNG rng;
+    rng.Seed(2);
+
+    NeuralNetwork net = random_network(rng, 2, 1, 5, 20);
+    net.Input(random_inputs(rng, 2));
+    net.Activate();
+
+    // running the network is not a change
+    const unsigned long long generation = net.GetGeneration();
+    net.Activate();
+    net.WriteBack();
+    BOOST_TEST(net.GetGeneration() == generation);
+
+    for (auto &c : net.m_connections)
+    {
+        c.m_weight = 0;
+    }
+    net.Invalidate();
+    BOOST_TEST(net.GetGeneration() != generation);
+    net.Activate();
+
+    Neuron out = net.GetNeuronByIndex(2);
+    BOOST_TEST(net.Output()[0] == Activation(out.m_activation_function_type, 0.0, out.m_a, out.m_b));
+
+    net.m_neurons[2].m_activation_function_type = LINEAR;
+    net.m_neurons[2].m_a = 1;
+    net.m_neurons[2].m_b = 0;
+    const unsigned long long edited = net.GetGeneration();
+    net.UpdateParameters();
+    BOOST_TEST(net.GetGeneration() != edited);
+    net.Activate();
+    BOOST_TEST(net.Output()[0] == 0.0);
+
+    const unsigned long long updated = net.GetGeneration();
+    net.AddNeuron(Neuron());
+    BOOST_TEST(net.GetGeneration() != updated);
+}
+
+BOOST_AUTO_TEST_CASE(batch_matches_independent_networks)
+{
+    RNG rng;
+    rng.Seed(3);
+
+    const unsigned int batch = 7;
+    NeuralNetwork net = random_network(rng, 3, 2, 20, 120);
+    std::vector<NeuralNetwork> singles(batch, net);
+
+    std::vector<double> in(batch * 3), out(batch * 2);
+    for (int step = 0; step < 5; step++)
+    {
+        for (auto &x : in)
+        {
+            x = rng.RandFloatSigned();
+        }
+        net.ActivateBatch(in.data(), batch, out.data());
+
+        for (unsigned int b = 0; b < batch; b++)
+        {
+            singles[b].Input(std::vector<double>(in.begin() + b * 3, in.begin() + b * 3 + 3));
+            singles[b].Activate();
+            std::vector<double> expected = singles[b].Output();
+            BOOST_TEST(out[b * 2] == expected[0]);
+            BOOST_TEST(out[b * 2 + 1] == expected[1]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(plan_keeps_public_indices)
+{
+    RNG rng;
+    rng.Seed(4);
+
+    NeuralNetwork net = random_network(rng, 3, 2, 40, 150);
+    CompiledNetwork plan;
+    plan.Build(net.m_neurons, net.m_connections, 3, 2);
+
+    // at most one bucket per activation function in use on every level
+    std::vector<int> used(SOFTPLUS + 1, 0);
+    for (unsigned int i = 3; i < net.m_neurons.size(); i++)
+    {
+        used[net.m_neurons[i].m_activation_function_type] = 1;
+    }
+    unsigned int types = std::count(used.begin(), used.end(), 1);
+    BOOST_TEST(plan.NumBuckets() >= types);
+    BOOST_TEST(plan.NumBuckets() <= types * plan.NumLevels());
+
+    for (unsigned int i = 0; i < net.m_connections.size(); i++)
+    {
+        const Connection &c = net.m_connections[i];
+        unsigned int slot = plan.ConnectionSlot(i);
+        if (static_cast<unsigned int>(c.m_target_neuron_idx) < 3)
+        {
+            BOOST_TEST(slot == CompiledNetwork::NO_SLOT);
+            continue;
+        }
+        BOOST_TEST(plan.Source(slot) == static_cast<unsigned int>(c.m_source_neuron_idx));
+        BOOST_TEST(slot >= plan.RowStart(c.m_target_neuron_idx));
+        BOOST_TEST(slot < plan.RowEnd(c.m_target_neuron_idx));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(feed_forward_matches_relaxed_activate)
+{
+    RNG rng;
+    rng.Seed(5);
+
+    for (int trial = 0; trial < 20; trial++)
+    {
+        NeuralNetwork net = random_feed_forward_network(rng, 4, 2, 30, 150);
+        NeuralNetwork relaxed = net;
+        BOOST_TEST(net.IsFeedForward());
+
+        std::vector<double> in = random_inputs(rng, 4);
+        net.Input(in);
+        net.ActivateFeedForward();
+
+        relaxed.Input(in);
+        for (unsigned int i = 0; i <= relaxed.m_neurons.size(); i++)
+        {
+            relaxed.Activate();
+        }
+
+        std::vector<double> out = net.Output(), expected = relaxed.Output();
+        BOOST_TEST(out[0] == expected[0]);
+        BOOST_TEST(out[1] == expected[1]);
+    }
+
+    NeuralNetwork recurrent = random_network(rng, 4, 2, 30, 150);
+    BOOST_TEST(!recurrent.IsFeedForward());
+}
+
+BOOST_AUTO_TEST_CASE(float_precision_within_tolerance)
+{
+    RNG rng;
+    rng.Seed(6);
+
+    for (int trial = 0; trial < 20; trial++)
+    {
+        NeuralNetwork net = random_feed_forward_network(rng, 4, 3, 40, 200);
+
+        // the step functions would amplify rounding differences into jumps
+        for (auto &n : net.m_neurons)
+        {
+            if ((n.m_activation_function_type == SIGNED_STEP) || (n.m_activation_function_type == UNSIGNED_STEP))
+            {
+                n.m_activation_function_type = TANH;
+            }
+        }
+        net.Compile();
+
+        NeuralNetwork single = net;
+        single.SetPrecision(PRECISION_FLOAT);
+        BOOST_TEST(single.GetPrecision() == PRECISION_FLOAT);
+
+        for (int step = 0; step < 3; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 4);
+            net.Input(in);
+            single.Input(in);
+            if (step == 0)
+            {
+                net.ActivateFeedForward();
+                single.ActivateFeedForward();
+            }
+            else
+            {
+                net.ActivateUseInternalBias();
+                single.ActivateUseInternalBias();
+            }
+
+            std::vector<double> out = net.Output(), out_float = single.Output();
+            for (unsigned int i = 0; i < out.size(); i++)
+            {
+                BOOST_TEST(std::fabs(out[i] - out_float[i]) <= 1e-4 * std::max(1.0, std::fabs(out[i])));
+            }
+        }
+
+        // the state written back into the neurons is the same as the output
+        std::vector<double> out_float = single.Output();
+        single.WriteBack();
+        for (unsigned int i = 0; i < out_float.size(); i++)
+        {
+            BOOST_TEST(single.m_neurons[4 + i].m_activation == out_float[i]);
+        }
+    }
+}
+
+// The original dense RTRL over a sensitivity cube [k][i][j], generalized to several outputs
+int reference_connection(const std::vector<Connection> &connections, int to, int from)
+{
+    for (unsigned int i = 0; i < connections.size(); i++)
+    {
+        if ((connections[i].m_source_neuron_idx == from) && (connections[i].m_target_neuron_idx == to))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void reference_rtrl_gradients(const std::vector<Neuron> &neurons, const std::vector<Connection> &connections,
+                              unsigned int inputs, std::vector<std::vector<std::vector<double> > > &cube)
+{
+    unsigned int n = neurons.size();
+    for (unsigned int k = inputs; k < n; k++)
+    {
+        double derivative = 0;
+        if (neurons[k].m_activation_function_type == UNSIGNED_SIGMOID)
+        {
+            derivative = neurons[k].m_activation * (1 - neurons[k].m_activation);
+        }
+        else if (neurons[k].m_activation_function_type == TANH)
+        {
+            derivative = 1 - neurons[k].m_activation * neurons[k].m_activation;
+        }
+
+        for (unsigned int i = inputs; i < n; i++)
+        {
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (reference_connection(connections, i, j) == -1)
+                {
+                    cube[k][i][j] = 0;
+                    continue;
+                }
+
+                double sum = 0;
+                for (unsigned int l = 0; l < n; l++)
+                {
+                    int idx = reference_connection(connections, k, l);
+                    if (idx != -1)
+                    {
+                        sum += connections[idx].m_weight * cube[l][i][j];
+                    }
+                }
+                if (i == k)
+                {
+                    sum += neurons[j].m_activation;
+                }
+                cube[k][i][j] = derivative * sum;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sparse_rtrl_matches_dense_reference)
+{
+    RNG rng;
+    rng.Seed(7);
+
+    for (int trial = 0; trial < 5; trial++)
+    {
+        NeuralNetwork net = random_network(rng, 3, 2, 8, 40);
+        for (unsigned int i = 3; i < net.m_neurons.size(); i++)
+        {
+            net.m_neurons[i].m_activation_function_type = (i % 3 == 0) ? TANH : UNSIGNED_SIGMOID;
+        }
+        net.Compile();
+        net.InitRTRLMatrix();
+
+        unsigned int n = net.m_neurons.size();
+        std::vector<Connection> connections = net.m_connections;
+        std::vector<std::vector<std::vector<double> > > cube(n, std::vector<std::vector<double> >(n, std::vector<double>(n, 0.0)));
+
+        for (int step = 0; step < 10; step++)
+        {
+            net.Input(random_inputs(rng, 3));
+            net.Activate();
+            net.RTRL_update_gradients();
+            reference_rtrl_gradients(net.m_neurons, connections, 3, cube);
+
+            // single target on odd steps, both outputs otherwise
+            std::vector<double> targets(1, rng.RandFloat());
+            if (step % 2 == 0)
+            {
+                targets.push_back(rng.RandFloat());
+            }
+            std::vector<double> out = net.Output();
+            if (targets.size() == 1)
+            {
+                net.RTRL_update_error(targets[0]);
+            }
+            else
+            {
+                net.RTRL_update_error(targets);
+            }
+            net.RTRL_update_weights();
+
+            std::vector<double> change(connections.size(), 0.0);
+            for (unsigned int o = 0; o < targets.size(); o++)
+            {
+                double error = targets[o] - out[o];
+                for (unsigned int i = 0; i < n; i++)
+                {
+                    for (unsigned int j = 0; j < n; j++)
+                    {
+                        int idx = reference_connection(connections, i, j);
+                        if (idx != -1)
+                        {
+                            change[idx] += error * cube[3 + o][i][j] * 0.0001;
+                        }
+                    }
+                }
+            }
+
+            for (unsigned int i = 0; i < connections.size(); i++)
+            {
+                connections[i].m_weight += change[i];
+                BOOST_CHECK_CLOSE(net.m_connections[i].m_weight, connections[i].m_weight, 1e-9);
+            }
+        }
+    }
+}
+
+// A seed genome grown by a few structural and parameter mutations
+Genome random_genome(RNG &rng, InnovationDatabase &innov, const Parameters &params, unsigned int inputs,
+                     unsigned int outputs, int mutations)
+{
+    Genome g(0, inputs, 0, outputs, false, UNSIGNED_SIGMOID, UNSIGNED_SIGMOID, 0, params, 0);
+    innov.Init(g);
+    for (int i = 0; i < mutations; i++)
+    {
+        g.Mutate_AddNeuron(innov, params, rng);
+        g.Mutate_AddLink(innov, params, rng);
+        g.Mutate_NeuronActivation_Type(params, rng);
+        g.Mutate_NeuronActivations_A(params, rng);
+        g.Mutate_LinkWeights(params, rng);
+    }
+    return g;
+}
+
+BOOST_AUTO_TEST_CASE(inference_network_matches_neural_network)
+{
+    RNG rng;
+    rng.Seed(8);
+    Parameters params;
+    params.RecurrentProb = 0.5;
+    params.ActivationFunction_Tanh_Prob = 1.0;
+    params.ActivationFunction_SignedSine_Prob = 1.0;
+    params.ActivationFunction_Linear_Prob = 1.0;
+
+    InferenceNetwork lean;
+    for (int trial = 0; trial < 10; trial++)
+    {
+        InnovationDatabase innov;
+        Genome g = random_genome(rng, innov, params, 4, 2, 20);
+
+        NeuralNetwork net;
+        g.BuildPhenotype(net);
+        g.BuildPhenotype(lean); // reuses the block of the previous trial when it is large enough
+        BOOST_CHECK_EQUAL(lean.NumNeurons(), net.m_neurons.size());
+
+        InferenceNetwork copy;
+        for (int step = 0; step < 10; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 4);
+            net.Input(in);
+            lean.Input(in);
+            if (step % 3 == 0)
+            {
+                net.Activate();
+                lean.Activate();
+            }
+            else if (step % 3 == 1)
+            {
+                net.ActivateUseInternalBias();
+                lean.ActivateUseInternalBias();
+            }
+            else
+            {
+                net.ActivateFast();
+                lean.ActivateFast();
+            }
+
+            if (step == 5)
+            {
+                copy = lean;
+            }
+
+            std::vector<double> expected = net.Output();
+            std::vector<double> actual = lean.Output();
+            BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+            for (unsigned int i = 0; i < expected.size(); i++)
+            {
+                BOOST_CHECK_EQUAL(actual[i], expected[i]);
+            }
+        }
+
+        // the copy carries the state at the time it was made
+        BOOST_CHECK_EQUAL(copy.NumConnections(), lean.NumConnections());
+        copy.Flush();
+        lean.Flush();
+        copy.Activate();
+        lean.Activate();
+        BOOST_CHECK(copy.Output() == lean.Output());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(phenotype_pool_rebuilds_without_allocating)
+{
+    RNG rng;
+    rng.Seed(9);
+    Parameters params;
+    params.RecurrentProb = 0.5;
+
+    InnovationDatabase innov;
+    Genome big = random_genome(rng, innov, params, 4, 2, 20);
+    Genome small = random_genome(rng, innov, params, 4, 2, 5);
+    std::vector<double> in = random_inputs(rng, 4);
+
+    PhenotypePool pool;
+    InferencePhenotypePool lean_pool;
+
+    // warm up with the larger phenotype
+    NeuralNetwork *net = pool.Build(big);
+    InferenceNetwork *lean = lean_pool.Build(big);
+    net->Input(in);
+    net->Activate();
+    pool.Release(net);
+    lean_pool.Release(lean);
+    BOOST_CHECK_EQUAL(pool.Misses(), 1u);
+    BOOST_CHECK_EQUAL(pool.Hits(), 0u);
+
+    // a genome indexes its genes on the first lookup, once
+    small.GetNeuronIndex(small.m_NeuronGenes[0].ID());
+
+    // every rebuild changes the structure, so none of them is a patch
+    BOOST_CHECK(small.StructureSignature() != big.StructureSignature());
+    for (int i = 0; i < 4; i++)
+    {
+        const Genome &g = (i % 2) ? big : small;
+
+        g_allocations = 0;
+        g_count_allocations = true;
+        net = pool.Build(g);
+        net->Input(in);
+        net->Activate();
+        lean = lean_pool.Build(g);
+        lean->Input(in);
+        lean->Activate();
+        pool.Release(net);
+        lean_pool.Release(lean);
+        g_count_allocations = false;
+
+        BOOST_CHECK_EQUAL(g_allocations, 0u);
+    }
+
+    BOOST_CHECK_EQUAL(pool.Hits(), 4u);
+    BOOST_CHECK_EQUAL(pool.Misses(), 1u);
+    BOOST_CHECK_EQUAL(lean_pool.Hits(), 4u);
+
+    // two networks alive at the same time
+    NeuralNetwork *a = pool.Build(small);
+    NeuralNetwork *b = pool.Build(small);
+    BOOST_CHECK(a != b);
+    BOOST_CHECK_EQUAL(pool.NumNetworks(), 2u);
+    pool.ReleaseAll();
+    BOOST_CHECK_EQUAL(pool.NumAvailable(), 2u);
+    pool.Shrink();
+    BOOST_CHECK_EQUAL(pool.NumNetworks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(weight_only_rebuild_patches_in_place)
+{
+    RNG rng;
+    rng.Seed(10);
+    Parameters params;
+    params.RecurrentProb = 0.5;
+    params.ActivationFunction_Tanh_Prob = 1.0;
+    params.ActivationFunction_SignedSine_Prob = 1.0;
+
+    InnovationDatabase innov;
+    Genome parent = random_genome(rng, innov, params, 4, 2, 10);
+
+    NeuralNetwork net;
+    InferenceNetwork lean;
+    net.SetPrecision((rng.RandFloat() < 0.5) ? PRECISION_FLOAT : PRECISION_DOUBLE);
+
+    for (int trial = 0; trial < 10; trial++)
+    {
+        parent.BuildPhenotype(net);
+        parent.BuildPhenotype(lean);
+        net.Input(random_inputs(rng, 4));
+        net.Activate(); // compiles the plan and leaves some state behind
+
+        Genome child = parent;
+        BOOST_CHECK_EQUAL(child.StructureSignature(), parent.StructureSignature());
+        child.Mutate_LinkWeights(params, rng);
+        child.Mutate_NeuronActivations_A(params, rng);
+        child.Mutate_NeuronBiases(params, rng);
+        if (trial % 2)
+        {
+            child.Mutate_NeuronActivation_Type(params, rng);
+        }
+        if (trial % 3 == 2)
+        {
+            child.Mutate_AddLink(innov, params, rng);
+        }
+        bool same_structure = (child.StructureSignature() == parent.StructureSignature());
+        BOOST_CHECK_EQUAL(same_structure, trial % 3 != 2);
+
+        // patched (or rebuilt) against built from scratch
+        child.BuildPhenotype(net);
+        child.BuildPhenotype(lean);
+        NeuralNetwork fresh;
+        fresh.SetPrecision(net.GetPrecision());
+        child.BuildPhenotype(fresh);
+        InferenceNetwork fresh_lean;
+        child.BuildPhenotype(fresh_lean);
+
+        for (int step = 0; step < 5; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 4);
+            net.Input(in);
+            fresh.Input(in);
+            lean.Input(in);
+            fresh_lean.Input(in);
+            net.ActivateUseInternalBias();
+            fresh.ActivateUseInternalBias();
+            lean.ActivateUseInternalBias();
+            fresh_lean.ActivateUseInternalBias();
+            BOOST_CHECK(net.Output() == fresh.Output());
+            BOOST_CHECK(lean.Output() == fresh_lean.Output());
+        }
+
+        parent = child;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalidated_network_is_rebuilt_in_full)
+{
+    RNG rng;
+    rng.Seed(10);
+    Parameters params;
+
+    InnovationDatabase innov;
+    Genome genome = random_genome(rng, innov, params, 4, 2, 10);
+
+    NeuralNetwork net;
+    genome.BuildPhenotype(net);
+    BOOST_CHECK_EQUAL(net.GetStructureSignature(), genome.StructureSignature());
+
+    // another topology of the same size replaces the connections
+    for (auto &c : net.m_connections)
+    {
+        std::swap(c.m_source_neuron_idx, c.m_target_neuron_idx);
+    }
+    net.Invalidate();
+    BOOST_CHECK_EQUAL(net.GetStructureSignature(), 0u);
+
+    genome.BuildPhenotype(net);
+    NeuralNetwork fresh;
+    genome.BuildPhenotype(fresh);
+    for (unsigned int i = 0; i < net.m_connections.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(net.m_connections[i].m_source_neuron_idx, fresh.m_connections[i].m_source_neuron_idx);
+        BOOST_CHECK_EQUAL(net.m_connections[i].m_target_neuron_idx, fresh.m_connections[i].m_target_neuron_idx);
+    }
+
+    // edited without Invalidate(): the patch checks the connections and
+    // rewrites the neuron data that is not compiled
+    for (auto &c : net.m_connections)
+    {
+        std::swap(c.m_source_neuron_idx, c.m_target_neuron_idx);
+    }
+    for (auto &n : net.m_neurons)
+    {
+        n.m_split_y = -1;
+    }
+    BOOST_CHECK_EQUAL(net.GetStructureSignature(), genome.StructureSignature());
+    genome.BuildPhenotype(net);
+    for (unsigned int i = 0; i < net.m_connections.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(net.m_connections[i].m_source_neuron_idx, fresh.m_connections[i].m_source_neuron_idx);
+        BOOST_CHECK_EQUAL(net.m_connections[i].m_target_neuron_idx, fresh.m_connections[i].m_target_neuron_idx);
+    }
+    for (unsigned int i = 0; i < net.m_neurons.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(net.m_neurons[i].m_split_y, fresh.m_neurons[i].m_split_y);
+    }
+
+    for (auto &n : net.m_neurons)
+    {
+        n.m_split_y = -1;
+    }
+    genome.BuildPhenotype(net);
+    for (unsigned int i = 0; i < net.m_neurons.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(net.m_neurons[i].m_split_y, fresh.m_neurons[i].m_split_y);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_activation_matches_serial)
+{
+    RNG rng;
+    rng.Seed(11);
+
+    for (int trial = 0; trial < 4; trial++)
+    {
+        NeuralNetwork serial = (trial % 2) ? random_network(rng, 8, 4, 300, 20000)
+                                           : random_feed_forward_network(rng, 8, 4, 300, 20000);
+        if (trial >= 2)
+        {
+            serial.SetPrecision(PRECISION_FLOAT);
+        }
+        NeuralNetwork parallel = serial;
+        parallel.SetParallelActivation(4, 0);
+        BOOST_CHECK_EQUAL(parallel.GetParallelThreads(), 4u);
+
+        for (int step = 0; step < 10; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 8);
+            serial.Input(in);
+            parallel.Input(in);
+            if (trial % 2)
+            {
+                serial.ActivateLeaky(0.05);
+                parallel.ActivateLeaky(0.05);
+            }
+            else
+            {
+                serial.ActivateFeedForward();
+                parallel.ActivateFeedForward();
+            }
+            BOOST_CHECK(serial.Output() == parallel.Output());
+        }
+    }
+
+    // below the threshold it stays serial
+    NeuralNetwork net = random_network(rng, 2, 1, 5, 20);
+    net.SetParallelActivation(2, 1000);
+    net.Input(random_inputs(rng, 2));
+    net.Activate();
+    net.SetParallelActivation(0);
+    BOOST_CHECK_EQUAL(net.GetParallelThreads(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_runs_right_after_construction)
+{
+    // the workers may not have started yet when the first job is posted
+    for (int trial = 0; trial < 50; trial++)
+    {
+        ThreadPool pool(4);
+        std::vector<std::atomic<int> > hits(16);
+        for (unsigned int i = 0; i < hits.size(); i++)
+        {
+            hits[i] = 0;
+        }
+
+        pool.Run(4, [&](unsigned int i) { hits[i]++; });
+        pool.Run(static_cast<unsigned int>(hits.size()), [&](unsigned int i) { hits[i]++; });
+
+        for (unsigned int i = 0; i < hits.size(); i++)
+        {
+            BOOST_CHECK_EQUAL(hits[i].load(), (i < 4) ? 2 : 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dense_layers_match_reference)
+{
+    RNG rng;
+    rng.Seed(12);
+    Parameters params;
+    InnovationDatabase innov;
+    Genome cppn = random_genome(rng, innov, params, 5, 1, 10);
+
+    // a 6x6 input grid, a 5x5 hidden grid and 4 outputs, adjacent layers fully connected
+    std::vector< std::vector<double> > inputs, hidden, outputs;
+    for (int y = 0; y < 6; y++)
+    {
+        for (int x = 0; x < 6; x++)
+        {
+            inputs.push_back({x / 5.0 * 2 - 1, y / 5.0 * 2 - 1});
+        }
+    }
+    for (int y = 0; y < 5; y++)
+    {
+        for (int x = 0; x < 5; x++)
+        {
+            hidden.push_back({x / 4.0 * 2 - 1, y / 4.0 * 2 - 1});
+        }
+    }
+    for (int x = 0; x < 4; x++)
+    {
+        outputs.push_back({x / 3.0 * 2 - 1, 1.0});
+    }
+    Substrate subst(inputs, hidden, outputs);
+    subst.m_query_weights_only = true;
+    subst.m_hidden_nodes_activation = TANH;
+
+    for (int precision = 0; precision < 2; precision++)
+    {
+        NeuralNetwork net;
+        net.SetPrecision(precision ? PRECISION_FLOAT : PRECISION_DOUBLE);
+        cppn.BuildHyperNEATPhenotype(net, subst);
+        BOOST_CHECK_EQUAL(net.NumDenseBlocks(), 2u);
+
+        // the substrate neurons are built without a state, start both from a flushed one
+        net.Flush();
+        std::vector<Neuron> neurons = net.m_neurons;
+        std::vector<Connection> connections = net.m_connections;
+        for (int step = 0; step < 5; step++)
+        {
+            std::vector<double> in = random_inputs(rng, 36);
+            net.Input(in);
+            for (unsigned int i = 0; i < in.size(); i++)
+            {
+                neurons[i].m_activation = in[i];
+            }
+            net.Activate();
+            reference_activate(neurons, connections, 36, false);
+
+            std::vector<double> out = net.Output();
+            for (unsigned int i = 0; i < out.size(); i++)
+            {
+                if (precision)
+                {
+                    BOOST_TEST(std::fabs(out[i] - neurons[36 + i].m_activation) <= 1e-3);
+                }
+                else
+                {
+                    BOOST_TEST(out[i] == neurons[36 + i].m_activation);
+                }
+            }
+        }
+    }
+
+    // a layer that misses one connection is not dense
+    NeuralNetwork net;
+    cppn.BuildHyperNEATPhenotype(net, subst);
+    for (unsigned int i = 0; i < net.m_connections.size(); i++)
+    {
+        if (net.m_connections[i].m_target_neuron_idx == 36)
+        {
+            net.m_connections.erase(net.m_connections.begin() + i);
+            break;
+        }
+    }
+    net.Invalidate();
+    BOOST_CHECK_EQUAL(net.NumDenseBlocks(), 1u);
+
+    // a sparse network has no dense blocks
+    NeuralNetwork sparse = random_network(rng, 4, 3, 30, 200);
+    BOOST_CHECK_EQUAL(sparse.NumDenseBlocks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(large_sparse_network_matches_reference)
+{
+    RNG rng;
+    rng.Seed(13);
+
+    // large enough to be reordered for locality
+    NeuralNetwork net = random_network(rng, 16, 4, 6000, 60000);
+    std::vector<Neuron> neurons = net.m_neurons;
+    std::vector<Connection> connections = net.m_connections;
+
+    for (int step = 0; step < 5; step++)
+    {
+        std::vector<double> in = random_inputs(rng, 16);
+        net.Input(in);
+        for (unsigned int i = 0; i < in.size(); i++)
+        {
+            neurons[i].m_activation = in[i];
+        }
+        net.Activate();
+        reference_activate(neurons, connections, 16, false);
+
+        std::vector<double> out = net.Output();
+        for (unsigned int i = 0; i < out.size(); i++)
+        {
+            BOOST_TEST(out[i] == neurons[16 + i].m_activation);
+        }
+    }
+
+    net.WriteBack();
+    for (unsigned int i = 0; i < neurons.size(); i++)
+    {
+        BOOST_TEST(net.m_neurons[i].m_activation == neurons[i].m_activation);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(activate_until_stable_settles)
+{
+    RNG rng;
+    rng.Seed(14);
+
+    for (int trial = 0; trial < 10; trial++)
+    {
+        // tanh neurons and small weights, so the loops settle
+        NeuralNetwork net = random_network(rng, 4, 2, 20, 80);
+        for (auto &n : net.m_neurons)
+        {
+            n.m_activation_function_type = TANH;
+            n.m_a = 1.0;
+        }
+        for (auto &c : net.m_connections)
+        {
+            c.m_weight *= 0.05;
+        }
+        net.Compile();
+        BOOST_CHECK(!net.IsFeedForward());
+
+        std::vector<double> in = random_inputs(rng, 4);
+        net.Input(in);
+        int steps = net.ActivateUntilStable(1e-9, 200);
+        BOOST_CHECK(steps > 1);
+        BOOST_CHECK(steps < 200);
+        BOOST_CHECK_EQUAL(net.GetStableIterations(), static_cast<unsigned int>(steps));
+
+        // one more step changes nothing within the tolerance
+        std::vector<double> out = net.Output();
+        net.Activate();
+        std::vector<double> again = net.Output();
+        for (unsigned int i = 0; i < out.size(); i++)
+        {
+            BOOST_TEST(std::fabs(out[i] - again[i]) < 1e-9);
+        }
+
+        // the same relaxation from a flushed state, starting at the estimate
+        net.Flush();
+        net.Input(in);
+        int second = net.ActivateUntilStable(1e-9, 200);
+        BOOST_CHECK_EQUAL(second, steps);
+        BOOST_CHECK(net.Output() == out);
+
+        // already settled, so a fast call follows the slow one: it may skip the
+        // check for half the estimate, and the estimate halves every time
+        unsigned int estimate = net.GetStableIterations();
+        for (int call = 0; call < 10; call++)
+        {
+            int fast = net.ActivateUntilStable(1e-9, 200);
+            BOOST_CHECK(static_cast<unsigned int>(fast) <= estimate / 2 + 1);
+            estimate = net.GetStableIterations();
+        }
+        BOOST_CHECK(estimate <= 2u);
+    }
+
+    // a feed-forward network takes a single step
+    NeuralNetwork ff = random_feed_forward_network(rng, 4, 2, 20, 80);
+    ff.Input(random_inputs(rng, 4));
+    BOOST_CHECK_EQUAL(ff.ActivateUntilStable(), 1);
+
+    // the limit is respected
+    NeuralNetwork wild = random_network(rng, 4, 2, 20, 80);
+    wild.Input(random_inputs(rng, 4));
+    BOOST_CHECK(wild.ActivateUntilStable(0.0, 7) == 7);
+}
+
+BOOST_AUTO_TEST_CASE(run_sequence_matches_step_by_step)
+{
+    RNG rng;
+    rng.Seed(15);
+    Parameters params;
+
+    const SequenceMode modes[] = {SEQUENCE_ACTIVATE, SEQUENCE_FAST, SEQUENCE_USE_INTERNAL_BIAS,
+                                  SEQUENCE_LEAKY, SEQUENCE_FEED_FORWARD};
+    for (int trial = 0; trial < 10; trial++)
+    {
+        const SequenceMode mode = modes[trial % 5];
+        const bool adapt = trial >= 5;
+        const size_t steps = 50;
+
+        NeuralNetwork net = random_network(rng, 3, 2, 15, 60);
+        NeuralNetwork stepped = net;
+
+        std::vector<double> inputs(steps * 3);
+        for (auto &x : inputs)
+        {
+            x = rng.RandFloatSigned();
+        }
+        std::vector<double> outputs(steps * 2);
+        net.RunSequence(inputs.data(), steps, outputs.data(), mode, 0.05, adapt ? &params : NULL);
+
+        for (size_t t = 0; t < steps; t++)
+        {
+            stepped.Input(std::vector<double>(inputs.begin() + t * 3, inputs.begin() + t * 3 + 3));
+            switch (mode)
+            {
+            case SEQUENCE_FAST: stepped.ActivateFast(); break;
+            case SEQUENCE_USE_INTERNAL_BIAS: stepped.ActivateUseInternalBias(); break;
+            case SEQUENCE_LEAKY: stepped.ActivateLeaky(0.05); break;
+            case SEQUENCE_FEED_FORWARD: stepped.ActivateFeedForward(); break;
+            default: stepped.Activate(); break;
+            }
+            std::vector<double> out = stepped.Output();
+            BOOST_TEST(out[0] == outputs[t * 2]);
+            BOOST_TEST(out[1] == outputs[t * 2 + 1]);
+            if (adapt)
+            {
+                stepped.Adapt(params);
+            }
+        }
+    }
+}
+
+// The original Hebbian rule over the Connection and Neuron structs
+void reference_adapt(const std::vector<Neuron> &neurons, std::vector<Connection> &connections, double max_weight)
+{
+    double t_max_weight = -999999999;
+    for (auto &c : connections)
+    {
+        t_max_weight = std::max(t_max_weight, std::fabs(c.m_weight));
+    }
+
+    for (auto &c : connections)
+    {
+        double x = neurons[c.m_source_neuron_idx].m_activation;
+        double y = neurons[c.m_target_neuron_idx].m_activation;
+        if (c.m_weight > 0)
+        {
+            double t_delta = (c.m_hebb_rate * (t_max_weight - c.m_weight) * x * y)
+                             + c.m_hebb_pre_rate * t_max_weight * x * (y - 1.0);
+            c.m_weight = (c.m_weight + t_delta);
+        }
+        else if (c.m_weight < 0)
+        {
+            double t_delta = c.m_hebb_pre_rate * (t_max_weight - c.m_weight) * x * (1.0 - y)
+                             - c.m_hebb_rate * t_max_weight * x * y;
+            c.m_weight = -(c.m_weight + t_delta);
+        }
+        c.m_weight = std::min(std::max(c.m_weight, -max_weight), max_weight);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(adapt_matches_reference)
+{
+    RNG rng;
+    rng.Seed(16);
+    Parameters params;
+    params.MaxWeight = 2.0;
+
+    for (int trial = 0; trial < 10; trial++)
+    {
+        // the random targets include inputs, which the plan has no slots for
+        NeuralNetwork net = random_network(rng, 4, 3, 30, 200);
+        for (auto &n : net.m_neurons)
+        {
+            n.m_activation_function_type = UNSIGNED_SIGMOID;
+        }
+        for (auto &c : net.m_connections)
+        {
+            c.m_hebb_rate = rng.RandFloat();
+            c.m_hebb_pre_rate = rng.RandFloat();
+        }
+        net.Compile();
+        std::vector<Connection> connections = net.m_connections;
+
+        for (int step = 0; step < 10; step++)
+        {
+            net.Input(random_inputs(rng, 4));
+            net.Activate();
+            net.WriteBack();
+            reference_adapt(net.m_neurons, connections, params.MaxWeight);
+            net.Adapt(params);
+
+            for (unsigned int i = 0; i < connections.size(); i++)
+            {
+                BOOST_TEST(net.m_connections[i].m_weight == connections[i].m_weight);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(quantized_network_close_to_double)
+{
+    RNG rng;
+    rng.Seed(17);
+
+    const ActivationFunction types[] = {SIGNED_SIGMOID, UNSIGNED_SIGMOID, TANH, SIGNED_GAUSS,
+                                        SIGNED_SINE, RELU, SOFTPLUS, LINEAR, ABS};
+    NeuralNetwork net = random_feed_forward_network(rng, 8, 3, 40, 300);
+    for (unsigned int i = 8; i < net.m_neurons.size(); i++)
+    {
+        net.m_neurons[i].m_activation_function_type = types[i % 9];
+        net.m_neurons[i].m_a = 1.0;
+    }
+    net.Compile();
+
+    std::vector< std::vector<double> > calibration, samples;
+    for (int s = 0; s < 200; s++)
+    {
+        calibration.push_back(random_inputs(rng, 8));
+        samples.push_back(random_inputs(rng, 8));
+    }
+
+    // some room for the test samples going beyond the calibrated ranges
+    QuantizedNetwork16 q16;
+    q16.Build(net, calibration, 1.5);
+    BOOST_CHECK_EQUAL(q16.NumNeurons(), net.m_neurons.size());
+    QuantizationReport r16 = q16.MeasureAccuracy(net, samples);
+    BOOST_CHECK_EQUAL(r16.m_samples, 200u);
+    BOOST_TEST(r16.m_max_error < 0.01);
+
+    QuantizedNetwork8 q8;
+    q8.Build(net, calibration, 1.5);
+    QuantizationReport r8 = q8.MeasureAccuracy(net, samples);
+    BOOST_TEST(r8.m_mean_error < 0.05);
+    BOOST_TEST(r8.m_mean_error > r16.m_mean_error);
+    BOOST_TEST(q8.MemoryUsage() < q16.MemoryUsage());
+}
+
+BOOST_AUTO_TEST_CASE(optimize_keeps_outputs)
+{
+    RNG rng;
+    rng.Seed(18);
+
+    unsigned int dead = 0, constant = 0, folded = 0;
+    for (int trial = 0; trial < 20; trial++)
+    {
+        const bool use_bias = (trial % 2) == 1;
+
+        // sparse, so some neurons are dead or constant, and the last input is a bias
+        NeuralNetwork net = random_feed_forward_network(rng, 4, 2, 40, 90);
+        net.m_neurons[3].m_type = BIAS;
+        for (unsigned int i = 6; i < net.m_neurons.size(); i += 3)
+        {
+            net.m_neurons[i].m_activation_function_type = LINEAR;
+        }
+        net.Compile();
+
+        OptimizationOptions options;
+        options.m_use_bias = use_bias;
+        options.m_bias_inputs_are_one = true;
+        OptimizationReport report;
+        NeuralNetwork opt = net.Optimize(options, &report);
+        dead += report.m_dead_neurons;
+        constant += report.m_constant_neurons;
+        folded += report.m_folded_neurons;
+
+        BOOST_CHECK_EQUAL(report.m_neurons_before, net.m_neurons.size());
+        BOOST_CHECK_EQUAL(report.m_neurons_after, opt.m_neurons.size());
+        BOOST_CHECK_EQUAL(report.m_connections_after, opt.m_connections.size());
+        BOOST_TEST(report.m_neurons_after < report.m_neurons_before);
+        BOOST_TEST(report.m_connections_after < report.m_connections_before);
+        BOOST_CHECK_EQUAL(opt.NumInputs(), 4u);
+        BOOST_CHECK_EQUAL(opt.NumOutputs(), 2u);
+
+        for (int s = 0; s < 5; s++)
+        {
+            std::vector<double> in = random_inputs(rng, 4);
+            in[3] = 1.0;
+
+            net.Input(in);
+            opt.Input(in);
+            if (use_bias)
+            {
+                // a feed-forward network settles after as many steps as it has neurons
+                for (unsigned int i = 0; i <= net.m_neurons.size(); i++)
+                {
+                    net.ActivateUseInternalBias();
+                    opt.ActivateUseInternalBias();
+                }
+            }
+            else
+            {
+                net.ActivateFeedForward();
+                opt.ActivateFeedForward();
+            }
+
+            std::vector<double> out = opt.Output(), expected = net.Output();
+            BOOST_TEST(std::abs(out[0] - expected[0]) < 1e-9);
+            BOOST_TEST(std::abs(out[1] - expected[1]) < 1e-9);
+        }
+    }
+
+    BOOST_TEST(dead > 0u);
+    BOOST_TEST(constant > 0u);
+    BOOST_TEST(folded > 0u);
+
+    // removing dead neurons alone is exact, step by step, with loops
+    NeuralNetwork recurrent = random_network(rng, 4, 2, 40, 90);
+    OptimizationOptions dead_only;
+    dead_only.m_propagate_constants = false;
+    dead_only.m_fold_linear = false;
+    OptimizationReport report;
+    NeuralNetwork pruned = recurrent.Optimize(dead_only, &report);
+    BOOST_TEST(report.m_dead_neurons > 0u);
+    BOOST_CHECK_EQUAL(report.m_constant_neurons + report.m_folded_neurons + report.m_weak_connections, 0u);
+
+    for (int s = 0; s < 10; s++)
+    {
+        std::vector<double> in = random_inputs(rng, 4);
+        recurrent.Input(in);
+        pruned.Input(in);
+        recurrent.Activate();
+        pruned.Activate();
+
+        std::vector<double> out = pruned.Output(), expected = recurrent.Output();
+        BOOST_TEST(out[0] == expected[0]);
+        BOOST_TEST(out[1] == expected[1]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(binary_file_round_trip)
+{
+    RNG rng;
+    rng.Seed(20);
+    NeuralNetwork net = random_network(rng, 4, 2, 30, 150);
+    net.SetStructureSignature(12345);
+    const char *filename = "binary_file_round_trip.nnb";
+    BOOST_REQUIRE(net.SaveBinary(filename));
+
+    NeuralNetwork loaded;
+    BOOST_REQUIRE(loaded.LoadBinary(filename));
+    BOOST_CHECK_EQUAL(loaded.NumInputs(), 4u);
+    BOOST_CHECK_EQUAL(loaded.NumOutputs(), 2u);
+    BOOST_CHECK_EQUAL(loaded.GetStructureSignature(), 12345u);
+    BOOST_REQUIRE_EQUAL(loaded.m_neurons.size(), net.m_neurons.size());
+    BOOST_REQUIRE_EQUAL(loaded.m_connections.size(), net.m_connections.size());
+    for (unsigned int i = 0; i < net.m_neurons.size(); i++)
+    {
+        BOOST_CHECK(loaded.m_neurons[i] == net.m_neurons[i]);
+        BOOST_CHECK_EQUAL(loaded.m_neurons[i].m_a, net.m_neurons[i].m_a);
+        BOOST_CHECK_EQUAL(loaded.m_neurons[i].m_b, net.m_neurons[i].m_b);
+        BOOST_CHECK_EQUAL(loaded.m_neurons[i].m_bias, net.m_neurons[i].m_bias);
+        BOOST_CHECK_EQUAL(loaded.m_neurons[i].m_timeconst, net.m_neurons[i].m_timeconst);
+    }
+    for (unsigned int i = 0; i < net.m_connections.size(); i++)
+    {
+        BOOST_CHECK(loaded.m_connections[i] == net.m_connections[i]);
+        BOOST_CHECK_EQUAL(loaded.m_connections[i].m_weight, net.m_connections[i].m_weight);
+        BOOST_CHECK_EQUAL(loaded.m_connections[i].m_hebb_rate, net.m_connections[i].m_hebb_rate);
+    }
+
+    // the mapped network runs on the file, and its copies share it
+    InferenceNetwork mapped;
+    BOOST_REQUIRE(mapped.LoadMapped(filename));
+    BOOST_TEST(mapped.IsMapped());
+    BOOST_CHECK_EQUAL(mapped.NumNeurons(), net.m_neurons.size());
+    InferenceNetwork copy;
+    for (int step = 0; step < 10; step++)
+    {
+        std::vector<double> in = random_inputs(rng, 4);
+        net.Input(in);
+        mapped.Input(in);
+        if (step % 2)
+        {
+            net.ActivateLeaky(0.1);
+            mapped.ActivateLeaky(0.1);
+        }
+        else
+        {
+            net.ActivateUseInternalBias();
+            mapped.ActivateUseInternalBias();
+        }
+        BOOST_CHECK(mapped.Output() == net.Output());
+
+        if (step == 5)
+        {
+            copy = mapped;
+        }
+    }
+    BOOST_TEST(copy.IsMapped());
+    copy.Flush();
+    mapped.Flush();
+    copy.Activate();
+    mapped.Activate();
+    BOOST_CHECK(copy.Output() == mapped.Output());
+
+    // rebuilding drops the file
+    copy.Build(net.m_neurons, net.m_connections, 4, 2);
+    BOOST_TEST(!copy.IsMapped());
+
+    // a damaged file is refused
+    FILE *f = fopen(filename, "r+b");
+    fseek(f, 100, SEEK_SET);
+    fputc(0x5a, f);
+    fclose(f);
+    BOOST_TEST(!loaded.LoadBinary(filename));
+    BOOST_TEST(!InferenceNetwork().LoadMapped(filename));
+    remove(filename);
+}
+
+// The ID lookups of a genome against plain scans of its genes
+void check_gene_lookups(const Genome &g)
+{
+    int max_neuron = 0, max_innov = 0;
+    for (unsigned int i = 0; i < g.NumNeurons(); i++)
+    {
+        int id = g.m_NeuronGenes[i].ID();
+        int first = -1;
+        for (unsigned int j = 0; (j < g.NumNeurons()) && (first == -1); j++)
+        {
+            if (g.m_NeuronGenes[j].ID() == id)
+            {
+                first = j;
+            }
+        }
+        BOOST_CHECK_EQUAL(g.GetNeuronIndex(id), first);
+        BOOST_CHECK_EQUAL(g.GetNeuronByID(id).ID(), id);
+        max_neuron = std::max(max_neuron, id);
+    }
+    BOOST_CHECK_EQUAL(g.GetNeuronIndex(max_neuron + 1), -1);
+
+    for (unsigned int i = 0; i < g.NumLinks(); i++)
+    {
+        const LinkGene &l = g.m_LinkGenes[i];
+        BOOST_CHECK_EQUAL(g.GetLinkIndex(l.InnovationID()), static_cast<int>(i));
+        BOOST_CHECK_EQUAL(g.GetLinkByInnovID(l.InnovationID()).InnovationID(), l.InnovationID());
+        max_innov = std::max(max_innov, l.InnovationID());
+
+        // Mutate_AddLink never adds a link that HasLink() finds
+        for (unsigned int j = 0; j < i; j++)
+        {
+            BOOST_CHECK(!((g.m_LinkGenes[j].FromNeuronID() == l.FromNeuronID()) &&
+                          (g.m_LinkGenes[j].ToNeuronID() == l.ToNeuronID())));
+        }
+    }
+    if (g.NumLinks() > 0)
+    {
+        BOOST_CHECK_EQUAL(g.GetLinkIndex(max_innov + 1), -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(gene_indexes_follow_mutations)
+{
+    RNG rng;
+    rng.Seed(21);
+    Parameters params;
+    params.RecurrentProb = 0.3;
+
+    InnovationDatabase innov;
+    Genome mom = random_genome(rng, innov, params, 3, 2, 8);
+    Genome dad = mom;
+
+    for (int trial = 0; trial < 30; trial++)
+    {
+        // lookups in between, so the indexes are built before the genes change
+        check_gene_lookups(mom);
+
+        mom.Mutate_AddNeuron(innov, params, rng);
+        mom.Mutate_AddLink(innov, params, rng);
+        check_gene_lookups(mom);
+
+        if (trial % 3 == 0)
+        {
+            mom.Mutate_RemoveLink(rng);
+        }
+        if (trial % 4 == 1)
+        {
+            mom.Mutate_RemoveSimpleNeuron(innov, rng);
+        }
+        check_gene_lookups(mom);
+
+        dad.Mutate_AddLink(innov, params, rng);
+        dad.Mutate_AddNeuron(innov, params, rng);
+
+        Genome baby = mom.Mate(dad, trial % 2 == 0, false, rng, params);
+        check_gene_lookups(baby);
+
+        // copies start from the genes, not from the indexes of the source
+        Genome copy = baby;
+        copy.SortGenes();
+        check_gene_lookups(copy);
+        copy = mom;
+        check_gene_lookups(copy);
+
+        mom = baby;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(gene_lookups_follow_edits_through_the_api)
+{
+    RNG rng;
+    rng.Seed(22);
+    Parameters params;
+
+    InnovationDatabase innov;
+    Genome g = random_genome(rng, innov, params, 3, 2, 10);
+    check_gene_lookups(g);
+
+    // appended genes are indexed without being told
+    int last_neuron = g.GetLastNeuronID(), last_innov = g.GetLastInnovationID();
+    g.m_NeuronGenes.push_back(g.m_NeuronGenes.back());
+    g.m_NeuronGenes.back().m_ID = last_neuron;
+    g.m_LinkGenes.push_back(g.m_LinkGenes.back());
+    g.m_LinkGenes.back().m_InnovationID = last_innov;
+    g.m_LinkGenes.back().m_ToNeuronID = last_neuron;
+    BOOST_CHECK_EQUAL(g.GetNeuronIndex(last_neuron), static_cast<int>(g.NumNeurons()) - 1);
+    BOOST_CHECK_EQUAL(g.GetLinkIndex(last_innov), static_cast<int>(g.NumLinks()) - 1);
+    check_gene_lookups(g);
+
+    // IDs edited in place, then announced
+    int old_neuron = g.m_NeuronGenes.back().ID(), old_innov = g.m_LinkGenes[0].InnovationID();
+    g.m_NeuronGenes.back().m_ID = last_neuron + 1;
+    g.m_LinkGenes.back().m_ToNeuronID = last_neuron + 1;
+    g.m_LinkGenes[0].m_InnovationID = last_innov + 1;
+    g.InvalidateIndexes();
+    BOOST_CHECK_EQUAL(g.GetNeuronIndex(old_neuron), -1);
+    BOOST_CHECK_EQUAL(g.GetLinkIndex(old_innov), -1);
+    BOOST_CHECK_EQUAL(g.GetLinkIndex(last_innov + 1), 0);
+    check_gene_lookups(g);
+
+    // reordered in place, then sorted back
+    std::reverse(g.m_NeuronGenes.begin(), g.m_NeuronGenes.end());
+    std::reverse(g.m_LinkGenes.begin(), g.m_LinkGenes.end());
+    g.InvalidateIndexes();
+    check_gene_lookups(g);
+    g.SortGenes();
+    check_gene_lookups(g);
+
+    // assigned a smaller and a larger genome
+    Genome small = random_genome(rng, innov, params, 3, 2, 2);
+    Genome large = random_genome(rng, innov, params, 3, 2, 20);
+    g = small;
+    check_gene_lookups(g);
+    g = large;
+    check_gene_lookups(g);
+    g = std::move(small);
+    check_gene_lookups(g);
+}
+
+// CompatibilityDistance the way it used to be computed, with maps and scans
+double reference_distance(const Genome &a, const Genome &b, const Parameters &params)
+{
+    double excess = 0, disjoint = 0, matching_links = 0, matching_neurons = 0;
+    double weight = 0, a_diff = 0, b_diff = 0, tc = 0, bias = 0, act = 0;
+    std::map<std::string, double> link_traits, neuron_traits;
+    std::map<std::string, double> genome_traits = a.m_GenomeGene.GetTraitDistances(b.m_GenomeGene.m_Traits);
+
+    unsigned int i = 0, j = 0;
+    while ((i < a.NumLinks()) || (j < b.NumLinks()))
+    {
+        if ((i == a.NumLinks()) || (j == b.NumLinks()))
+        {
+            excess++;
+            (i == a.NumLinks()) ? j++ : i++;
+        }
+        else if (a.m_LinkGenes[i].InnovationID() == b.m_LinkGenes[j].InnovationID())
+        {
+            matching_links++;
+            weight += std::fabs(a.m_LinkGenes[i].GetWeight() - b.m_LinkGenes[j].GetWeight());
+            std::map<std::string, double> d = a.m_LinkGenes[i].GetTraitDistances(b.m_LinkGenes[j].m_Traits);
+            for (auto &it : d)
+            {
+                link_traits[it.first] += it.second;
+            }
+            i++;
+            j++;
+        }
+        else
+        {
+            disjoint++;
+            (a.m_LinkGenes[i].InnovationID() < b.m_LinkGenes[j].InnovationID()) ? i++ : j++;
+        }
+    }
+
+    for (i = 0; i < a.NumNeurons(); i++)
+    {
+        const NeuronGene &n = a.m_NeuronGenes[i];
+        if ((n.Type() == INPUT) || (n.Type() == BIAS) || (b.GetNeuronIndex(n.ID()) == -1))
+        {
+            continue;
+        }
+        NeuronGene m = b.GetNeuronByID(n.ID());
+        matching_neurons++;
+        a_diff += std::fabs(n.m_A - m.m_A);
+        b_diff += std::fabs(n.m_B - m.m_B);
+        tc += std::fabs(n.m_TimeConstant - m.m_TimeConstant);
+        bias += std::fabs(n.m_Bias - m.m_Bias);
+        act += (n.m_ActFunction != m.m_ActFunction) ? 1 : 0;
+        std::map<std::string, double> d = n.GetTraitDistances(m.m_Traits);
+        for (auto &it : d)
+        {
+            neuron_traits[it.first] += it.second;
+        }
+    }
+
+    double norm = params.NormalizeGenomeSize ? std::max(a.NumLinks(), b.NumLinks()) : 1.0;
+    matching_links = std::max(matching_links, 1.0);
+    matching_neurons = std::max(matching_neurons, 1.0);
+    norm = (norm <= 0) ? 1.0 : norm;
+
+    double total = params.ExcessCoeff * (excess / norm) + params.DisjointCoeff * (disjoint / norm) +
+                   params.WeightDiffCoeff * (weight / matching_links) +
+                   params.ActivationADiffCoeff * (a_diff / matching_neurons) +
+                   params.ActivationBDiffCoeff * (b_diff / matching_neurons) +
+                   params.TimeConstantDiffCoeff * (tc / matching_neurons) +
+                   params.BiasDiffCoeff * (bias / matching_neurons) +
+                   params.ActivationFunctionDiffCoeff * (act / matching_neurons);
+    for (auto &it : link_traits)
+    {
+        total += params.LinkTraits.at(it.first).m_ImportanceCoeff * it.second / matching_links;
+    }
+    for (auto &it : neuron_traits)
+    {
+        total += params.NeuronTraits.at(it.first).m_ImportanceCoeff * it.second / matching_neurons;
+    }
+    for (auto &it : genome_traits)
+    {
+        total += params.GenomeTraits.at(it.first).m_ImportanceCoeff * it.second;
+    }
+    return total;
+}
+
+// Parameters with link, neuron and genome traits
+Parameters trait_params()
+{
+    Parameters params;
+    params.RecurrentProb = 0.3;
+    params.ActivationFunction_Tanh_Prob = 1.0;
+    params.MutateNeuronTraitsProb = 1.0;
+    params.MutateLinkTraitsProb = 1.0;
+    params.MutateGenomeTraitsProb = 1.0;
+
+    TraitParameters flt;
+    flt.type = "float";
+    flt.m_ImportanceCoeff = 0.7;
+    flt.m_MutationProb = 0.5;
+    FloatTraitParameters fd;
+    fd.min = -1.0;
+    fd.max = 1.0;
+    fd.mut_power = 0.3;
+    fd.mut_replace_prob = 0.1;
+    flt.m_Details = fd;
+    TraitParameters str;
+    str.type = "string";
+    str.m_ImportanceCoeff = 1.3;
+    str.m_MutationProb = 0.5;
+    StringTraitParameters sd;
+    sd.set.push_back("a");
+    sd.set.push_back("b");
+    sd.probs.push_back(1.0);
+    sd.probs.push_back(1.0);
+    str.m_Details = sd;
+    params.LinkTraits["w2"] = flt;
+    params.LinkTraits["kind"] = str;
+    params.NeuronTraits["kind"] = str;
+    params.NeuronTraits["gain"] = flt;
+    params.GenomeTraits["scale"] = flt;
+    return params;
+}
+
+// Genomes descending from one seed, some of them with their genes unsorted
+std::vector<Genome> genome_family(RNG &rng, InnovationDatabase &innov, const Parameters &params, int size)
+{
+    std::vector<Genome> genomes;
+    genomes.push_back(random_genome(rng, innov, params, 3, 2, 6));
+    for (int i = 1; i < size; i++)
+    {
+        Genome g = genomes[rng.RandInt(0, static_cast<int>(genomes.size()) - 1)];
+        g.Mutate_AddNeuron(innov, params, rng);
+        g.Mutate_AddLink(innov, params, rng);
+        g.Mutate_LinkWeights(params, rng);
+        g.Mutate_NeuronActivation_Type(params, rng);
+        g.Mutate_NeuronActivations_A(params, rng);
+        g.Mutate_NeuronBiases(params, rng);
+        g.Mutate_NeuronTraits(params, rng);
+        g.Mutate_LinkTraits(params, rng);
+        g.Mutate_GenomeTraits(params, rng);
+        if (i % 2)
+        {
+            g.SortGenes();
+        }
+        g.SetID(i);
+        genomes.push_back(g);
+    }
+    return genomes;
+}
+
+BOOST_AUTO_TEST_CASE(compatibility_distance_matches_reference)
+{
+    RNG rng;
+    rng.Seed(22);
+    Parameters params = trait_params();
+    InnovationDatabase innov;
+    std::vector<Genome> genomes = genome_family(rng, innov, params, 9);
+
+    for (unsigned int i = 0; i < genomes.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(genomes[i].CompatibilityDistance(genomes[i], params), 0.0);
+        for (unsigned int j = 0; j < genomes.size(); j++)
+        {
+            double d = genomes[i].CompatibilityDistance(genomes[j], params);
+            BOOST_CHECK_CLOSE(d + 1.0, reference_distance(genomes[i], genomes[j], params) + 1.0, 1e-9);
+
+            // sorted and unsorted neurons give the same distance
+            Genome shuffled = genomes[j];
+            std::reverse(shuffled.m_NeuronGenes.begin(), shuffled.m_NeuronGenes.end());
+            shuffled.InvalidateIndexes();
+            BOOST_CHECK_CLOSE(genomes[i].CompatibilityDistance(shuffled, params) + 1.0, d + 1.0, 1e-9);
+        }
+    }
+
+    // sorted genomes are compared without allocating
+    Genome a = genomes[1], b = genomes[3];
+    a.SortGenes();
+    b.SortGenes();
+    g_allocations = 0;
+    g_count_allocations = true;
+    double d = a.CompatibilityDistance(b, params);
+    g_count_allocations = false;
+    BOOST_CHECK_EQUAL(g_allocations, 0u);
+    BOOST_CHECK(d > 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(bounded_compatibility_agrees_with_full_distance)
+{
+    RNG rng;
+    rng.Seed(23);
+    Parameters params = trait_params();
+    params.NormalizeGenomeSize = true;
+    InnovationDatabase innov;
+    std::vector<Genome> genomes = genome_family(rng, innov, params, 12);
+
+    for (unsigned int i = 0; i < genomes.size(); i++)
+    {
+        for (unsigned int j = 0; j < genomes.size(); j++)
+        {
+            double full = genomes[i].CompatibilityDistance(genomes[j], params);
+            for (int k = 0; k < 8; k++)
+            {
+                double bound = full * k / 4.0;
+                double bounded = genomes[i].CompatibilityDistance(genomes[j], params, bound);
+                if (full <= bound)
+                {
+                    BOOST_CHECK_EQUAL(bounded, full);
+                }
+                else
+                {
+                    BOOST_CHECK(bounded > bound);
+                    BOOST_CHECK(bounded <= full * (1 + 1e-12));
+                }
+
+                params.CompatTreshold = bound;
+                BOOST_CHECK_EQUAL(genomes[i].IsCompatibleWith(genomes[j], params),
+                                  (i == j) || (full <= bound));
+            }
+        }
+    }
+
+    // a negative coefficient disables the bound, the answers stay the same
+    params.ActivationADiffCoeff = -0.5;
+    for (unsigned int i = 0; i < genomes.size(); i++)
+    {
+        for (unsigned int j = 0; j < genomes.size(); j++)
+        {
+            double full = genomes[i].CompatibilityDistance(genomes[j], params);
+            BOOST_CHECK_EQUAL(genomes[i].CompatibilityDistance(genomes[j], params, full / 2), full);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(trait_layouts_are_shared)
+{
+    RNG rng;
+    rng.Seed(24);
+    Parameters params = trait_params();
+    InnovationDatabase innov;
+    std::vector<Genome> genomes = genome_family(rng, innov, params, 4);
+
+    // every gene refers to the one interned layout of its parameters
+    std::shared_ptr<const TraitLayout> links = TraitLayout::Of(params.LinkTraits);
+    BOOST_CHECK(TraitLayout::Of(trait_params().LinkTraits) == links);
+    for (unsigned int i = 0; i < genomes.size(); i++)
+    {
+        for (unsigned int j = 0; j < genomes[i].NumLinks(); j++)
+        {
+            BOOST_CHECK(genomes[i].m_LinkGenes[j].m_Traits.m_Layout == links);
+        }
+        BOOST_CHECK(genomes[i].m_GenomeGene.m_Traits.m_Layout == TraitLayout::Of(params.GenomeTraits));
+    }
+    BOOST_CHECK_EQUAL(links->Slot("kind"), 0);
+    BOOST_CHECK_EQUAL(links->Slot("w2"), 1);
+    BOOST_CHECK_EQUAL(links->Slot("nope"), -1);
+
+    // a gene laid out by other parameters is matched by name
+    Parameters more = params;
+    TraitParameters extra = params.LinkTraits["w2"];
+    more.LinkTraits["a_first"] = extra;
+    LinkGene mine = genomes[0].m_LinkGenes[0];
+    LinkGene other = mine;
+    other.InitTraits(more.LinkTraits, rng);
+    BOOST_CHECK(other.m_Traits.m_Layout != mine.m_Traits.m_Layout);
+    BOOST_CHECK_EQUAL(other.m_Traits.size(), 3u);
+
+    std::map<std::string, double> by_name = other.GetTraitDistances(mine.m_Traits);
+    BOOST_CHECK_EQUAL(by_name.size(), 2u);
+    BOOST_CHECK_CLOSE(by_name["w2"] + 1.0,
+                      std::fabs(boost::get<double>(*other.m_Traits.Find("w2")) -
+                                boost::get<double>(*mine.m_Traits.Find("w2"))) + 1.0, 1e-12);
+
+    other.MateTraits(mine.m_Traits, rng);
+    BOOST_CHECK(other.m_Traits.Find("a_first") != NULL);
+
+    // mutating by other parameters leaves the traits they don't know alone
+    TraitType first = *other.m_Traits.Find("a_first");
+    for (int i = 0; i < 10; i++)
+    {
+        other.MutateTraits(params.LinkTraits, rng);
+    }
+    BOOST_CHECK(*other.m_Traits.Find("a_first") == first);
+    BOOST_CHECK_EQUAL(other.m_Traits.size(), 3u);
+
+    // the parameters keep their layouts, and notice when the traits are edited in place
+    BOOST_CHECK(&params.LinkTraitLayout() == links.get());
+    BOOST_CHECK(&more.LinkTraitLayout() == other.m_Traits.m_Layout.get());
+    more.LinkTraits.erase("a_first");
+    BOOST_CHECK(&more.LinkTraitLayout() == links.get());
+    BOOST_CHECK(TraitLayout::Of(more.NeuronTraits) == TraitLayout::Of(params.NeuronTraits));
+    BOOST_CHECK(&more.NeuronTraitLayout() == TraitLayout::Of(params.NeuronTraits).get());
+}
+
+BOOST_AUTO_TEST_CASE(genomes_move_and_species_hand_out_references)
+{
+    RNG rng;
+    rng.Seed(25);
+    Parameters params = trait_params();
+    InnovationDatabase innov;
+    std::vector<Genome> genomes = genome_family(rng, innov, params, 5);
+
+    // a moved genome takes its genes and indexes along, without allocating
+    Genome source = genomes[4];
+    check_gene_lookups(source);
+    unsigned int neurons = source.NumNeurons(), links = source.NumLinks();
+    g_allocations = 0;
+    g_count_allocations = true;
+    Genome moved(std::move(source));
+    g_count_allocations = false;
+    BOOST_CHECK_EQUAL(g_allocations, 0u);
+    BOOST_CHECK_EQUAL(moved.NumNeurons(), neurons);
+    BOOST_CHECK_EQUAL(moved.NumLinks(), links);
+    BOOST_CHECK_EQUAL(source.NumNeurons(), 0u);
+    BOOST_CHECK_EQUAL(source.NumLinks(), 0u);
+    BOOST_CHECK_EQUAL(source.GetNeuronIndex(moved.m_NeuronGenes[0].ID()), -1);
+    check_gene_lookups(moved);
+    BOOST_CHECK_EQUAL(moved.CompatibilityDistance(genomes[4], params), 0.0);
+
+    // the moved-from genome can be reused
+    source = std::move(moved);
+    check_gene_lookups(source);
+    BOOST_CHECK_EQUAL(source.NumLinks(), links);
+
+    // the accessors of a species refer to its members instead of copying them
+    Species species(genomes[0], 1);
+    for (unsigned int i = 1; i < genomes.size(); i++)
+    {
+        genomes[i].SetFitness(i);
+        species.AddIndividual(genomes[i]);
+    }
+    BOOST_CHECK(&species.GetLeader() == &species.m_Individuals.back());
+    BOOST_CHECK(&species.GetRepresentative() == &species.m_Individuals[0]);
+    BOOST_CHECK(&species.GetIndividualByIdx(2) == &species.m_Individuals[2]);
+
+    // mating takes both parents by const reference
+    const Genome &mom = species.GetIndividualByIdx(1);
+    const Genome &dad = species.GetIndividualByIdx(3);
+    Genome baby = mom.Mate(dad, true, false, rng, params);
+    check_gene_lookups(baby);
+}
+
+BOOST_AUTO_TEST_CASE(copies_keep_input_and_bias_traits)
+{
+    RNG rng;
+    rng.Seed(26);
+    Parameters params = trait_params();
+    InnovationDatabase innov;
+    Genome first = random_genome(rng, innov, params, 3, 2, 6);
+    Genome second = random_genome(rng, innov, params, 3, 2, 6);
+    for (unsigned int i = 0; i < first.NumNeurons(); i++)
+    {
+        NeuronGene &n = first.m_NeuronGenes[i];
+        n.m_Traits.m_Values[n.m_Traits.Slot("gain")] = 5.0;
+    }
+
+    // a genome assigned over another one, like the baby reused in Species::Reproduce(),
+    // gets the input and bias neurons of its source just like a copy or a move does
+    Genome assigned = first;
+    assigned = second;
+    Genome constructed(second);
+    Genome moved(std::move(Genome(second)));
+
+    unsigned int checked = 0;
+    for (unsigned int i = 0; i < second.NumNeurons(); i++)
+    {
+        const NeuronGene &n = second.m_NeuronGenes[i];
+        if ((n.Type() != INPUT) && (n.Type() != BIAS))
+        {
+            continue;
+        }
+        BOOST_CHECK(first.m_NeuronGenes[i].m_Traits.m_Values != n.m_Traits.m_Values);
+        BOOST_CHECK(assigned.m_NeuronGenes[i].m_Traits.m_Values == n.m_Traits.m_Values);
+        BOOST_CHECK(constructed.m_NeuronGenes[i].m_Traits.m_Values == n.m_Traits.m_Values);
+        BOOST_CHECK(moved.m_NeuronGenes[i].m_Traits.m_Values == n.m_Traits.m_Values);
+        BOOST_CHECK_EQUAL(assigned.m_NeuronGenes[i].m_A, n.m_A);
+        checked++;
+    }
+    BOOST_CHECK_EQUAL(checked, 3u);
+}